@@ -0,0 +1 @@
+#include "Block_ps.hlsl"
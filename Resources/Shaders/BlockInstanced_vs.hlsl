@@ -0,0 +1,35 @@
+struct Input {
+    float4 pos : POSITION0;
+    float4 normal : NORMAL0;
+    float2 uv : TEXCOORD0;
+    // Per instance, rows of the model matrix
+    float4 model0 : INSTANCE0;
+    float4 model1 : INSTANCE1;
+    float4 model2 : INSTANCE2;
+    float4 model3 : INSTANCE3;
+};
+
+cbuffer CameraData : register(b1) {
+    float4x4 View;
+    float4x4 Projection;
+};
+
+struct Output {
+    float4 pos : SV_POSITION;
+    float4 normal : NORMAL0;
+    float2 uv : TEXCOORD0;
+};
+
+Output main(Input input) {
+	Output output = (Output)0;
+
+    float4x4 model = float4x4(input.model0, input.model1, input.model2, input.model3);
+    output.pos = mul(input.pos, model);
+    output.pos = mul(output.pos, View);
+    output.pos = mul(output.pos, Projection);
+    // Instances are scaled, keep the lighting of the full size cube
+    output.normal = float4(normalize(mul(input.normal, model).xyz), 0);
+    output.uv = input.uv;
+
+	return output;
+}
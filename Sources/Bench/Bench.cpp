@@ -0,0 +1,46 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Minicraft/EntityStore.h"
+#include "Minicraft/BlockTicks.h"
+#include "Minicraft/FluidSimulation.h"
+#include "Minicraft/ExplosionSystem.h"
+#include "Minicraft/Pathfinder.h"
+#include "Minicraft/WorldServer.h"
+#include "Minicraft/WorldEditQueue.h"
+
+void BenchContext::ResetWorld() {
+	world->Generate(deviceResources, worldSeed);
+	ClearSystems();
+	pathfinder->Clear();
+	world->stats.blockEdits = 0;
+	world->stats.editHash = FNV_OFFSET_BASIS;
+}
+
+void BenchContext::ClearSystems() {
+	blockTicks->Clear();
+	fluids->Clear();
+	explosions->Clear();
+	editQueue->Clear();
+	entities->Clear();
+	server->DisconnectAll();
+}
+
+const std::vector<BenchEntry>& GetBenchmarks() {
+	static const std::vector<BenchEntry> benchmarks = {
+		{ L"-bench-edits", "minicraft_edits.txt", RunEditBenchmark },
+		{ L"-bench-voxels", "minicraft_voxels.txt", RunVoxelBenchmark },
+		{ L"-bench-collisions", "minicraft_collisions.txt", RunCollisionBenchmark },
+		{ L"-bench-entities", "minicraft_entities.txt", RunEntityBenchmark },
+		{ L"-bench-instancing", "minicraft_instancing.txt", RunInstancingBenchmark },
+		{ L"-bench-ticks", "minicraft_ticks.txt", RunBlockTickBenchmark },
+		{ L"-bench-fluids", "minicraft_fluids.txt", RunFluidBenchmark },
+		{ L"-bench-explosions", "minicraft_explosions.txt", RunExplosionBenchmark },
+		{ L"-bench-paths", "minicraft_paths.txt", RunPathfindingBenchmark },
+		{ L"-bench-server", "minicraft_server.txt", RunServerBenchmark },
+		{ L"-bench-snapshots", "minicraft_snapshots.txt", RunSnapshotBenchmark },
+		{ L"-bench-edit-queue", "minicraft_edit_queue.txt", RunEditQueueBenchmark },
+		{ L"-bench-mesher", "minicraft_mesher.txt", RunMesherBenchmark },
+	};
+	return benchmarks;
+}
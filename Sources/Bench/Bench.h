@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Engine/DeviceResources.h"
+#include "Engine/RenderCommands.h"
+#include "Minicraft/World.h"
+
+class EntityStore;
+class EntityRenderer;
+class BlockTickScheduler;
+class FluidSimulation;
+class ExplosionSystem;
+class Pathfinder;
+class WorldServer;
+class WorldEditQueue;
+
+// Linear congruential generator, seeded the same way by default so every run measures the same work
+class BenchRandom {
+	uint32_t state;
+public:
+	explicit BenchRandom(uint32_t seed = 12345) : state(seed) {}
+
+	uint32_t Next() {
+		state = state * 1664525u + 1013904223u;
+		return state;
+	}
+	// In [0, range)
+	int Range(int range) { return (int)((Next() >> 8) % (uint32_t)range); }
+	// In [0, 1)
+	float Unit() { return (Next() >> 8) / float(1 << 24); }
+};
+
+// The headless game a benchmark runs in: the world, generated, and the systems editing it
+struct BenchContext {
+	DeviceResources* deviceResources = nullptr;
+	uint32_t worldSeed = 0;
+	World* world = nullptr;
+	EntityStore* entities = nullptr;
+	EntityRenderer* entityRenderer = nullptr;
+	BlockTickScheduler* blockTicks = nullptr;
+	FluidSimulation* fluids = nullptr;
+	ExplosionSystem* explosions = nullptr;
+	Pathfinder* pathfinder = nullptr;
+	WorldServer* server = nullptr;
+	WorldEditQueue* editQueue = nullptr;
+	// Opaque block states of the world pass, plain and instanced, for benchmarks recording draws
+	RenderState blockState;
+	RenderState instancedState;
+	// Word following the benchmark name on the command line
+	std::wstring argument;
+	// Set by a benchmark whose check fails, the headless run then exits with 1
+	bool failed = false;
+
+	// Regenerates the terrain, drops everything the systems had pending and restarts the edit hash,
+	// so runs compared with each other start from the same world and hash the same edits
+	void ResetWorld();
+	// Drops the ticks, water, explosions, entities, queued edits and clients the edits of a benchmark left behind
+	void ClearSystems();
+};
+
+typedef std::string (*BenchFn)(BenchContext& context);
+
+struct BenchEntry {
+	const wchar_t* name; // "-headless <name>" runs it
+	const char* reportPath;
+	BenchFn run;
+};
+
+// Every headless benchmark, each one returns its report line
+const std::vector<BenchEntry>& GetBenchmarks();
+
+// Times the same box of block edits through UpdateBlock and through a WorldEditBatch
+std::string RunEditBenchmark(BenchContext& context);
+// ns per block read through World::GetCube, a VoxelCursor and the box iterator
+std::string RunVoxelBenchmark(BenchContext& context);
+// Cost of swept player box moves, and a check that none of them end inside a block
+std::string RunCollisionBenchmark(BenchContext& context);
+// ms per entity update tick with 10k and 100k entities, serial and on the job system
+std::string RunEntityBenchmark(BenchContext& context);
+// Recording cost and draw count of block entities drawn one cube each, then instanced
+std::string RunInstancingBenchmark(BenchContext& context);
+// ms per block tick with falling blocks and TNT, serial and on the job system, with a determinism check
+std::string RunBlockTickBenchmark(BenchContext& context);
+// A dam break on a platform, active water cells evaluated per second until the water settles
+std::string RunFluidBenchmark(BenchContext& context);
+// A chain reaction through a block of TNT, explosions and destroyed blocks per second
+std::string RunExplosionBenchmark(BenchContext& context);
+// Long distance paths per second on the hierarchical pathfinder, serial and on the job system
+std::string RunPathfindingBenchmark(BenchContext& context);
+// Simulated clients walking around a WorldServer over loopback transports, bytes per client and tick time
+std::string RunServerBenchmark(BenchContext& context);
+// Cost of chunk snapshots and of the copies they cause, then reader threads checking snapshots while chunks are rewritten
+std::string RunSnapshotBenchmark(BenchContext& context);
+// Producer threads pushing block edits into the edit queue while the main thread drains it, depth and apply rate
+std::string RunEditQueueBenchmark(BenchContext& context);
+// Binary against scalar face culling, timed on the generated chunks then compared on them and on randomly edited ones
+std::string RunMesherBenchmark(BenchContext& context);
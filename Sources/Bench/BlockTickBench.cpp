@@ -0,0 +1,70 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/JobSystem.h"
+#include "Minicraft/WorldEditBatch.h"
+#include "Minicraft/BlockTicks.h"
+#include "Minicraft/BlockBehaviours.h"
+#include "Minicraft/ExplosionSystem.h"
+
+std::string RunBlockTickBenchmark(BenchContext& context) {
+	World& world = *context.world;
+	BlockTickScheduler& blockTicks = *context.blockTicks;
+	ExplosionSystem& explosions = *context.explosions;
+	constexpr int ticks = 200;
+	constexpr int worldSize = WORLD_SIZE * CHUNK_SIZE;
+	constexpr int top = WORLD_HEIGHT * CHUNK_SIZE - 1;
+
+	// Sand pillars in the sky, TNT lit on the ground. Blocks land right away without entities,
+	// so both runs only differ by the job system.
+	auto setup = [&]() {
+		context.ResetWorld();
+		BenchRandom random;
+		WorldEditBatch batch(&world);
+		for (int i = 0; i < 2000; i++) {
+			const int x = random.Range(worldSize), z = random.Range(worldSize);
+			batch.FillBox(x, top - 4, z, x, top - 1, z, i % 2 ? SAND : GRAVEL);
+		}
+		batch.Commit();
+
+		for (int i = 0; i < 50; i++) {
+			const int x = random.Range(worldSize), z = random.Range(worldSize);
+			int y = top - 6;
+			while (y > 0 && *world.GetCube(x, y - 1, z) == EMPTY) y--;
+			world.UpdateBlock(x, y, z, TNT);
+			blockTicks.Schedule(x, y, z, TNT_FUSE_TICKS);
+		}
+	};
+	struct Run {
+		double ms = 0;
+		int scheduled = 0, random = 0, edits = 0;
+		uint32_t hash = 0;
+	};
+	auto run = [&](JobSystem* jobs) {
+		setup();
+		Run result;
+		for (int i = 0; i < ticks; i++) {
+			blockTicks.Tick(jobs);
+			explosions.Tick(jobs);
+			result.ms += blockTicks.stats.tickMs + explosions.stats.tickMs;
+			result.scheduled += blockTicks.stats.scheduledTicks;
+			result.random += blockTicks.stats.randomTicks;
+			result.edits += blockTicks.stats.edits;
+		}
+		result.ms /= ticks;
+		// Edits of this run only, the world was reset before it
+		result.hash = world.stats.editHash;
+		return result;
+	};
+
+	blockTicks.SetEntityStore(nullptr);
+	const Run serial = run(nullptr);
+	const Run parallel = run(&JobSystem::Get());
+	blockTicks.SetEntityStore(context.entities);
+
+	char report[256];
+	sprintf_s(report, "block ticks, %d ticks: serial %.3f ms, %u workers %.3f ms (%.1fx) | %d scheduled, %d random, %d edits | hash %08x %s",
+		ticks, serial.ms, JobSystem::Get().GetWorkerCount() + 1, parallel.ms, serial.ms / parallel.ms,
+		parallel.scheduled, parallel.random, parallel.edits, parallel.hash, serial.hash == parallel.hash ? "deterministic" : "MISMATCH");
+	return report;
+}
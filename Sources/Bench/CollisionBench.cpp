@@ -0,0 +1,99 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/Clock.h"
+#include "Minicraft/VoxelCollider.h"
+#include "Minicraft/WorldEditBatch.h"
+
+std::string RunCollisionBenchmark(BenchContext& context) {
+	auto& clock = DX::SystemClock::Get();
+	VoxelCollider collider(context.world);
+	constexpr int moves = 200000;
+	constexpr float worldSize = WORLD_SIZE * CHUNK_SIZE;
+
+	// Player sized boxes dropped at random places and thrown in random directions, up to 8 blocks per move
+	BenchRandom random;
+	int tunneled = 0, hits = 0, steps = 0;
+	double ms = 0;
+	for (int i = 0; i < moves; i++) {
+		const Vector3 position(8 + random.Unit() * (worldSize - 16), 2 + random.Unit() * 40, 8 + random.Unit() * (worldSize - 16));
+		CollisionBox box = { position + Vector3(-0.3f, -0.5f, -0.3f), position + Vector3(0.3f, 1.4f, 0.3f) };
+		if (collider.Overlaps(box)) continue;
+		const Vector3 delta = (Vector3(random.Unit(), random.Unit(), random.Unit()) * 2 - Vector3::One) * 8;
+
+		const uint64_t start = clock.GetCounter();
+		auto result = collider.Move(box, delta, 0.55f);
+		ms += clock.MillisecondsSince(start);
+
+		hits += result.hit[0] || result.hit[1] || result.hit[2];
+		steps += result.stepped;
+		tunneled += collider.Overlaps(box);
+	}
+
+	// Known cases on a stone floor in the sky, one lane each along X
+	const int x0 = 100, z0 = 100, floorY = 36;
+	const float feet = floorY + 0.501f;
+	constexpr float tolerance = 0.01f;
+	WorldEditBatch batch(context.world);
+	batch.FillBox(x0 - 2, floorY, z0 - 2, x0 + 24, floorY + 8, z0 + 32, EMPTY);
+	batch.FillBox(x0 - 2, floorY, z0 - 2, x0 + 24, floorY, z0 + 32, STONE);
+	// Corner: walls ahead on X and on Z
+	batch.FillBox(x0 + 2, floorY + 1, z0 - 2, x0 + 2, floorY + 2, z0 + 2, STONE);
+	batch.FillBox(x0 - 2, floorY + 1, z0 + 2, x0 + 2, floorY + 2, z0 + 2, STONE);
+	// Step up onto a half slab, not onto a full block
+	batch.Set(x0 + 1, floorY + 1, z0 + 6, HALF_SLAB);
+	batch.Set(x0 + 1, floorY + 1, z0 + 12, STONE);
+	// Ceiling right above the head
+	batch.Set(x0, floorY + 3, z0 + 18, STONE);
+	// Thin wall far ahead, crossed in a single move
+	batch.FillBox(x0 + 10, floorY + 1, z0 + 22, x0 + 10, floorY + 3, z0 + 26, STONE);
+	batch.Commit();
+
+	auto playerAt = [&](int z) {
+		return CollisionBox{ Vector3(x0 - 0.3f, feet, z - 0.3f), Vector3(x0 + 0.3f, feet + 1.8f, z + 0.3f) };
+	};
+	struct Case {
+		const char* name;
+		bool pass;
+	};
+	std::vector<Case> cases;
+	auto check = [&](const char* name, const CollisionBox& box, bool pass) {
+		cases.push_back({ name, pass && !collider.Overlaps(box) });
+	};
+
+	CollisionBox box = playerAt(z0);
+	CollisionResult result = collider.Move(box, Vector3(3, -0.01f, 3), 0.55f);
+	check("corner", box, result.hit[0] && result.hit[2] && box.max.x <= x0 + 1.5f && box.max.z <= z0 + 1.5f && box.max.x > x0 + 1.5f - tolerance);
+
+	box = playerAt(z0 + 6);
+	result = collider.Move(box, Vector3(1.5f, -0.05f, 0), 0.55f);
+	check("step-up", box, result.stepped && fabsf(box.min.y - (floorY + 1)) < tolerance && result.moved.x > 1.5f - tolerance);
+
+	box = playerAt(z0 + 12);
+	result = collider.Move(box, Vector3(1.5f, -0.05f, 0), 0.55f);
+	check("no step on a block", box, !result.stepped && result.hit[0] && box.max.x <= x0 + 0.5f);
+
+	box = playerAt(z0 + 18);
+	result = collider.Move(box, Vector3(0, 1, 0), 0.55f);
+	check("ceiling", box, result.hit[1] && !result.onGround && box.max.y <= floorY + 2.5f && box.max.y > floorY + 2.5f - tolerance);
+
+	box = playerAt(z0 + 24);
+	result = collider.Move(box, Vector3(20, 0, 0), 0.55f);
+	check("tunnelling wall", box, result.hit[0] && box.max.x <= x0 + 9.5f && box.max.x > x0 + 9.5f - tolerance);
+
+	box = playerAt(z0 + 30);
+	box.Translate(Vector3(0, 6, 0));
+	result = collider.Move(box, Vector3(0, -40, 0), 0.55f);
+	check("tunnelling floor", box, result.onGround && fabsf(box.min.y - (floorY + 0.5f)) < tolerance);
+
+	char line[160];
+	sprintf_s(line, "collisions %d moves: %.1f ns per move, %d hits, %d steps, %d ended inside a block |", moves, ms * 1e6 / moves, hits, steps, tunneled);
+	std::string report = line;
+	int failed = 0;
+	for (const Case& test : cases) {
+		report += std::string(" ") + test.name + (test.pass ? " PASS," : " FAIL,");
+		failed += !test.pass;
+	}
+	report += failed || tunneled ? " FAIL" : " PASS";
+	return report;
+}
@@ -0,0 +1,32 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/Clock.h"
+#include "Minicraft/WorldEditBatch.h"
+
+std::string RunEditBenchmark(BenchContext& context) {
+	World& world = *context.world;
+	auto& clock = DX::SystemClock::Get();
+	// Above the terrain so every edit changes a block, both passes write the same box
+	const int x0 = 8, y0 = 30, z0 = 8;
+	const int size = 64, height = 16;
+	const int edits = size * height * size;
+
+	uint64_t start = clock.GetCounter();
+	for (int z = z0; z < z0 + size; z++)
+		for (int y = y0; y < y0 + height; y++)
+			for (int x = x0; x < x0 + size; x++)
+				world.UpdateBlock(x, y, z, STONE);
+	const double singleMs = clock.MillisecondsSince(start);
+
+	start = clock.GetCounter();
+	WorldEditBatch batch(&world);
+	batch.FillBox(x0, y0, z0, x0 + size - 1, y0 + height - 1, z0 + size - 1, EMPTY);
+	const int dirtied = batch.Commit();
+	const double batchedMs = clock.MillisecondsSince(start);
+
+	char report[192];
+	sprintf_s(report, "edits %d: single %.0f /s (%.1f ms), batched %.0f /s (%.1f ms), %.1fx, %d chunks dirtied",
+		edits, edits / (singleMs / 1000.0), singleMs, edits / (batchedMs / 1000.0), batchedMs, singleMs / batchedMs, dirtied);
+	return report;
+}
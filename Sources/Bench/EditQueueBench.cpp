@@ -0,0 +1,83 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/Clock.h"
+#include "Minicraft/VoxelCursor.h"
+#include "Minicraft/WorldEditQueue.h"
+
+std::string RunEditQueueBenchmark(BenchContext& context) {
+	World& world = *context.world;
+	WorldEditQueue& editQueue = *context.editQueue;
+	auto& clock = DX::SystemClock::Get();
+	constexpr int producerCount = 4;
+	constexpr int passes = 4;
+	// Each producer rewrites its own slab of sky, so the last pass it pushed must be what the world holds
+	constexpr int slabWidth = CHUNK_SIZE, slabDepth = 4 * CHUNK_SIZE;
+	constexpr int y0 = (WORLD_HEIGHT - 1) * CHUNK_SIZE, y1 = WORLD_HEIGHT * CHUNK_SIZE - 1;
+	constexpr int slabBlocks = slabWidth * CHUNK_SIZE * slabDepth;
+	const BlockId fills[] = { STONE, BRICK, COBBLESTONE };
+
+	context.ResetWorld();
+	std::atomic<int> running = producerCount;
+	std::atomic<uint64_t> pushNs = 0;
+	std::vector<std::thread> producers;
+	for (int p = 0; p < producerCount; p++) {
+		producers.emplace_back([&, p]() {
+			const uint64_t start = clock.GetCounter();
+			BlockEdit row[slabWidth];
+			for (int pass = 0; pass < passes; pass++) {
+				const BlockId block = fills[(p + pass) % 3];
+				for (int z = 0; z < slabDepth; z++) {
+					for (int y = y0; y <= y1; y++) {
+						// Alternates single edits and whole rows
+						for (int x = 0; x < slabWidth; x++) {
+							row[x] = { p * slabWidth + x, y, z, block };
+							if (pass % 2 == 0) editQueue.Push(row[x].x, y, z, block);
+						}
+						if (pass % 2 == 1) editQueue.Push(row, slabWidth);
+					}
+				}
+			}
+			pushNs += (uint64_t)(clock.MillisecondsSince(start) * 1e6);
+			running--;
+		});
+	}
+
+	// The main thread drains like once per tick, for as long as edits come in
+	int drains = 0, peakDepth = 0, dirtied = 0;
+	uint64_t drained = 0;
+	double applyMs = 0;
+	const uint64_t start = clock.GetCounter();
+	while (running.load() > 0 || editQueue.GetDepth() > 0) {
+		editQueue.Drain();
+		if (editQueue.stats.depth == 0) {
+			std::this_thread::yield();
+			continue;
+		}
+		drains++;
+		drained += editQueue.stats.depth;
+		peakDepth = std::max(peakDepth, editQueue.stats.depth);
+		dirtied += editQueue.stats.dirtiedChunks;
+		applyMs += editQueue.stats.applyMs;
+	}
+	const double totalMs = clock.MillisecondsSince(start);
+	for (auto& producer : producers)
+		producer.join();
+
+	int mismatched = 0;
+	for (int p = 0; p < producerCount; p++) {
+		const BlockId last = fills[(p + passes - 1) % 3];
+		VoxelCursor::ForEachInBox(&world, p * slabWidth, y0, 0, p * slabWidth + slabWidth - 1, y1, slabDepth - 1, [&](int, int, int, const BlockId& block) {
+			mismatched += block != last;
+		});
+	}
+
+	const uint64_t pushed = (uint64_t)producerCount * passes * slabBlocks;
+	char report[320];
+	sprintf_s(report, "edit queue: %d producers pushed %llu edits at %.1f ns each | %d drains in %.1f ms, %.0f edits deep on average, %d at most"
+		" | applied %.2f M edits/s, %.1f chunks dirtied per drain | %llu drained, %d blocks mismatched",
+		producerCount, pushed, (double)pushNs.load() / pushed, drains, totalMs,
+		(double)drained / std::max(drains, 1), peakDepth, drained / std::max(applyMs, 1e-3) / 1000.0,
+		(double)dirtied / std::max(drains, 1), drained, mismatched);
+	return report;
+}
@@ -0,0 +1,49 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/Clock.h"
+#include "Engine/JobSystem.h"
+#include "Minicraft/EntityStore.h"
+
+std::string RunEntityBenchmark(BenchContext& context) {
+	EntityStore& entities = *context.entities;
+	auto& clock = DX::SystemClock::Get();
+	constexpr int ticks = 60;
+	constexpr float dt = 1.0f / 60.0f;
+	constexpr float worldSize = WORLD_SIZE * CHUNK_SIZE;
+
+	// Same items and mobs each run, falling blocks would edit the world between runs
+	auto spawn = [&](int count) {
+		entities.Clear();
+		BenchRandom random;
+		for (int i = 0; i < count; i++) {
+			const Vector3 position(4 + random.Unit() * (worldSize - 8), 30 + random.Unit() * 15, 4 + random.Unit() * (worldSize - 8));
+			if (i % 4 == 0)
+				entities.Spawn(ET_MOB, position, Vector3(random.Unit() * 4 - 2, 0, random.Unit() * 4 - 2), Vector3(0.3f, 0.9f, 0.3f));
+			else
+				entities.Spawn(ET_ITEM, position, Vector3(random.Unit() - 0.5f, 2, random.Unit() - 0.5f), Vector3(0.125f, 0.125f, 0.125f), DIRT);
+		}
+	};
+	auto run = [&](JobSystem* jobs) {
+		const uint64_t start = clock.GetCounter();
+		int overlaps = 0;
+		for (int i = 0; i < ticks; i++) {
+			entities.Update(context.world, dt, jobs);
+			overlaps += entities.stats.overlaps;
+		}
+		return std::make_pair(clock.MillisecondsSince(start) / ticks, overlaps / ticks);
+	};
+
+	std::string report = "entities, ms per tick:";
+	for (int count : { 10000, 100000 }) {
+		spawn(count);
+		auto serial = run(nullptr);
+		spawn(count);
+		auto parallel = run(&JobSystem::Get());
+		char line[160];
+		sprintf_s(line, " | %d: serial %.2f, %u workers %.2f (%.1fx), %d overlaps", count, serial.first,
+			JobSystem::Get().GetWorkerCount() + 1, parallel.first, serial.first / parallel.first, parallel.second);
+		report += line;
+	}
+	return report;
+}
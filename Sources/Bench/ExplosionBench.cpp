@@ -0,0 +1,61 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/JobSystem.h"
+#include "Minicraft/WorldEditBatch.h"
+#include "Minicraft/ExplosionSystem.h"
+
+std::string RunExplosionBenchmark(BenchContext& context) {
+	World& world = *context.world;
+	ExplosionSystem& explosions = *context.explosions;
+	constexpr int maxTicks = 2000;
+	constexpr int top = WORLD_HEIGHT * CHUNK_SIZE - 1;
+	// A 16x8x16 stack of TNT half buried in the terrain, lit at one corner: the chain reaction runs through it in waves
+	const int x0 = 104, z0 = 104, size = 16, height = 8;
+
+	struct Run {
+		int ticks = 0, waves = 0, maxWave = 0;
+		int explosions = 0, destroyed = 0, dirtied = 0;
+		double ms = 0, rayMs = 0;
+		uint32_t hash = 0;
+	};
+	auto run = [&](JobSystem* jobs) {
+		context.ResetWorld();
+		int surface = top;
+		while (surface > 0 && *world.GetCube(x0 + size / 2, surface, z0 + size / 2) == EMPTY) surface--;
+		const int y0 = std::min(surface - height / 2, top - height + 1);
+		WorldEditBatch batch(&world);
+		batch.FillBox(x0, y0, z0, x0 + size - 1, y0 + height - 1, z0 + size - 1, TNT);
+		batch.Commit();
+		explosions.Detonate(x0, y0, z0, TNT_POWER);
+
+		Run result;
+		while (result.ticks < maxTicks && explosions.CountPending() > 0) {
+			explosions.Tick(jobs);
+			result.ticks++;
+			if (explosions.stats.explosions == 0) continue;
+			result.waves++;
+			result.maxWave = std::max(result.maxWave, explosions.stats.explosions);
+			result.explosions += explosions.stats.explosions;
+			result.destroyed += explosions.stats.destroyed;
+			result.dirtied += explosions.stats.dirtiedChunks;
+			result.ms += explosions.stats.tickMs;
+			result.rayMs += explosions.stats.rayMs;
+		}
+		// Edits of this run only, the world was reset before it
+		result.hash = world.stats.editHash;
+		return result;
+	};
+
+	const Run serial = run(nullptr);
+	const Run parallel = run(&JobSystem::Get());
+
+	char report[384];
+	sprintf_s(report, "tnt chain: %d explosions in %d waves (largest %d) over %d ticks, %d blocks destroyed, %d chunk remeshes"
+		" | serial %.0f explosions/s %.0f blocks/s, %u workers %.0f explosions/s %.0f blocks/s (rays %.0f%% of the time) | hash %08x %s",
+		parallel.explosions, parallel.waves, parallel.maxWave, parallel.ticks, parallel.destroyed, parallel.dirtied,
+		serial.explosions * 1000.0 / serial.ms, serial.destroyed * 1000.0 / serial.ms, JobSystem::Get().GetWorkerCount() + 1,
+		parallel.explosions * 1000.0 / parallel.ms, parallel.destroyed * 1000.0 / parallel.ms, 100.0 * parallel.rayMs / parallel.ms,
+		parallel.hash, serial.hash == parallel.hash ? "deterministic" : "MISMATCH");
+	return report;
+}
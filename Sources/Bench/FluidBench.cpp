@@ -0,0 +1,63 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/JobSystem.h"
+#include "Minicraft/WorldEditBatch.h"
+#include "Minicraft/BlockTicks.h"
+#include "Minicraft/FluidSimulation.h"
+
+std::string RunFluidBenchmark(BenchContext& context) {
+	World& world = *context.world;
+	FluidSimulation& fluids = *context.fluids;
+	constexpr int maxTicks = 400;
+	// Reservoir held by a wall on a platform in the sky, water falls off the platform edge once the wall is gone
+	const int x0 = 40, x1 = 76, z0 = 40, z1 = 103, floor = 32, depth = 8, wall = 72;
+
+	struct Run {
+		int ticks = 0;
+		int64_t evaluated = 0;
+		int peakActive = 0, blockChanges = 0, levelChanges = 0, dirtied = 0;
+		double ms = 0;
+		uint32_t hash = 0;
+	};
+	auto run = [&](JobSystem* jobs) {
+		context.ResetWorld();
+		WorldEditBatch batch(&world);
+		batch.FillBox(x0 - 1, floor, z0 - 1, x1 + 1, WORLD_HEIGHT * CHUNK_SIZE - 1, z1 + 1, EMPTY);
+		batch.FillBox(x0, floor, z0, x1, floor, z1, STONE);
+		batch.FillBox(x0, floor + 1, z0, wall - 1, floor + depth, z1, WATER);
+		batch.FillBox(wall, floor + 1, z0, wall, floor + depth + 1, z1, STONE);
+		batch.Commit();
+		fluids.Clear();
+		context.blockTicks->Clear();
+
+		batch.FillBox(wall, floor + 1, z0, wall, floor + depth + 1, z1, EMPTY);
+		batch.Commit();
+
+		Run result;
+		while (result.ticks < maxTicks && fluids.CountActive() > 0) {
+			fluids.Tick(jobs);
+			result.ticks++;
+			result.evaluated += fluids.stats.activeCells;
+			result.peakActive = std::max(result.peakActive, fluids.stats.activeCells);
+			result.blockChanges += fluids.stats.blockChanges;
+			result.levelChanges += fluids.stats.levelChanges;
+			result.dirtied += fluids.stats.dirtiedChunks;
+			result.ms += fluids.stats.tickMs;
+		}
+		// Edits of this run only, the world was reset before it
+		result.hash = world.stats.editHash;
+		return result;
+	};
+
+	const Run serial = run(nullptr);
+	const Run parallel = run(&JobSystem::Get());
+
+	char report[320];
+	sprintf_s(report, "dam break: %d ticks to settle, %lld cells evaluated, peak %d active | serial %.2f M cells/s, %u workers %.2f M cells/s"
+		" | %d water changes remeshing %d chunks, %d level only changes | hash %08x %s",
+		parallel.ticks, (long long)parallel.evaluated, parallel.peakActive,
+		serial.evaluated / (serial.ms * 1000.0), JobSystem::Get().GetWorkerCount() + 1, parallel.evaluated / (parallel.ms * 1000.0),
+		parallel.blockChanges, parallel.dirtied, parallel.levelChanges, parallel.hash, serial.hash == parallel.hash ? "deterministic" : "MISMATCH");
+	return report;
+}
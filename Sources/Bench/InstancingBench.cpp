@@ -0,0 +1,63 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/Clock.h"
+#include "Engine/RenderBackends.h"
+#include "Minicraft/EntityStore.h"
+#include "Minicraft/EntityRenderer.h"
+#include "Minicraft/BlockMeshCache.h"
+
+std::string RunInstancingBenchmark(BenchContext& context) {
+	EntityStore& entities = *context.entities;
+	auto& clock = DX::SystemClock::Get();
+	constexpr int frames = 60;
+	constexpr float worldSize = WORLD_SIZE * CHUNK_SIZE;
+	const BlockId blocks[] = { DIRT, STONE, SAND, GRAVEL, WOOD, COBBLESTONE, TNT, BRICK };
+
+	RenderCommandList commands;
+	NullRenderBackend backend;
+	// One cube per entity as Cube3D draws them, then the instanced path, both recorded and executed on the null backend
+	auto run = [&](bool instanced) {
+		const uint64_t start = clock.GetCounter();
+		for (int i = 0; i < frames; i++) {
+			commands.Clear();
+			if (instanced) {
+				context.entityRenderer->BuildInstances(entities);
+				context.entityRenderer->Draw(context.deviceResources, commands, context.instancedState);
+			} else {
+				for (uint32_t e = 0; e < entities.Count(); e++) {
+					const Matrix model = Matrix::CreateScale(entities.halfExtents[e] * 2) * Matrix::CreateTranslation(entities.positions[e]);
+					commands.Add(RP_OPAQUE, context.blockState, BlockMeshCache::Get().GetGeometry(entities.blocks[e]), model);
+				}
+			}
+			commands.Sort();
+			commands.Execute(backend);
+		}
+		return clock.MillisecondsSince(start) / frames;
+	};
+
+	std::string report = "block entities, ms per frame recorded and executed:";
+	for (int count : { 1000, 10000, 100000 }) {
+		entities.Clear();
+		BenchRandom random;
+		for (int i = 0; i < count; i++) {
+			const Vector3 position(random.Unit() * worldSize, 30 + random.Unit() * 15, random.Unit() * worldSize);
+			const BlockId block = blocks[i % std::size(blocks)];
+			if (i % 2 == 0)
+				entities.Spawn(ET_ITEM, position, Vector3::Zero, Vector3(0.125f, 0.125f, 0.125f), block);
+			else
+				entities.Spawn(ET_FALLING_BLOCK, position, Vector3::Zero, Vector3(0.5f, 0.5f, 0.5f), block);
+		}
+
+		const double perCube = run(false);
+		const uint32_t cubeDraws = commands.GetStats().drawCalls;
+		const double instanced = run(true);
+		const auto& stats = commands.GetStats();
+		char line[192];
+		sprintf_s(line, " | %d: %u draws %.2f, instanced %u draws %.2f (%.1fx), %u instances%s", count,
+			cubeDraws, perCube, stats.drawCalls, instanced, perCube / instanced, stats.instances,
+			stats.instances == (uint32_t)count ? "" : " MISMATCH");
+		report += line;
+	}
+	return report;
+}
@@ -0,0 +1,77 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/Clock.h"
+#include "Minicraft/Chunk.h"
+#include "Minicraft/ChunkMesh.h"
+#include "Minicraft/ChunkSnapshot.h"
+#include "Minicraft/WorldEditBatch.h"
+
+std::string RunMesherBenchmark(BenchContext& context) {
+	World& world = *context.world;
+	auto& clock = DX::SystemClock::Get();
+	constexpr int editRounds = 2000;
+	constexpr int editsPerRound = 48;
+
+	int checked = 0, mismatched = 0;
+	auto check = [&](Chunk* chunk) {
+		if (!chunk) return;
+		ChunkSnapshot snapshot;
+		if (chunk->PrepareMesh(snapshot) != CMR_MESHED) return;
+		checked++;
+		mismatched += !ChunkMesh::ValidateBinaryCulling(snapshot);
+	};
+
+	// Both meshers over every generated chunk
+	context.ResetWorld();
+	std::vector<ChunkSnapshot> snapshots;
+	for (int cz = 0; cz < WORLD_SIZE; cz++)
+		for (int cy = 0; cy < WORLD_HEIGHT; cy++)
+			for (int cx = 0; cx < WORLD_SIZE; cx++) {
+				ChunkSnapshot snapshot;
+				if (world.GetChunk(cx, cy, cz)->PrepareMesh(snapshot) == CMR_MESHED)
+					snapshots.push_back(std::move(snapshot));
+			}
+	ChunkMesh mesh;
+	uint64_t start = clock.GetCounter();
+	for (const auto& snapshot : snapshots)
+		mesh.Build(snapshot);
+	const double binaryMs = clock.MillisecondsSince(start);
+	start = clock.GetCounter();
+	for (const auto& snapshot : snapshots)
+		mesh.BuildScalar(snapshot);
+	const double scalarMs = clock.MillisecondsSince(start);
+	for (const auto& snapshot : snapshots) {
+		checked++;
+		mismatched += !ChunkMesh::ValidateBinaryCulling(snapshot);
+	}
+	const int generatedMismatched = mismatched;
+
+	// Random blocks of every kind, water and glass included, sprinkled in one chunk at a time. Its neighbours
+	// are checked again too since their border faces depend on it.
+	BenchRandom random;
+	for (int round = 0; round < editRounds; round++) {
+		const int cx = random.Range(WORLD_SIZE), cy = random.Range(WORLD_HEIGHT), cz = random.Range(WORLD_SIZE);
+		WorldEditBatch batch(&world);
+		for (int i = 0; i < editsPerRound; i++)
+			batch.Set((cx << CHUNK_SHIFT) + random.Range(CHUNK_SIZE), (cy << CHUNK_SHIFT) + random.Range(CHUNK_SIZE),
+				(cz << CHUNK_SHIFT) + random.Range(CHUNK_SIZE), (BlockId)random.Range(HIGHLIGHT));
+		batch.Commit();
+
+		check(world.GetChunk(cx, cy, cz));
+		check(world.GetChunk(cx - 1, cy, cz));
+		check(world.GetChunk(cx + 1, cy, cz));
+		check(world.GetChunk(cx, cy - 1, cz));
+		check(world.GetChunk(cx, cy + 1, cz));
+		check(world.GetChunk(cx, cy, cz - 1));
+		check(world.GetChunk(cx, cy, cz + 1));
+	}
+
+	char report[256];
+	sprintf_s(report, "mesher: %d chunks, binary culling %.3f ms/chunk against %.3f ms/chunk scalar (%.1fx)"
+		" | %d chunk meshes compared, %d mismatched on generated chunks, %d after %d random edits | %s",
+		(int)snapshots.size(), binaryMs / snapshots.size(), scalarMs / snapshots.size(), scalarMs / binaryMs,
+		checked, generatedMismatched, mismatched - generatedMismatched, editRounds * editsPerRound, mismatched == 0 ? "PASS" : "FAIL");
+	context.failed = mismatched != 0;
+	return report;
+}
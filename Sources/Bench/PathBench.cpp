@@ -0,0 +1,92 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/Clock.h"
+#include "Engine/JobSystem.h"
+#include "Minicraft/WorldEditBatch.h"
+#include "Minicraft/Pathfinder.h"
+
+std::string RunPathfindingBenchmark(BenchContext& context) {
+	World& world = *context.world;
+	Pathfinder& pathfinder = *context.pathfinder;
+	auto& clock = DX::SystemClock::Get();
+	constexpr int queryCount = 1000;
+	constexpr int minDistance = 120;
+	constexpr int worldSize = WORLD_SIZE * CHUNK_SIZE;
+
+	context.ResetWorld();
+	pathfinder.Refresh(nullptr);
+	const double serialBuildMs = pathfinder.stats.refreshMs;
+	pathfinder.Clear();
+	pathfinder.Refresh(&JobSystem::Get());
+	const double parallelBuildMs = pathfinder.stats.refreshMs;
+
+	// Highest walkable cells of random columns, far apart
+	BenchRandom random;
+	auto ground = [&](int x, int z) {
+		PathCell cell = { x, Pathfinder::COLUMN_HEIGHT - 1, z };
+		while (cell.y >= 0 && !pathfinder.IsWalkable(cell)) cell.y--;
+		return cell;
+	};
+	std::vector<std::pair<PathCell, PathCell>> queries;
+	for (int attempt = 0; attempt < 100 * queryCount && (int)queries.size() < queryCount; attempt++) {
+		const PathCell start = ground(random.Range(worldSize), random.Range(worldSize));
+		const PathCell goal = ground(random.Range(worldSize), random.Range(worldSize));
+		if (start.y >= 0 && goal.y >= 0 && abs(start.x - goal.x) + abs(start.z - goal.z) >= minDistance)
+			queries.push_back({ start, goal });
+	}
+	const int count = (int)queries.size();
+
+	struct Run {
+		double ms = 0;
+		int found = 0;
+		int64_t cells = 0, expanded = 0, visited = 0;
+	};
+	// Each job keeps its own path, the pathfinder keeps its scratch per thread
+	auto run = [&](JobSystem* jobs) {
+		std::vector<Run> results(count);
+		auto query = [&](int begin, int end) {
+			std::vector<PathCell> path;
+			for (int i = begin; i < end; i++) {
+				PathQueryStats queryStats;
+				Run& result = results[i];
+				result.found = pathfinder.FindPath(queries[i].first, queries[i].second, path, &queryStats);
+				result.cells = (int64_t)path.size();
+				result.expanded = queryStats.expandedPortals;
+				result.visited = queryStats.visitedCells;
+			}
+		};
+		const uint64_t start = clock.GetCounter();
+		if (jobs)
+			jobs->ParallelFor(count, 16, query);
+		else
+			query(0, count);
+		Run total;
+		total.ms = clock.MillisecondsSince(start);
+		for (auto& result : results) {
+			total.found += result.found;
+			total.cells += result.cells;
+			total.expanded += result.expanded;
+			total.visited += result.visited;
+		}
+		return total;
+	};
+	const Run serial = run(nullptr);
+	const Run parallel = run(&JobSystem::Get());
+
+	// A wall through the middle of the world only rebuilds the columns it crosses
+	WorldEditBatch batch(&world);
+	batch.FillBox(worldSize / 2, 0, 0, worldSize / 2, WORLD_HEIGHT * CHUNK_SIZE - 1, worldSize - 1, STONE);
+	batch.Commit();
+	pathfinder.Refresh(&JobSystem::Get());
+
+	char report[384];
+	sprintf_s(report, "paths: %d/%d found over %d+ blocks, %.0f cells long, %.0f portals expanded and %.0f cells visited on average"
+		" | serial %.0f queries/s, %u workers %.0f queries/s %s | build %.1f ms serial, %.1f ms parallel, %d portals, wall edit %d columns %.2f ms",
+		parallel.found, count, minDistance, (double)parallel.cells / std::max(parallel.found, 1),
+		(double)parallel.expanded / count, (double)parallel.visited / count,
+		count * 1000.0 / serial.ms, JobSystem::Get().GetWorkerCount() + 1, count * 1000.0 / parallel.ms,
+		serial.cells == parallel.cells ? "same paths" : "MISMATCH", serialBuildMs, parallelBuildMs, pathfinder.stats.portals,
+		pathfinder.stats.rebuiltClusters, pathfinder.stats.refreshMs);
+	return report;
+}
@@ -0,0 +1,101 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/JobSystem.h"
+#include "Engine/Transport.h"
+#include "Minicraft/WorldEditBatch.h"
+#include "Minicraft/WorldServer.h"
+#include "Minicraft/WorldClient.h"
+
+std::string RunServerBenchmark(BenchContext& context) {
+	World& world = *context.world;
+	WorldServer& server = *context.server;
+	// "-bench-server [clients]"
+	int clientCount = _wtoi(context.argument.c_str());
+	if (clientCount <= 0) clientCount = 64;
+	constexpr int ticks = 400;
+	constexpr int ticksPerSecond = 20;
+	constexpr int viewRadius = 4;
+	constexpr int editsPerTick = 64;
+	constexpr int worldSize = WORLD_SIZE * CHUNK_SIZE;
+	constexpr int chunkCount = WORLD_SIZE * WORLD_HEIGHT * WORLD_SIZE;
+	constexpr float walkSpeed = 4.3f;
+
+	context.ResetWorld();
+	BenchRandom random;
+
+	// Clients walk straight lines across the world and bounce on its borders
+	struct SimulatedClient {
+		std::unique_ptr<WorldClient> client;
+		Vector3 position;
+		Vector3 velocity;
+	};
+	std::vector<SimulatedClient> simulated(clientCount);
+	for (auto& sim : simulated) {
+		std::unique_ptr<ITransport> serverSide, clientSide;
+		LoopbackTransport::CreatePair(serverSide, clientSide);
+		server.AddClient(std::move(serverSide));
+		sim.client = std::make_unique<WorldClient>(std::move(clientSide));
+		sim.client->Connect(viewRadius);
+		sim.position = Vector3((float)random.Range(worldSize), 40.0f, (float)random.Range(worldSize));
+		const float angle = random.Range(3600) * DirectX::XM_2PI / 3600.0f;
+		sim.velocity = Vector3(cosf(angle), 0, sinf(angle)) * walkSpeed;
+	}
+
+	double totalMs = 0, maxMs = 0;
+	uint64_t bytes = 0, lateBytes = 0, chunkBytes = 0;
+	int chunksSent = 0, deltaEdits = 0;
+	for (int tick = 0; tick < ticks; tick++) {
+		for (auto& sim : simulated) {
+			sim.position += sim.velocity / (float)ticksPerSecond;
+			if (sim.position.x < 0 || sim.position.x > worldSize - 1) sim.velocity.x = -sim.velocity.x;
+			if (sim.position.z < 0 || sim.position.z > worldSize - 1) sim.velocity.z = -sim.velocity.z;
+			sim.client->SendPosition(sim.position);
+		}
+		// Players building and digging all over the world
+		WorldEditBatch batch(&world);
+		for (int i = 0; i < editsPerTick; i++)
+			batch.Set(random.Range(worldSize), random.Range(WORLD_HEIGHT * CHUNK_SIZE), random.Range(worldSize), random.Range(2) ? STONE : EMPTY);
+		batch.Commit();
+
+		server.Tick(&JobSystem::Get());
+		totalMs += server.stats.tickMs;
+		maxMs = std::max(maxMs, server.stats.tickMs);
+		bytes += server.stats.bytesSent;
+		if (tick >= ticks / 2) lateBytes += server.stats.bytesSent;
+		chunkBytes += server.stats.chunkBytes;
+		chunksSent += server.stats.chunksSent;
+		deltaEdits += server.stats.deltaEdits;
+		for (auto& sim : simulated)
+			sim.client->Update();
+	}
+
+	// Every chunk a client holds must match the server
+	int held = 0, mismatched = 0, badMessages = 0;
+	for (auto& sim : simulated) {
+		badMessages += sim.client->stats.badMessages;
+		for (int chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++) {
+			const BlockId* blocks = sim.client->GetChunkBlocks(chunkIndex);
+			if (!blocks) continue;
+			held++;
+			const int x0 = (chunkIndex % WORLD_SIZE) * CHUNK_SIZE;
+			const int y0 = (chunkIndex / WORLD_SIZE) % WORLD_HEIGHT * CHUNK_SIZE;
+			const int z0 = chunkIndex / (WORLD_SIZE * WORLD_HEIGHT) * CHUNK_SIZE;
+			bool same = true;
+			for (int cell = 0; cell < CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE && same; cell++)
+				same = blocks[cell] == *world.GetCube(x0 + (cell & CHUNK_MASK), y0 + ((cell >> CHUNK_SHIFT) & CHUNK_MASK), z0 + (cell >> (2 * CHUNK_SHIFT)));
+			mismatched += !same;
+		}
+	}
+
+	const double seconds = (double)ticks / ticksPerSecond;
+	char report[448];
+	sprintf_s(report, "server: %d clients, view radius %d, %d ticks at %d Hz with %d edits each | tick %.3f ms average, %.3f ms max on %u workers"
+		" | %.1f KB/s per client, %.1f KB/s once streamed in | %d chunks sent at %.0f bytes (%.1fx smaller), %d delta edits"
+		" | %d chunks held, %d mismatched, %d bad messages",
+		clientCount, viewRadius, ticks, ticksPerSecond, editsPerTick, totalMs / ticks, maxMs, JobSystem::Get().GetWorkerCount() + 1,
+		bytes / 1024.0 / seconds / clientCount, lateBytes / 1024.0 / (seconds / 2) / clientCount,
+		chunksSent, (double)chunkBytes / std::max(chunksSent, 1), chunksSent * 4096.0 / std::max<uint64_t>(chunkBytes, 1), deltaEdits,
+		held, mismatched, badMessages);
+	return report;
+}
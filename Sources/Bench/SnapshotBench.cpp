@@ -0,0 +1,124 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/Clock.h"
+#include "Minicraft/Chunk.h"
+#include "Minicraft/WorldEditBatch.h"
+
+std::string RunSnapshotBenchmark(BenchContext& context) {
+	World& world = *context.world;
+	auto& clock = DX::SystemClock::Get();
+	constexpr int chunkBlocks = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+	constexpr int snapshotCount = 1000000;
+	constexpr int rewrites = 2000;
+	// Sky chunks, above the terrain
+	constexpr int skyY = (WORLD_HEIGHT - 1) * CHUNK_SIZE;
+	context.ResetWorld();
+	Chunk* chunk = world.GetChunk(0, WORLD_HEIGHT - 1, 0);
+
+	// Taking and dropping a snapshot against copying the blocks out
+	uint64_t start = clock.GetCounter();
+	volatile BlockId sink = EMPTY;
+	for (int i = 0; i < snapshotCount; i++) {
+		ChunkBlocksSnapshot snapshot = chunk->TakeSnapshot();
+		sink = snapshot.Get(i & CHUNK_MASK, 0, 0);
+	}
+	const double snapshotNs = clock.MillisecondsSince(start) * 1e6 / snapshotCount;
+	std::vector<BlockId> copy(chunkBlocks);
+	start = clock.GetCounter();
+	for (int i = 0; i < snapshotCount; i++) {
+		memcpy(copy.data(), chunk->TakeSnapshot().GetBlocks(), chunkBlocks * sizeof(BlockId));
+		sink = copy[i % chunkBlocks];
+	}
+	const double copyNs = clock.MillisecondsSince(start) * 1e6 / snapshotCount - snapshotNs;
+
+	// Rewriting a whole chunk, then with a snapshot held over each rewrite so every one of them clones
+	double editNs[2] = {};
+	uint64_t clones[2] = {};
+	for (int pass = 0; pass < 2; pass++) {
+		const uint64_t clonesBefore = Chunk::GetCloneCount();
+		ChunkBlocksSnapshot held;
+		start = clock.GetCounter();
+		for (int i = 0; i < rewrites; i++) {
+			if (pass == 1) held = chunk->TakeSnapshot();
+			WorldEditBatch batch(&world);
+			batch.FillBox(0, skyY, 0, CHUNK_SIZE - 1, skyY + CHUNK_SIZE - 1, CHUNK_SIZE - 1, i % 2 ? STONE : BRICK);
+			batch.Commit();
+		}
+		editNs[pass] = clock.MillisecondsSince(start) * 1e6 / ((double)rewrites * chunkBlocks);
+		clones[pass] = Chunk::GetCloneCount() - clonesBefore;
+	}
+
+	// Readers check the snapshots the main thread hands them while it keeps rewriting the same chunks: each one
+	// must hold the single block its chunk was filled with when it was taken, whatever came after. Readers keep
+	// their last few snapshots and check them again, so rewrites land on snapshotted chunks and clone them.
+	struct Handoff {
+		ChunkBlocksSnapshot snapshot;
+		BlockId block;
+	};
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::deque<Handoff> mailbox;
+	bool done = false;
+	std::atomic<int> checked = 0, torn = 0;
+	const int readerCount = (int)std::clamp(std::thread::hardware_concurrency(), 2u, 8u) - 1;
+	std::vector<std::thread> readers;
+	for (int r = 0; r < readerCount; r++) {
+		readers.emplace_back([&]() {
+			std::deque<Handoff> kept;
+			for (;;) {
+				Handoff handoff;
+				{
+					std::unique_lock lock(mutex);
+					ready.wait(lock, [&]() { return done || !mailbox.empty(); });
+					if (mailbox.empty()) return;
+					handoff = std::move(mailbox.front());
+					mailbox.pop_front();
+				}
+				kept.push_back(std::move(handoff));
+				if (kept.size() > 8) kept.pop_front();
+				for (const Handoff& held : kept) {
+					const BlockId* blocks = held.snapshot.GetBlocks();
+					bool same = true;
+					for (int cell = 0; cell < chunkBlocks; cell++)
+						same &= blocks[cell] == held.block;
+					torn += !same;
+					checked++;
+				}
+			}
+		});
+	}
+	const BlockId fills[] = { STONE, BRICK, COBBLESTONE };
+	constexpr int stressChunks = 2;
+	constexpr int stressRounds = 3000;
+	const uint64_t clonesBefore = Chunk::GetCloneCount();
+	start = clock.GetCounter();
+	for (int round = 0; round < stressRounds; round++) {
+		const int cx = round % stressChunks;
+		const BlockId block = fills[round % 3];
+		WorldEditBatch batch(&world);
+		batch.FillBox(cx * CHUNK_SIZE, skyY, 0, cx * CHUNK_SIZE + CHUNK_SIZE - 1, skyY + CHUNK_SIZE - 1, CHUNK_SIZE - 1, block);
+		batch.Commit();
+		{
+			std::lock_guard lock(mutex);
+			mailbox.push_back({ world.GetChunk(cx, WORLD_HEIGHT - 1, 0)->TakeSnapshot(), block });
+		}
+		ready.notify_one();
+	}
+	{
+		std::lock_guard lock(mutex);
+		done = true;
+	}
+	ready.notify_all();
+	for (auto& reader : readers)
+		reader.join();
+	const double stressMs = clock.MillisecondsSince(start);
+	const uint64_t stressClones = Chunk::GetCloneCount() - clonesBefore;
+
+	char report[384];
+	sprintf_s(report, "snapshot %.1f ns against %.1f ns for a copy | rewriting a chunk %.2f ns/block, %.2f ns/block holding snapshots (%llu and %llu clones for %d rewrites)"
+		" | stress: %d readers made %d snapshot checks over %d rewrites in %.1f ms, %llu clones, %d torn, chunk version %u",
+		snapshotNs, copyNs, editNs[0], editNs[1], clones[0], clones[1], rewrites,
+		readerCount, checked.load(), stressRounds, stressMs, stressClones, torn.load(), chunk->GetVersion());
+	return report;
+}
@@ -0,0 +1,72 @@
+#include "pch.h"
+
+#include "Bench.h"
+#include "Engine/Clock.h"
+#include "Minicraft/VoxelCursor.h"
+
+std::string RunVoxelBenchmark(BenchContext& context) {
+	World& world = *context.world;
+	auto& clock = DX::SystemClock::Get();
+	constexpr int sizeX = WORLD_SIZE * CHUNK_SIZE, sizeY = WORLD_HEIGHT * CHUNK_SIZE, sizeZ = WORLD_SIZE * CHUNK_SIZE;
+	constexpr int total = sizeX * sizeY * sizeZ;
+	// Every pass counts the solid blocks so none of them can be optimized out
+	int counts[5] = {};
+	double ms[5] = {};
+
+	uint64_t start = clock.GetCounter();
+	for (int z = 0; z < sizeZ; z++)
+		for (int y = 0; y < sizeY; y++)
+			for (int x = 0; x < sizeX; x++)
+				counts[0] += *world.GetCube(x, y, z) != EMPTY;
+	ms[0] = clock.MillisecondsSince(start);
+
+	start = clock.GetCounter();
+	VoxelCursor cursor(&world, 0, 0, 0);
+	for (int z = 0; z < sizeZ; z++)
+		for (int y = 0; y < sizeY; y++)
+			for (int x = 0; x < sizeX; x++) {
+				cursor.MoveTo(x, y, z);
+				counts[1] += *cursor.Get() != EMPTY;
+			}
+	ms[1] = clock.MillisecondsSince(start);
+
+	start = clock.GetCounter();
+	VoxelCursor::ForEachInBox(&world, 0, 0, 0, sizeX - 1, sizeY - 1, sizeZ - 1, [&](int, int, int, const BlockId& block) {
+		counts[2] += block != EMPTY;
+	});
+	ms[2] = clock.MillisecondsSince(start);
+
+	// Random walk: each access is next to the previous one, like collisions and rays
+	std::vector<std::array<int, 3>> walk(total / 4);
+	BenchRandom random;
+	int x = sizeX / 2, y = sizeY / 2, z = sizeZ / 2;
+	for (auto& cell : walk) {
+		const uint32_t bits = random.Next();
+		const int step = (bits >> 24) % 3 == 0 ? 1 : -1;
+		switch ((bits >> 16) % 3) {
+		case 0: x = std::clamp(x + step, 0, sizeX - 1); break;
+		case 1: y = std::clamp(y + step, 0, sizeY - 1); break;
+		case 2: z = std::clamp(z + step, 0, sizeZ - 1); break;
+		}
+		cell = { x, y, z };
+	}
+
+	start = clock.GetCounter();
+	for (auto& cell : walk)
+		counts[3] += *world.GetCube(cell[0], cell[1], cell[2]) != EMPTY;
+	ms[3] = clock.MillisecondsSince(start);
+
+	start = clock.GetCounter();
+	for (auto& cell : walk) {
+		cursor.MoveTo(cell[0], cell[1], cell[2]);
+		counts[4] += *cursor.Get() != EMPTY;
+	}
+	ms[4] = clock.MillisecondsSince(start);
+	assert(counts[0] == counts[1] && counts[1] == counts[2] && counts[3] == counts[4]);
+
+	auto ns = [](double ms, int accesses) { return ms * 1e6 / accesses; };
+	char report[256];
+	sprintf_s(report, "sequential %d blocks: GetCube %.2f ns, cursor %.2f ns, box iterator %.2f ns | random walk %d blocks: GetCube %.2f ns, cursor %.2f ns | solid %d",
+		total, ns(ms[0], total), ns(ms[1], total), ns(ms[2], total), (int)walk.size(), ns(ms[3], (int)walk.size()), ns(ms[4], (int)walk.size()), counts[0]);
+	return report;
+}
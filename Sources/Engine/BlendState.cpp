@@ -27,6 +27,7 @@ BlendState::BlendState(D3D11_BLEND src, D3D11_BLEND dst, D3D11_BLEND_OP op, D3D1
 }
 
 void BlendState::Create(DeviceResources* deviceRes) {
+	if (deviceRes->IsHeadless()) return;
 	auto d3dDevice = deviceRes->GetD3DDevice();
 	auto d3dContext = deviceRes->GetD3DDeviceContext();
 
@@ -34,7 +35,5 @@ void BlendState::Create(DeviceResources* deviceRes) {
 }
 
 void BlendState::Apply(DeviceResources* deviceRes) {
-	auto d3dContext = deviceRes->GetD3DDeviceContext();
-
-	d3dContext->OMSetBlendState(blendState.Get(), nullptr, 0xffffffff);
+	deviceRes->GetStateCache()->SetBlendState(blendState.Get());
 }
@@ -5,6 +5,7 @@ using Microsoft::WRL::ComPtr;
 template<typename TVertex>
 class VertexBuffer {
 	ComPtr<ID3D11Buffer> buffer;
+	size_t dynamicCapacity = 0;
 public:
 	std::vector<TVertex> data;
 	VertexBuffer() {};
@@ -22,9 +23,14 @@ public:
 		return data.size();
 	}
 
+	ID3D11Buffer* Get() const {
+		return buffer.Get();
+	}
+
 	void Create(DeviceResources* deviceRes) {
 		buffer.Reset();
-		if (data.size() == 0) return;
+		dynamicCapacity = 0;
+		if (data.size() == 0 || deviceRes->IsHeadless()) return;
 		CD3D11_BUFFER_DESC desc(
 			sizeof(TVertex) * data.size(),
 			D3D11_BIND_VERTEX_BUFFER
@@ -39,15 +45,26 @@ public:
 		);
 	}
 
+	// For data rewritten every frame: a dynamic buffer with room for data, only replaced when it must grow.
+	// Creating it only needs the device, the contents are written with RenderCommandList::AddUpload.
+	void ReserveDynamic(DeviceResources* deviceRes) {
+		if (data.size() <= dynamicCapacity || deviceRes->IsHeadless()) return;
+		dynamicCapacity = std::max(data.size(), dynamicCapacity * 2);
+		CD3D11_BUFFER_DESC desc(
+			(UINT)(sizeof(TVertex) * dynamicCapacity),
+			D3D11_BIND_VERTEX_BUFFER,
+			D3D11_USAGE_DYNAMIC,
+			D3D11_CPU_ACCESS_WRITE
+		);
+		deviceRes->GetD3DDevice()->CreateBuffer(&desc, nullptr, buffer.ReleaseAndGetAddressOf());
+	}
+
 	void UpdateBuffer(DeviceResources* deviceRes) {
 		deviceRes->GetD3DDeviceContext()->UpdateSubresource(buffer.Get(), 0, nullptr, &data, 0, 0);
 	}
 
 	void Apply(DeviceResources* deviceRes, int slot = 0) {
-		ID3D11Buffer* vbs[] = { buffer.Get() };
-		const UINT strides[] = { sizeof(TVertex) };
-		const UINT offsets[] = { 0 };
-		deviceRes->GetD3DDeviceContext()->IASetVertexBuffers(slot, 1, vbs, strides, offsets);
+		deviceRes->GetStateCache()->SetVertexBuffer(slot, buffer.Get(), sizeof(TVertex));
 	}
 };
 
@@ -71,9 +88,13 @@ public:
 		return indices.size();
 	}
 
+	ID3D11Buffer* Get() const {
+		return buffer.Get();
+	}
+
 	void Create(DeviceResources* deviceRes) {
 		buffer.Reset();
-		if (indices.size() == 0) return;
+		if (indices.size() == 0 || deviceRes->IsHeadless()) return;
 		CD3D11_BUFFER_DESC desc(
 			sizeof(uint32_t) * indices.size(),
 			D3D11_BIND_INDEX_BUFFER
@@ -89,7 +110,7 @@ public:
 	}
 
 	void Apply(DeviceResources* deviceRes) {
-		deviceRes->GetD3DDeviceContext()->IASetIndexBuffer(buffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+		deviceRes->GetStateCache()->SetIndexBuffer(buffer.Get(), DXGI_FORMAT_R32_UINT);
 	}
 };
 
@@ -102,6 +123,7 @@ public:
 	ConstantBuffer() {};
 
 	void Create(DeviceResources* deviceRes) {
+		if (deviceRes->IsHeadless()) return;
 		CD3D11_BUFFER_DESC desc(sizeof(TData), D3D11_BIND_CONSTANT_BUFFER);
 		deviceRes->GetD3DDevice()->CreateBuffer(
 			&desc, nullptr,
@@ -114,7 +136,6 @@ public:
 	}
 
 	void ApplyToVS(DeviceResources* deviceRes, int slot = 0) {
-		ID3D11Buffer* cbs[] = { buffer.Get() };
-		deviceRes->GetD3DDeviceContext()->VSSetConstantBuffers(slot, 1, cbs);
+		deviceRes->GetStateCache()->SetVSConstantBuffer(slot, buffer.Get());
 	}
 };
\ No newline at end of file
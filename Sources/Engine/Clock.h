@@ -0,0 +1,87 @@
+//
+// Clock.h - Time sources for StepTimer and the frame statistics
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+
+namespace DX
+{
+	// Monotonic counter with a fixed frequency.
+	class IClock
+	{
+	public:
+		virtual ~IClock() = default;
+
+		virtual uint64_t GetFrequency() const = 0;
+		virtual uint64_t GetCounter() const = 0;
+
+		double ToSeconds(uint64_t counts) const { return static_cast<double>(counts) / static_cast<double>(GetFrequency()); }
+		double ToMilliseconds(uint64_t counts) const { return ToSeconds(counts) * 1000.0; }
+		double MillisecondsSince(uint64_t counter) const { return ToMilliseconds(GetCounter() - counter); }
+	};
+
+	// QueryPerformanceCounter on Windows, std::chrono::steady_clock elsewhere.
+	class SystemClock final : public IClock
+	{
+	public:
+		SystemClock() noexcept(false)
+		{
+#ifdef _WIN32
+			LARGE_INTEGER frequency;
+			if (!QueryPerformanceFrequency(&frequency))
+			{
+				throw std::exception();
+			}
+			m_frequency = static_cast<uint64_t>(frequency.QuadPart);
+#else
+			m_frequency = static_cast<uint64_t>(std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num);
+#endif
+		}
+
+		uint64_t GetFrequency() const override { return m_frequency; }
+
+		uint64_t GetCounter() const override
+		{
+#ifdef _WIN32
+			LARGE_INTEGER counter;
+			if (!QueryPerformanceCounter(&counter))
+			{
+				throw std::exception();
+			}
+			return static_cast<uint64_t>(counter.QuadPart);
+#else
+			return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+		}
+
+		static SystemClock& Get()
+		{
+			static SystemClock s_clock;
+			return s_clock;
+		}
+
+	private:
+		uint64_t m_frequency;
+	};
+
+	// Clock that only moves when told to, for deterministic runs.
+	class ManualClock final : public IClock
+	{
+	public:
+		explicit ManualClock(uint64_t frequency = 10000000) noexcept : m_frequency(frequency), m_counter(0) {}
+
+		uint64_t GetFrequency() const override { return m_frequency; }
+		uint64_t GetCounter() const override { return m_counter; }
+
+		void Advance(uint64_t counts) noexcept { m_counter += counts; }
+		void AdvanceSeconds(double seconds) noexcept { m_counter += static_cast<uint64_t>(seconds * static_cast<double>(m_frequency)); }
+
+	private:
+		uint64_t m_frequency;
+		uint64_t m_counter;
+	};
+}
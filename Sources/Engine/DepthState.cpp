@@ -12,6 +12,7 @@ DepthState::DepthState(bool depthRead, bool depthWrite, D3D11_COMPARISON_FUNC fu
 }
 
 void DepthState::Create(DeviceResources* deviceRes) {
+	if (deviceRes->IsHeadless()) return;
 	auto d3dDevice = deviceRes->GetD3DDevice();
 	auto d3dContext = deviceRes->GetD3DDeviceContext();
 
@@ -19,7 +20,5 @@ void DepthState::Create(DeviceResources* deviceRes) {
 }
 
 void DepthState::Apply(DeviceResources* deviceRes) {
-	auto d3dContext = deviceRes->GetD3DDeviceContext();
-	
-	d3dContext->OMSetDepthStencilState(depthStencilState.Get(), 0);
+	deviceRes->GetStateCache()->SetDepthStencilState(depthStencilState.Get());
 }
@@ -252,6 +252,8 @@ void DeviceResources::CreateDeviceResources()
 	ThrowIfFailed(device.As(&m_d3dDevice));
 	ThrowIfFailed(context.As(&m_d3dContext));
 	ThrowIfFailed(context.As(&m_d3dAnnotation));
+
+	m_stateCache.SetContext(m_d3dContext.Get());
 }
 
 // These resources need to be recreated every time the window size is changed.
@@ -429,6 +431,7 @@ void DeviceResources::HandleDeviceLost()
 	m_renderTarget.Reset();
 	m_depthStencil.Reset();
 	m_swapChain.Reset();
+	m_stateCache.SetContext(nullptr);
 	m_d3dContext.Reset();
 	m_d3dAnnotation.Reset();
 
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "Engine/DeviceStateCache.h"
+
 // Provides an interface for an application that owns DeviceResources to be notified of the device being lost or created.
 interface IDeviceNotify
 {
@@ -50,6 +52,9 @@ public:
 	auto                    GetD3DDevice() const noexcept { return m_d3dDevice.Get(); }
 	ID3D11Debug*			GetD3DDebug() const noexcept;
 	auto                    GetD3DDeviceContext() const noexcept { return m_d3dContext.Get(); }
+	DeviceStateCache*		GetStateCache() noexcept { return &m_stateCache; }
+	// No device was created: resources keep their CPU side data and skip every D3D call.
+	bool					IsHeadless() const noexcept { return !m_d3dDevice; }
 	auto                    GetSwapChain() const noexcept { return m_swapChain.Get(); }
 	auto                    GetDXGIFactory() const noexcept { return m_dxgiFactory.Get(); }
 	HWND                    GetWindow() const noexcept { return m_window; }
@@ -92,6 +97,9 @@ private:
 	Microsoft::WRL::ComPtr<IDXGISwapChain1>             m_swapChain;
 	Microsoft::WRL::ComPtr<ID3DUserDefinedAnnotation>   m_d3dAnnotation;
 
+	// Filters redundant state changes on the immediate context.
+	DeviceStateCache									m_stateCache;
+
 	// Direct3D rendering objects. Required for 3D.
 	Microsoft::WRL::ComPtr<ID3D11Texture2D>				m_renderTarget;
 	Microsoft::WRL::ComPtr<ID3D11Texture2D>				m_depthStencil;
@@ -0,0 +1,145 @@
+//
+// DeviceStateCache.cpp - Remembers what is bound on the immediate context and skips redundant calls
+//
+
+#include "pch.h"
+#include "DeviceStateCache.h"
+
+namespace
+{
+	// Never a valid pointer, used to mark a slot as unknown.
+	template<typename T>
+	T* Unknown() noexcept { return reinterpret_cast<T*>(~uintptr_t(0)); }
+}
+
+void DeviceStateCache::SetContext(ID3D11DeviceContext1* context) noexcept
+{
+	m_context = context;
+	Invalidate();
+}
+
+void DeviceStateCache::Invalidate() noexcept
+{
+	m_blendState = Unknown<ID3D11BlendState>();
+	m_depthStencilState = Unknown<ID3D11DepthStencilState>();
+	m_vertexShader = Unknown<ID3D11VertexShader>();
+	m_pixelShader = Unknown<ID3D11PixelShader>();
+	m_inputLayout = Unknown<ID3D11InputLayout>();
+	m_topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	for (UINT i = 0; i < c_MaxVertexBuffers; i++)
+	{
+		m_vertexBuffers[i] = Unknown<ID3D11Buffer>();
+		m_vertexStrides[i] = 0;
+		m_vertexOffsets[i] = 0;
+	}
+	m_indexBuffer = Unknown<ID3D11Buffer>();
+	m_indexFormat = DXGI_FORMAT_UNKNOWN;
+	m_indexOffset = 0;
+	for (UINT i = 0; i < c_MaxConstantBuffers; i++)
+	{
+		m_vsConstantBuffers[i] = Unknown<ID3D11Buffer>();
+		m_psConstantBuffers[i] = Unknown<ID3D11Buffer>();
+	}
+	InvalidateShaderResources();
+	for (UINT i = 0; i < c_MaxSamplers; i++)
+		m_psSamplers[i] = Unknown<ID3D11SamplerState>();
+}
+
+void DeviceStateCache::InvalidateShaderResources() noexcept
+{
+	for (UINT i = 0; i < c_MaxShaderResources; i++)
+		m_psShaderResources[i] = Unknown<ID3D11ShaderResourceView>();
+}
+
+void DeviceStateCache::SetBlendState(ID3D11BlendState* state)
+{
+	if (!Changed(m_blendState != state)) return;
+	m_blendState = state;
+	m_context->OMSetBlendState(state, nullptr, 0xffffffff);
+}
+
+void DeviceStateCache::SetDepthStencilState(ID3D11DepthStencilState* state)
+{
+	if (!Changed(m_depthStencilState != state)) return;
+	m_depthStencilState = state;
+	m_context->OMSetDepthStencilState(state, 0);
+}
+
+void DeviceStateCache::SetVertexShader(ID3D11VertexShader* shader)
+{
+	if (!Changed(m_vertexShader != shader)) return;
+	m_vertexShader = shader;
+	m_context->VSSetShader(shader, nullptr, 0);
+}
+
+void DeviceStateCache::SetPixelShader(ID3D11PixelShader* shader)
+{
+	if (!Changed(m_pixelShader != shader)) return;
+	m_pixelShader = shader;
+	m_context->PSSetShader(shader, nullptr, 0);
+}
+
+void DeviceStateCache::SetInputLayout(ID3D11InputLayout* layout)
+{
+	if (!Changed(m_inputLayout != layout)) return;
+	m_inputLayout = layout;
+	m_context->IASetInputLayout(layout);
+}
+
+void DeviceStateCache::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if (!Changed(m_topology != topology)) return;
+	m_topology = topology;
+	m_context->IASetPrimitiveTopology(topology);
+}
+
+void DeviceStateCache::SetVertexBuffer(UINT slot, ID3D11Buffer* buffer, UINT stride, UINT offset)
+{
+	assert(slot < c_MaxVertexBuffers);
+	if (!Changed(m_vertexBuffers[slot] != buffer || m_vertexStrides[slot] != stride || m_vertexOffsets[slot] != offset)) return;
+	m_vertexBuffers[slot] = buffer;
+	m_vertexStrides[slot] = stride;
+	m_vertexOffsets[slot] = offset;
+	m_context->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+}
+
+void DeviceStateCache::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+{
+	if (!Changed(m_indexBuffer != buffer || m_indexFormat != format || m_indexOffset != offset)) return;
+	m_indexBuffer = buffer;
+	m_indexFormat = format;
+	m_indexOffset = offset;
+	m_context->IASetIndexBuffer(buffer, format, offset);
+}
+
+void DeviceStateCache::SetVSConstantBuffer(UINT slot, ID3D11Buffer* buffer)
+{
+	assert(slot < c_MaxConstantBuffers);
+	if (!Changed(m_vsConstantBuffers[slot] != buffer)) return;
+	m_vsConstantBuffers[slot] = buffer;
+	m_context->VSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void DeviceStateCache::SetPSConstantBuffer(UINT slot, ID3D11Buffer* buffer)
+{
+	assert(slot < c_MaxConstantBuffers);
+	if (!Changed(m_psConstantBuffers[slot] != buffer)) return;
+	m_psConstantBuffers[slot] = buffer;
+	m_context->PSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void DeviceStateCache::SetPSShaderResource(UINT slot, ID3D11ShaderResourceView* view)
+{
+	assert(slot < c_MaxShaderResources);
+	if (!Changed(m_psShaderResources[slot] != view)) return;
+	m_psShaderResources[slot] = view;
+	m_context->PSSetShaderResources(slot, 1, &view);
+}
+
+void DeviceStateCache::SetPSSampler(UINT slot, ID3D11SamplerState* sampler)
+{
+	assert(slot < c_MaxSamplers);
+	if (!Changed(m_psSamplers[slot] != sampler)) return;
+	m_psSamplers[slot] = sampler;
+	m_context->PSSetSamplers(slot, 1, &sampler);
+}
@@ -0,0 +1,74 @@
+//
+// DeviceStateCache.h - Remembers what is bound on the immediate context and skips redundant calls
+//
+
+#pragma once
+
+class DeviceStateCache
+{
+public:
+	static constexpr UINT c_MaxVertexBuffers = 4;
+	static constexpr UINT c_MaxConstantBuffers = 8;
+	static constexpr UINT c_MaxShaderResources = 8;
+	static constexpr UINT c_MaxSamplers = 4;
+
+	struct Stats
+	{
+		uint32_t issued = 0;
+		uint32_t skipped = 0;
+	};
+
+	void SetContext(ID3D11DeviceContext1* context) noexcept;
+	// Forget everything bound, for instance after something bypassed the cache or the device was recreated.
+	void Invalidate() noexcept;
+	// Binding a render target silently unbinds any view of it from the shader stages.
+	void InvalidateShaderResources() noexcept;
+
+	void SetBlendState(ID3D11BlendState* state);
+	void SetDepthStencilState(ID3D11DepthStencilState* state);
+	void SetVertexShader(ID3D11VertexShader* shader);
+	void SetPixelShader(ID3D11PixelShader* shader);
+	void SetInputLayout(ID3D11InputLayout* layout);
+	void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+	void SetVertexBuffer(UINT slot, ID3D11Buffer* buffer, UINT stride, UINT offset = 0);
+	void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset = 0);
+	void SetVSConstantBuffer(UINT slot, ID3D11Buffer* buffer);
+	void SetPSConstantBuffer(UINT slot, ID3D11Buffer* buffer);
+	void SetPSShaderResource(UINT slot, ID3D11ShaderResourceView* view);
+	void SetPSSampler(UINT slot, ID3D11SamplerState* sampler);
+
+	const Stats& GetStats() const noexcept { return m_stats; }
+	void ResetStats() noexcept { m_stats = Stats(); }
+
+private:
+	bool Changed(bool changed) noexcept
+	{
+		// Headless runs and a lost device leave no context: nothing to bind, nothing to count
+		if (!m_context) return false;
+		if (changed) m_stats.issued++;
+		else m_stats.skipped++;
+		return changed;
+	}
+
+	ID3D11DeviceContext1*		m_context = nullptr;
+	Stats						m_stats;
+
+	// Nothing bound, like a new context. SetContext then marks everything unknown, so the first call of each kind
+	// always goes through.
+	ID3D11BlendState*			m_blendState = nullptr;
+	ID3D11DepthStencilState*	m_depthStencilState = nullptr;
+	ID3D11VertexShader*			m_vertexShader = nullptr;
+	ID3D11PixelShader*			m_pixelShader = nullptr;
+	ID3D11InputLayout*			m_inputLayout = nullptr;
+	D3D11_PRIMITIVE_TOPOLOGY	m_topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	ID3D11Buffer*				m_vertexBuffers[c_MaxVertexBuffers] = {};
+	UINT						m_vertexStrides[c_MaxVertexBuffers] = {};
+	UINT						m_vertexOffsets[c_MaxVertexBuffers] = {};
+	ID3D11Buffer*				m_indexBuffer = nullptr;
+	DXGI_FORMAT					m_indexFormat = DXGI_FORMAT_UNKNOWN;
+	UINT						m_indexOffset = 0;
+	ID3D11Buffer*				m_vsConstantBuffers[c_MaxConstantBuffers] = {};
+	ID3D11Buffer*				m_psConstantBuffers[c_MaxConstantBuffers] = {};
+	ID3D11ShaderResourceView*	m_psShaderResources[c_MaxShaderResources] = {};
+	ID3D11SamplerState*			m_psSamplers[c_MaxSamplers] = {};
+};
@@ -0,0 +1,64 @@
+#include "pch.h"
+
+#include "FrameStats.h"
+
+FrameStats::FrameStats(size_t historySize) : history(historySize) {
+	assert(historySize > 0);
+}
+
+void FrameStats::AddFrame(const FrameTiming& timing) {
+	history[next] = timing;
+	next = (next + 1) % history.size();
+	count = std::min(count + 1, history.size());
+	frameCount++;
+
+	if (timing.frameMs > hitchThresholdMs) {
+		hitchCount++;
+		lastHitch = timing;
+	}
+}
+
+void FrameStats::Clear() {
+	next = 0;
+	count = 0;
+	frameCount = 0;
+	hitchCount = 0;
+	lastHitch = FrameTiming();
+}
+
+const FrameTiming& FrameStats::GetLastFrame() const {
+	return history[(next + history.size() - 1) % history.size()];
+}
+
+FramePercentiles FrameStats::GetPercentiles(double FrameTiming::* field) const {
+	FramePercentiles res;
+	if (count == 0) return res;
+
+	std::vector<double> values(count);
+	for (size_t i = 0; i < count; i++)
+		values[i] = history[i].*field;
+	std::sort(values.begin(), values.end());
+
+	auto at = [&](double percentile) { return values[std::min(count - 1, (size_t)(percentile * count))]; };
+	res.p50 = at(0.50);
+	res.p95 = at(0.95);
+	res.p99 = at(0.99);
+	res.max = values.back();
+	return res;
+}
+
+std::string FrameStats::Format() const {
+	char line[512];
+	auto frame = GetPercentiles(&FrameTiming::frameMs);
+	auto update = GetPercentiles(&FrameTiming::updateMs);
+	auto render = GetPercentiles(&FrameTiming::renderMs);
+	auto regen = GetPercentiles(&FrameTiming::regenMs);
+	auto ticks = GetPercentiles(&FrameTiming::ticks);
+	auto tick = GetPercentiles(&FrameTiming::tickMs);
+	auto latency = GetPercentiles(&FrameTiming::latencyMs);
+	snprintf(line, sizeof(line),
+		"frame p50 %.2f p95 %.2f p99 %.2f max %.2f ms | update p99 %.2f | ticks/frame p50 %.0f max %.0f, tick p99 %.2f | render p99 %.2f | regen p99 %.2f max %.2f | latency p50 %.2f p99 %.2f | hitches %llu/%llu (> %.1f ms)",
+		frame.p50, frame.p95, frame.p99, frame.max, update.p99, ticks.p50, ticks.max, tick.p99, render.p99, regen.p99, regen.max, latency.p50, latency.p99,
+		(unsigned long long)hitchCount, (unsigned long long)frameCount, hitchThresholdMs);
+	return line;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// Where the time of one frame went, in milliseconds
+struct FrameTiming {
+	double frameMs = 0;
+	double updateMs = 0;
+	double renderMs = 0;
+	double regenMs = 0; // chunk rebuilds, included in renderMs
+
+	double ticks = 0;   // fixed simulation updates run this frame, updateMs is their total
+	double tickMs = 0;  // the slowest of them
+
+	double latencyMs = 0; // from the start of the simulation shown to the end of its submission
+};
+
+struct FramePercentiles {
+	double p50 = 0;
+	double p95 = 0;
+	double p99 = 0;
+	double max = 0;
+};
+
+// Rolling history of frame timings with percentiles and hitch detection
+class FrameStats {
+	std::vector<FrameTiming> history;
+	size_t next = 0;
+	size_t count = 0;
+
+	double hitchThresholdMs = 1000.0 / 30.0;
+	uint64_t frameCount = 0;
+	uint64_t hitchCount = 0;
+	FrameTiming lastHitch;
+public:
+	FrameStats(size_t historySize = 600);
+
+	void AddFrame(const FrameTiming& timing);
+	void Clear();
+
+	void SetHitchThreshold(double ms) { hitchThresholdMs = ms; }
+	double GetHitchThreshold() const { return hitchThresholdMs; }
+	uint64_t GetHitchCount() const { return hitchCount; }
+	const FrameTiming& GetLastHitch() const { return lastHitch; }
+
+	uint64_t GetFrameCount() const { return frameCount; }
+	size_t GetHistorySize() const { return count; }
+	const FrameTiming& GetLastFrame() const;
+
+	FramePercentiles GetPercentiles(double FrameTiming::* field = &FrameTiming::frameMs) const;
+	// One line summary of frame, update, tick, render, regen and latency percentiles
+	std::string Format() const;
+};
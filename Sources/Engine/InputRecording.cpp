@@ -0,0 +1,122 @@
+#include "pch.h"
+
+#include "InputRecording.h"
+
+using namespace DirectX;
+
+namespace {
+	constexpr char RECORDING_MAGIC[4] = { 'M', 'C', 'I', 'R' };
+	constexpr uint16_t RECORDING_VERSION = 1;
+
+	enum FrameFlags : uint8_t {
+		FF_KEYBOARD = 1 << 0,
+		FF_MOVE = 1 << 1,
+		FF_WHEEL = 1 << 2,
+		FF_LEFT = 1 << 3,
+		FF_RIGHT = 1 << 4,
+		FF_MIDDLE = 1 << 5,
+	};
+
+	template<typename T>
+	void WriteValue(std::ofstream& file, const T& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	bool ReadValue(std::ifstream& file, T& value) {
+		return (bool)file.read(reinterpret_cast<char*>(&value), sizeof(T));
+	}
+}
+
+bool InputRecorder::Open(const std::filesystem::path& path, uint32_t worldSeed) {
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file) return false;
+
+	file.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+	WriteValue(file, RECORDING_VERSION);
+	WriteValue(file, (uint16_t)sizeof(Keyboard::State));
+	WriteValue(file, worldSeed);
+	lastKb = {};
+	return true;
+}
+
+void InputRecorder::Write(uint64_t dtTicks, const Keyboard::State& kb, const Mouse::State& ms) {
+	if (!file) return;
+
+	const bool kbChanged = memcmp(&kb, &lastKb, sizeof(Keyboard::State)) != 0;
+	uint8_t flags = 0;
+	if (kbChanged) flags |= FF_KEYBOARD;
+	if (ms.x != 0 || ms.y != 0) flags |= FF_MOVE;
+	if (ms.scrollWheelValue != 0) flags |= FF_WHEEL;
+	if (ms.leftButton) flags |= FF_LEFT;
+	if (ms.rightButton) flags |= FF_RIGHT;
+	if (ms.middleButton) flags |= FF_MIDDLE;
+
+	WriteValue(file, flags);
+	WriteValue(file, (uint32_t)dtTicks);
+	if (kbChanged) {
+		WriteValue(file, kb);
+		lastKb = kb;
+	}
+	if (flags & FF_MOVE) {
+		WriteValue(file, (int32_t)ms.x);
+		WriteValue(file, (int32_t)ms.y);
+	}
+	if (flags & FF_WHEEL)
+		WriteValue(file, (int32_t)ms.scrollWheelValue);
+}
+
+bool InputRecording::Load(const std::filesystem::path& path) {
+	frames.clear();
+	std::ifstream file(path, std::ios::binary);
+	if (!file) return false;
+
+	char magic[4];
+	uint16_t version, kbSize;
+	if (!file.read(magic, sizeof(magic)) || memcmp(magic, RECORDING_MAGIC, sizeof(magic)) != 0) return false;
+	if (!ReadValue(file, version) || version != RECORDING_VERSION) return false;
+	if (!ReadValue(file, kbSize) || kbSize != sizeof(Keyboard::State)) return false;
+	if (!ReadValue(file, worldSeed)) return false;
+
+	Keyboard::State kb = {};
+	uint8_t flags;
+	while (ReadValue(file, flags)) {
+		InputFrame frame;
+		uint32_t dt;
+		if (!ReadValue(file, dt)) return false;
+		frame.dtTicks = dt;
+
+		if ((flags & FF_KEYBOARD) && !ReadValue(file, kb)) return false;
+		frame.kb = kb;
+
+		frame.ms.positionMode = Mouse::MODE_RELATIVE;
+		if (flags & FF_MOVE) {
+			int32_t x, y;
+			if (!ReadValue(file, x) || !ReadValue(file, y)) return false;
+			frame.ms.x = x;
+			frame.ms.y = y;
+		}
+		if (flags & FF_WHEEL) {
+			int32_t wheel;
+			if (!ReadValue(file, wheel)) return false;
+			frame.ms.scrollWheelValue = wheel;
+		}
+		frame.ms.leftButton = (flags & FF_LEFT) != 0;
+		frame.ms.rightButton = (flags & FF_RIGHT) != 0;
+		frame.ms.middleButton = (flags & FF_MIDDLE) != 0;
+		frames.push_back(frame);
+	}
+	return true;
+}
+
+void ReplayInputSource::Poll(Keyboard::State& kb, Mouse::State& ms) {
+	if (IsFinished()) {
+		kb = {};
+		ms = {};
+		ms.positionMode = Mouse::MODE_RELATIVE;
+		return;
+	}
+	kb = recording.frames[next].kb;
+	ms = recording.frames[next].ms;
+	next++;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Engine/InputSource.h"
+
+// Input of one update, dt is in StepTimer ticks
+struct InputFrame {
+	uint64_t dtTicks = 0;
+	DirectX::Keyboard::State kb = {};
+	DirectX::Mouse::State ms = {};
+};
+
+// Writes every update's input to a compact binary file:
+// header "MCIR", version, keyboard state size, world seed,
+// then per frame a flag byte, dt, and only the parts that are set or changed.
+class InputRecorder {
+	std::ofstream file;
+	DirectX::Keyboard::State lastKb = {};
+public:
+	bool Open(const std::filesystem::path& path, uint32_t worldSeed);
+	void Write(uint64_t dtTicks, const DirectX::Keyboard::State& kb, const DirectX::Mouse::State& ms);
+	void Close() { file.close(); }
+	bool IsOpen() const { return file.is_open(); }
+};
+
+// A whole recording loaded in memory
+class InputRecording {
+public:
+	uint32_t worldSeed = 0;
+	std::vector<InputFrame> frames;
+
+	bool Load(const std::filesystem::path& path);
+};
+
+// Feeds a recording back, one frame per poll, then nothing once it is over
+class ReplayInputSource : public IInputSource {
+	const InputRecording& recording;
+	size_t next = 0;
+public:
+	ReplayInputSource(const InputRecording& recording) : recording(recording) {}
+
+	void Poll(DirectX::Keyboard::State& kb, DirectX::Mouse::State& ms) override;
+	bool IsFinished() const { return next >= recording.frames.size(); }
+};
@@ -0,0 +1,37 @@
+#include "pch.h"
+
+#include "InputSource.h"
+
+using namespace DirectX;
+
+void DeviceInputSource::Poll(Keyboard::State& kb, Mouse::State& ms) {
+	kb = keyboard->GetState();
+	ms = mouse->GetState();
+	mouse->ResetScrollWheelValue();
+}
+
+void ScriptedInputSource::Poll(Keyboard::State& kb, Mouse::State& ms) {
+	kb = {};
+	ms = {};
+	ms.positionMode = Mouse::MODE_RELATIVE;
+
+	// 4 seconds cycle at 60 ticks per second: walk forward, strafe back, then look around
+	const uint64_t phase = tick % 240;
+	if (phase < 120) {
+		kb.Z = true;
+		ms.x = 4;
+	} else if (phase < 180) {
+		kb.S = true;
+		kb.Q = true;
+		ms.y = (phase < 150) ? 3 : -3;
+	} else {
+		ms.x = -6;
+	}
+
+	kb.Space = (tick % 90) == 0;
+	ms.leftButton = (tick % 30) == 0;
+	ms.rightButton = (tick % 45) == 15;
+	if ((tick % 300) == 0) ms.scrollWheelValue = 120;
+
+	tick++;
+}
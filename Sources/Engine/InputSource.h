@@ -0,0 +1,26 @@
+#pragma once
+
+// Where the game loop gets its keyboard and mouse state from each update
+class IInputSource {
+public:
+	virtual ~IInputSource() = default;
+	virtual void Poll(DirectX::Keyboard::State& kb, DirectX::Mouse::State& ms) = 0;
+};
+
+// Reads the real devices of the window
+class DeviceInputSource : public IInputSource {
+	DirectX::Keyboard* keyboard;
+	DirectX::Mouse* mouse;
+public:
+	DeviceInputSource(DirectX::Keyboard* keyboard, DirectX::Mouse* mouse) : keyboard(keyboard), mouse(mouse) {}
+
+	void Poll(DirectX::Keyboard::State& kb, DirectX::Mouse::State& ms) override;
+};
+
+// Replays the same walk every run: moves, turns, jumps, breaks and places blocks on a fixed schedule
+class ScriptedInputSource : public IInputSource {
+	uint64_t tick = 0;
+public:
+	void Poll(DirectX::Keyboard::State& kb, DirectX::Mouse::State& ms) override;
+	void Reset() { tick = 0; }
+};
@@ -0,0 +1,82 @@
+#include "pch.h"
+
+#include "JobSystem.h"
+
+JobSystem::JobSystem(unsigned workerCount) {
+	if (workerCount == 0)
+		workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+	workerCount = std::max(1u, workerCount);
+
+	workers.reserve(workerCount);
+	for (unsigned i = 0; i < workerCount; i++)
+		workers.emplace_back([this]() { WorkerLoop(); });
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+JobSystem& JobSystem::Get() {
+	static JobSystem s_jobs;
+	return s_jobs;
+}
+
+void JobSystem::Submit(std::function<void()> fn, JobCounter* counter) {
+	if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back({ std::move(fn), counter });
+	}
+	jobAvailable.notify_one();
+	jobDone.notify_all();
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+	while (!counter.IsDone()) {
+		if (TryRunOne()) continue;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		jobDone.wait(lock, [&]() { return counter.IsDone() || !queue.empty(); });
+	}
+}
+
+void JobSystem::WorkerLoop() {
+	for (;;) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobAvailable.wait(lock, [this]() { return stopping || !queue.empty(); });
+			if (queue.empty()) return;
+			job = std::move(queue.front());
+			queue.pop_front();
+		}
+		Run(job);
+	}
+}
+
+bool JobSystem::TryRunOne() {
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (queue.empty()) return false;
+		job = std::move(queue.front());
+		queue.pop_front();
+	}
+	Run(job);
+	return true;
+}
+
+void JobSystem::Run(Job& job) {
+	job.fn();
+	if (job.counter && job.counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		// Taking the lock orders the notification after a waiter checked its predicate
+		std::lock_guard<std::mutex> lock(mutex);
+		jobDone.notify_all();
+	}
+}
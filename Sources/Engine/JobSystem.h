@@ -0,0 +1,55 @@
+#pragma once
+
+// Number of jobs of a group still queued or running
+class JobCounter {
+	std::atomic<int> pending = 0;
+	friend class JobSystem;
+public:
+	bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Fixed pool of worker threads running small jobs from a shared queue
+class JobSystem {
+	struct Job {
+		std::function<void()> fn;
+		JobCounter* counter;
+	};
+
+	std::vector<std::thread> workers;
+	std::deque<Job> queue;
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobDone;
+	bool stopping = false;
+
+	void WorkerLoop();
+	bool TryRunOne();
+	void Run(Job& job);
+public:
+	// 0 workers = one per hardware thread, minus the calling one
+	explicit JobSystem(unsigned workerCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	void Submit(std::function<void()> fn, JobCounter* counter = nullptr);
+	// Helps running queued jobs until the counter reaches 0, so it is safe to call from a job
+	void Wait(JobCounter& counter);
+
+	// Calls fn(begin, end) on ranges of at most batchSize items of [0, count), and waits for all of them
+	template<typename TFn>
+	void ParallelFor(int count, int batchSize, const TFn& fn) {
+		JobCounter counter;
+		for (int begin = 0; begin < count; begin += batchSize) {
+			const int end = std::min(begin + batchSize, count);
+			Submit([&fn, begin, end]() { fn(begin, end); }, &counter);
+		}
+		Wait(counter);
+	}
+
+	unsigned GetWorkerCount() const { return (unsigned)workers.size(); }
+
+	// Pool shared by the game systems
+	static JobSystem& Get();
+};
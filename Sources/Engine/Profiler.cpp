@@ -0,0 +1,178 @@
+#include "pch.h"
+
+#include "Profiler.h"
+
+std::atomic<bool> Profiler::enabled = false;
+
+namespace {
+	struct ProfileEvent {
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	// Single producer ring: only the owning thread writes, readers copy the events published so far and then drop
+	// whatever the writer may have overwritten while they were reading. Slots are relaxed atomics so a torn read is
+	// only ever thrown away, never a data race.
+	struct ThreadBuffer {
+		static constexpr uint64_t CAPACITY = 1 << 16;
+
+		struct Slot {
+			std::atomic<const char*> name;
+			std::atomic<uint64_t> start;
+			std::atomic<uint64_t> end;
+		};
+		Slot events[CAPACITY];
+		std::atomic<uint64_t> written = 0;
+		// Set when the owning thread exits, the next thread to start takes the buffer over
+		std::atomic<bool> exited = false;
+		uint32_t threadId = 0;
+
+		void Push(const ProfileEvent& e) {
+			uint64_t idx = written.load(std::memory_order_relaxed);
+			// A reader seeing any of these stores then sees idx too, so it knows the slot is being rewritten
+			std::atomic_thread_fence(std::memory_order_release);
+			Slot& slot = events[idx & (CAPACITY - 1)];
+			slot.name.store(e.name, std::memory_order_relaxed);
+			slot.start.store(e.start, std::memory_order_relaxed);
+			slot.end.store(e.end, std::memory_order_relaxed);
+			written.store(idx + 1, std::memory_order_release);
+		}
+
+		void CopyTo(std::vector<ProfileEvent>& out) const {
+			uint64_t end = written.load(std::memory_order_acquire);
+			uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+			size_t first = out.size();
+			for (uint64_t idx = begin; idx < end; idx++) {
+				const Slot& slot = events[idx & (CAPACITY - 1)];
+				out.push_back({ slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed), slot.end.load(std::memory_order_relaxed) });
+			}
+
+			// The event after the last published one may be half written over the oldest slot
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t after = written.load(std::memory_order_relaxed) + 1;
+			uint64_t overwritten = after > CAPACITY ? after - CAPACITY : 0;
+			if (overwritten > begin)
+				out.erase(out.begin() + first, out.begin() + first + (size_t)std::min(overwritten - begin, end - begin));
+		}
+	};
+
+	std::mutex registryMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> registry;
+	uint64_t clearedBefore = 0;
+
+	// Marks the buffer of a thread as free when the thread exits
+	struct ThreadBufferOwner {
+		ThreadBuffer* buffer = nullptr;
+		~ThreadBufferOwner() {
+			if (buffer) buffer->exited.store(true, std::memory_order_release);
+		}
+	};
+
+	ThreadBuffer* GetThreadBuffer() {
+		thread_local ThreadBufferOwner owner;
+		if (!owner.buffer) {
+			std::lock_guard<std::mutex> lock(registryMutex);
+			// The events of exited threads are dropped and their buffer reused, so short lived threads don't pile buffers up
+			for (auto& buffer : registry) {
+				if (!buffer->exited.load(std::memory_order_acquire)) continue;
+				buffer->written.store(0, std::memory_order_relaxed);
+				buffer->exited.store(false, std::memory_order_relaxed);
+				owner.buffer = buffer.get();
+				break;
+			}
+			if (!owner.buffer) {
+				auto owned = std::make_unique<ThreadBuffer>();
+				owned->threadId = (uint32_t)registry.size();
+				owner.buffer = owned.get();
+				registry.push_back(std::move(owned));
+			}
+		}
+		return owner.buffer;
+	}
+
+	template<typename TVisit>
+	void ForEachBuffer(TVisit&& visit) {
+		std::lock_guard<std::mutex> lock(registryMutex);
+		std::vector<ProfileEvent> events;
+		for (auto& buffer : registry) {
+			events.clear();
+			buffer->CopyTo(events);
+			events.erase(std::remove_if(events.begin(), events.end(), [](const ProfileEvent& e) { return e.start < clearedBefore; }), events.end());
+			visit(*buffer, events);
+		}
+	}
+}
+
+uint64_t Profiler::Now() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::Record(const char* name, uint64_t start, uint64_t end) {
+	GetThreadBuffer()->Push({ name, start, end });
+}
+
+void Profiler::Clear() {
+	std::lock_guard<std::mutex> lock(registryMutex);
+	clearedBefore = Now();
+}
+
+std::vector<ProfileZoneStats> Profiler::GetZoneStats() {
+	// Zones are keyed by name, the same literal may live at different addresses in different files
+	std::map<std::string, std::vector<ProfileEvent>> zones;
+	ForEachBuffer([&](const ThreadBuffer&, const std::vector<ProfileEvent>& events) {
+		for (auto& e : events)
+			zones[e.name].push_back(e);
+	});
+
+	std::vector<ProfileZoneStats> res;
+	std::vector<double> durations;
+	for (auto& [name, events] : zones) {
+		std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b) { return a.end < b.end; });
+		size_t first = events.size() > STATS_WINDOW ? events.size() - STATS_WINDOW : 0;
+
+		durations.clear();
+		for (size_t i = first; i < events.size(); i++)
+			durations.push_back((events[i].end - events[i].start) / 1000000.0);
+		std::sort(durations.begin(), durations.end());
+
+		ProfileZoneStats stats;
+		stats.name = name;
+		stats.samples = (uint32_t)durations.size();
+		stats.minMs = durations.front();
+		stats.avgMs = std::accumulate(durations.begin(), durations.end(), 0.0) / durations.size();
+		stats.p99Ms = durations[std::min(durations.size() - 1, (size_t)(durations.size() * 0.99))];
+		res.push_back(stats);
+	}
+	return res;
+}
+
+bool Profiler::ExportChromeTrace(const std::string& path) {
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file) return false;
+
+	uint64_t origin = UINT64_MAX;
+	ForEachBuffer([&](const ThreadBuffer&, const std::vector<ProfileEvent>& events) {
+		for (auto& e : events)
+			origin = std::min(origin, e.start);
+	});
+
+	file << "{\"traceEvents\":[\n";
+	bool first = true;
+	char line[512];
+	ForEachBuffer([&](const ThreadBuffer& buffer, const std::vector<ProfileEvent>& events) {
+		for (auto& e : events) {
+			std::string name;
+			for (const char* c = e.name; *c; c++) {
+				if (*c == '"' || *c == '\\') name += '\\';
+				name += *c;
+			}
+			snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				first ? "" : ",\n", name.c_str(), buffer.threadId, (e.start - origin) / 1000.0, (e.end - e.start) / 1000.0);
+			file << line;
+			first = false;
+		}
+	});
+	file << "\n]}\n";
+	return (bool)file;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Set to 0 to compile every PROFILE_ZONE out
+#ifndef MINICRAFT_PROFILER
+#define MINICRAFT_PROFILER 1
+#endif
+
+struct ProfileZoneStats {
+	std::string name;
+	uint32_t samples;
+	double minMs;
+	double avgMs;
+	double p99Ms;
+};
+
+// CPU instrumentation: scoped zones are written to a ring buffer owned by the calling thread,
+// so recording never takes a lock. When disabled at runtime a zone costs one relaxed atomic load.
+class Profiler {
+	static std::atomic<bool> enabled;
+public:
+	// Number of most recent samples per zone used by GetZoneStats
+	static constexpr size_t STATS_WINDOW = 256;
+
+	static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+	static void SetEnabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+
+	static uint64_t Now();
+	static void Record(const char* name, uint64_t start, uint64_t end);
+	static void Clear();
+
+	static std::vector<ProfileZoneStats> GetZoneStats();
+	// Chrome trace event format, loads in chrome://tracing and ui.perfetto.dev
+	static bool ExportChromeTrace(const std::string& path);
+};
+
+class ProfileZone {
+	const char* name;
+	uint64_t start;
+public:
+	ProfileZone(const char* name) : name(name), start(Profiler::IsEnabled() ? Profiler::Now() : 0) {}
+	~ProfileZone() {
+		if (start) Profiler::Record(name, start, Profiler::Now());
+	}
+};
+
+#if MINICRAFT_PROFILER
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
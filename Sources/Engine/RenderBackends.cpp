@@ -0,0 +1,72 @@
+#include "pch.h"
+
+#include "RenderBackends.h"
+#include "DefaultResources.h"
+
+void D3D11RenderBackend::BeginFrame() {
+	DefaultResources::Get()->cbModel.ApplyToVS(deviceRes, 0);
+}
+
+void D3D11RenderBackend::Upload(ID3D11Buffer* buffer, const void* data, size_t size) {
+	// Discarding hands back fresh memory, the draws of earlier frames keep reading the old contents
+	auto context = deviceRes->GetD3DDeviceContext();
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	if (FAILED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+	memcpy(mapped.pData, data, size);
+	context->Unmap(buffer, 0);
+}
+
+void D3D11RenderBackend::BindCamera(Camera* camera) {
+	camera->ApplyCamera(deviceRes);
+}
+
+void D3D11RenderBackend::BindShader(Shader* shader) {
+	shader->Apply(deviceRes);
+}
+
+void D3D11RenderBackend::BindInputLayout(InputLayoutFn inputLayout) {
+	inputLayout(deviceRes);
+}
+
+void D3D11RenderBackend::BindBlend(BlendState* blend) {
+	blend->Apply(deviceRes);
+}
+
+void D3D11RenderBackend::BindDepth(DepthState* depth) {
+	depth->Apply(deviceRes);
+}
+
+void D3D11RenderBackend::BindTexture(Texture* texture) {
+	texture->Apply(deviceRes);
+}
+
+void D3D11RenderBackend::BindTopology(D3D11_PRIMITIVE_TOPOLOGY topology) {
+	deviceRes->GetStateCache()->SetPrimitiveTopology(topology);
+}
+
+void D3D11RenderBackend::SetModel(const Matrix& model) {
+	auto& cbModel = DefaultResources::Get()->cbModel;
+	cbModel.data.model = model.Transpose();
+	cbModel.UpdateBuffer(deviceRes);
+}
+
+void D3D11RenderBackend::Draw(const RenderGeometry& geometry) {
+	auto context = deviceRes->GetD3DDeviceContext();
+	auto stateCache = deviceRes->GetStateCache();
+
+	stateCache->SetVertexBuffer(0, geometry.vertexBuffer, geometry.stride);
+	if (geometry.indexBuffer)
+		stateCache->SetIndexBuffer(geometry.indexBuffer, DXGI_FORMAT_R32_UINT);
+
+	if (geometry.instanceStride) {
+		stateCache->SetVertexBuffer(1, geometry.instanceBuffer, geometry.instanceStride);
+		if (geometry.indexBuffer)
+			context->DrawIndexedInstanced(geometry.count, geometry.instanceCount, geometry.start, 0, geometry.firstInstance);
+		else
+			context->DrawInstanced(geometry.count, geometry.instanceCount, geometry.start, geometry.firstInstance);
+	} else if (geometry.indexBuffer) {
+		context->DrawIndexed(geometry.count, geometry.start, 0);
+	} else {
+		context->Draw(geometry.count, geometry.start);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Engine/RenderCommands.h"
+
+// Executes render commands on the D3D11 device context
+class D3D11RenderBackend : public IRenderBackend {
+	DeviceResources* deviceRes;
+public:
+	D3D11RenderBackend(DeviceResources* deviceRes) : deviceRes(deviceRes) {}
+
+	void BeginFrame() override;
+	void Upload(ID3D11Buffer* buffer, const void* data, size_t size) override;
+	void BindCamera(Camera* camera) override;
+	void BindShader(Shader* shader) override;
+	void BindInputLayout(InputLayoutFn inputLayout) override;
+	void BindBlend(BlendState* blend) override;
+	void BindDepth(DepthState* depth) override;
+	void BindTexture(Texture* texture) override;
+	void BindTopology(D3D11_PRIMITIVE_TOPOLOGY topology) override;
+	void SetModel(const Matrix& model) override;
+	void Draw(const RenderGeometry& geometry) override;
+};
+
+// Drops every command, only counts primitives, so frames can be recorded and profiled without a GPU
+class NullRenderBackend : public IRenderBackend {
+public:
+	uint64_t binds = 0;
+	uint64_t draws = 0;
+	uint64_t primitives = 0;
+
+	void BindCamera(Camera*) override { binds++; }
+	void BindShader(Shader*) override { binds++; }
+	void BindInputLayout(InputLayoutFn) override { binds++; }
+	void BindBlend(BlendState*) override { binds++; }
+	void BindDepth(DepthState*) override { binds++; }
+	void BindTexture(Texture*) override { binds++; }
+	void BindTopology(D3D11_PRIMITIVE_TOPOLOGY) override { binds++; }
+	void SetModel(const Matrix&) override { binds++; }
+	void Draw(const RenderGeometry& geometry) override {
+		draws++;
+		uint64_t perInstance = geometry.topology == D3D11_PRIMITIVE_TOPOLOGY_LINELIST ? geometry.count / 2 : geometry.count / 3;
+		primitives += perInstance * (geometry.instanceStride ? geometry.instanceCount : 1);
+	}
+};
@@ -0,0 +1,133 @@
+#include "pch.h"
+
+#include "RenderCommands.h"
+
+namespace {
+	// Key layout, from the most significant bit:
+	// pass (3) | camera (6) | shader (6) | input layout (4) | depth state (4) | blend (3) | texture (6) | order (32)
+	// where order is the view depth for the opaque and transparent passes and the submission index otherwise.
+	constexpr int PASS_SHIFT = 61;
+
+	// Width and position of each state field of the key, in KeyField order
+	struct KeyFieldLayout {
+		int bits;
+		int shift;
+	};
+	constexpr KeyFieldLayout KEY_FIELDS[] = { { 6, 55 }, { 6, 49 }, { 4, 45 }, { 4, 41 }, { 3, 38 }, { 6, 32 } };
+
+	uint32_t DepthBits(float viewDepth) {
+		// Positive floats compare like their bit patterns
+		float depth = std::max(viewDepth, 0.0f);
+		uint32_t bits;
+		memcpy(&bits, &depth, sizeof(bits));
+		return bits;
+	}
+}
+
+uint64_t RenderCommandList::GetResourceId(KeyField field, const void* resource) {
+	auto& ids = resourceIds[field];
+	const auto [it, added] = ids.try_emplace(resource, (uint32_t)ids.size());
+	const KeyFieldLayout& layout = KEY_FIELDS[field];
+	// More distinct resources of one kind in a frame than its field holds: draws would be grouped wrongly
+	assert(it->second < (1u << layout.bits));
+	return (uint64_t)(it->second & ((1u << layout.bits) - 1)) << layout.shift;
+}
+
+uint64_t RenderCommandList::MakeSortKey(RenderPass pass, const RenderState& state, float viewDepth) {
+	uint64_t key = (uint64_t)pass << PASS_SHIFT;
+	switch (pass) {
+	case RP_OPAQUE:
+		key |= GetResourceId(KF_CAMERA, state.camera);
+		key |= GetResourceId(KF_SHADER, state.shader);
+		key |= GetResourceId(KF_INPUT_LAYOUT, (const void*)state.inputLayout);
+		key |= GetResourceId(KF_DEPTH, state.depth);
+		key |= GetResourceId(KF_BLEND, state.blend);
+		key |= GetResourceId(KF_TEXTURE, state.texture);
+		key |= DepthBits(viewDepth);
+		break;
+	case RP_TRANSPARENT:
+		key |= (uint32_t)~DepthBits(viewDepth);
+		break;
+	default:
+		key |= sequence;
+		break;
+	}
+	return key;
+}
+
+void RenderCommandList::Clear() {
+	items.clear();
+	for (auto& ids : resourceIds)
+		ids.clear();
+	retained.clear();
+	uploads.clear();
+	uploadData.clear();
+	sequence = 0;
+	stats = RenderStats();
+}
+
+void RenderCommandList::Add(RenderPass pass, const RenderState& state, const RenderGeometry& geometry, const Matrix& model, float viewDepth) {
+	assert(state.camera && state.shader && state.inputLayout && state.blend && state.depth && state.texture);
+	if (geometry.count == 0 || geometry.instanceCount == 0) return;
+
+	items.push_back({ MakeSortKey(pass, state, viewDepth), state, geometry, model });
+	if (geometry.vertexBuffer) retained.emplace_back(geometry.vertexBuffer);
+	if (geometry.indexBuffer) retained.emplace_back(geometry.indexBuffer);
+	if (geometry.instanceBuffer) retained.emplace_back(geometry.instanceBuffer);
+	sequence++;
+}
+
+void RenderCommandList::AddUpload(ID3D11Buffer* buffer, const void* data, size_t size) {
+	if (!buffer || size == 0) return;
+	const size_t offset = uploadData.size();
+	uploadData.resize(offset + size);
+	memcpy(uploadData.data() + offset, data, size);
+	uploads.push_back({ buffer, offset, size });
+	retained.emplace_back(buffer);
+}
+
+void RenderCommandList::Sort() {
+	std::stable_sort(items.begin(), items.end(), [](const RenderItem& a, const RenderItem& b) { return a.sortKey < b.sortKey; });
+}
+
+void RenderCommandList::Execute(IRenderBackend& backend) {
+	stats.items = (uint32_t)items.size();
+	backend.BeginFrame();
+	for (auto& upload : uploads)
+		backend.Upload(upload.buffer, uploadData.data() + upload.offset, upload.size);
+
+	RenderState bound;
+	D3D11_PRIMITIVE_TOPOLOGY boundTopology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	const Matrix* boundModel = nullptr;
+
+	auto bind = [&](auto& current, auto next, auto&& apply) {
+		if (current == next) {
+			stats.redundantBinds++;
+			return;
+		}
+		current = next;
+		apply(next);
+		stats.stateChanges++;
+	};
+
+	for (auto& item : items) {
+		auto& state = item.state;
+		bind(bound.camera, state.camera, [&](Camera* c) { backend.BindCamera(c); stats.cbUpdates++; });
+		bind(bound.shader, state.shader, [&](Shader* s) { backend.BindShader(s); });
+		bind(bound.inputLayout, state.inputLayout, [&](InputLayoutFn l) { backend.BindInputLayout(l); });
+		bind(bound.blend, state.blend, [&](BlendState* b) { backend.BindBlend(b); });
+		bind(bound.depth, state.depth, [&](DepthState* d) { backend.BindDepth(d); });
+		bind(bound.texture, state.texture, [&](Texture* t) { backend.BindTexture(t); });
+		bind(boundTopology, item.geometry.topology, [&](D3D11_PRIMITIVE_TOPOLOGY t) { backend.BindTopology(t); });
+
+		if (!boundModel || memcmp(boundModel, &item.model, sizeof(Matrix)) != 0) {
+			backend.SetModel(item.model);
+			boundModel = &item.model;
+			stats.cbUpdates++;
+		}
+
+		backend.Draw(item.geometry);
+		stats.drawCalls++;
+		if (item.geometry.instanceStride) stats.instances += item.geometry.instanceCount;
+	}
+}
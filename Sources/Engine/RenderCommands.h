@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Engine/BlendState.h"
+#include "Engine/Camera.h"
+#include "Engine/DepthState.h"
+#include "Engine/Shader.h"
+#include "Engine/Texture.h"
+
+using namespace DirectX::SimpleMath;
+
+// Passes are executed in this order
+enum RenderPass {
+	RP_OPAQUE,      // sorted by state, then front to back
+	RP_TRANSPARENT, // sorted back to front
+	RP_OVERLAY,     // submission order
+	RP_HUD,         // submission order
+
+	RP_COUNT
+};
+
+typedef void (*InputLayoutFn)(DeviceResources* deviceRes);
+
+// Everything bound before a draw. All fields must be set.
+struct RenderState {
+	Camera* camera = nullptr;
+	Shader* shader = nullptr;
+	InputLayoutFn inputLayout = nullptr;
+	BlendState* blend = nullptr;
+	DepthState* depth = nullptr;
+	Texture* texture = nullptr;
+};
+
+// Buffers are opaque handles here, only the D3D11 backend looks into them
+struct RenderGeometry {
+	ID3D11Buffer* vertexBuffer = nullptr;
+	uint32_t stride = 0;
+	ID3D11Buffer* indexBuffer = nullptr; // null for non indexed draws
+	uint32_t count = 0;                  // indices, or vertices for non indexed draws
+	uint32_t start = 0;                  // first index, or first vertex for non indexed draws
+	D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	// Instanced draws only: per-instance data bound to vertex slot 1
+	ID3D11Buffer* instanceBuffer = nullptr;
+	uint32_t instanceStride = 0;         // 0 for a plain draw
+	uint32_t firstInstance = 0;
+	uint32_t instanceCount = 1;
+};
+
+struct RenderItem {
+	uint64_t sortKey;
+	RenderState state;
+	RenderGeometry geometry;
+	Matrix model;
+};
+
+struct RenderStats {
+	uint32_t items = 0;
+	uint32_t drawCalls = 0;
+	uint32_t instances = 0;      // drawn by instanced draws
+	uint32_t stateChanges = 0;
+	uint32_t redundantBinds = 0; // binds dropped because the state was already set
+	uint32_t cbUpdates = 0;
+};
+
+// Target of a recorded frame: D3D11 for the game, null to profile the recording path without a GPU
+class IRenderBackend {
+public:
+	virtual ~IRenderBackend() = default;
+
+	virtual void BeginFrame() {}
+	// Replaces the whole contents of a dynamic buffer
+	virtual void Upload(ID3D11Buffer* buffer, const void* data, size_t size) {}
+	virtual void BindCamera(Camera* camera) = 0;
+	virtual void BindShader(Shader* shader) = 0;
+	virtual void BindInputLayout(InputLayoutFn inputLayout) = 0;
+	virtual void BindBlend(BlendState* blend) = 0;
+	virtual void BindDepth(DepthState* depth) = 0;
+	virtual void BindTexture(Texture* texture) = 0;
+	virtual void BindTopology(D3D11_PRIMITIVE_TOPOLOGY topology) = 0;
+	virtual void SetModel(const Matrix& model) = 0;
+	virtual void Draw(const RenderGeometry& geometry) = 0;
+};
+
+// Draws of one frame: recorded in any order, sorted, then executed with redundant binds removed
+class RenderCommandList {
+	// State fields packed into the sort key, each numbers its own resources
+	enum KeyField { KF_CAMERA, KF_SHADER, KF_INPUT_LAYOUT, KF_DEPTH, KF_BLEND, KF_TEXTURE, KF_COUNT };
+
+	std::vector<RenderItem> items;
+	// Ids handed out this frame, per field
+	std::unordered_map<const void*, uint32_t> resourceIds[KF_COUNT];
+	// Holds a reference on every buffer drawn until Clear, so a mesh can be rebuilt while an older list still uses it
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> retained;
+	// Dynamic buffer contents, ranges of uploadData written before the first draw
+	struct Upload {
+		ID3D11Buffer* buffer;
+		size_t offset;
+		size_t size;
+	};
+	std::vector<Upload> uploads;
+	std::vector<uint8_t> uploadData;
+	uint32_t sequence = 0;
+	RenderStats stats;
+
+	uint64_t GetResourceId(KeyField field, const void* resource);
+	uint64_t MakeSortKey(RenderPass pass, const RenderState& state, float viewDepth);
+public:
+	void Clear();
+	// viewDepth is the distance to the camera, only used by the opaque and transparent passes
+	void Add(RenderPass pass, const RenderState& state, const RenderGeometry& geometry, const Matrix& model, float viewDepth = 0);
+	// Copies data now and writes it to the dynamic buffer when the list executes, since recording may run off the
+	// thread owning the immediate context. A buffer gets one upload per list.
+	void AddUpload(ID3D11Buffer* buffer, const void* data, size_t size);
+	void Sort();
+	void Execute(IRenderBackend& backend);
+
+	size_t Size() const { return items.size(); }
+	const RenderStats& GetStats() const { return stats; }
+};
@@ -5,6 +5,7 @@
 using namespace DirectX;
 
 void RenderTarget::Create(DeviceResources* deviceRes) {
+	if (deviceRes->IsHeadless()) return;
 	auto d3dDevice = deviceRes->GetD3DDevice();
 	auto d3dContext = deviceRes->GetD3DDeviceContext();
 
@@ -57,12 +58,9 @@ void RenderTarget::ApplyTarget(DeviceResources* deviceRes) {
 
 	CD3D11_VIEWPORT viewport(0.0f, 0.0f, (float)width, (float)height);
 	d3dContext->RSSetViewports(1, &viewport);
+	deviceRes->GetStateCache()->InvalidateShaderResources();
 }
 
 void RenderTarget::ApplyShaderResourcePS(DeviceResources* deviceRes, int slot) {
-	auto d3dDevice = deviceRes->GetD3DDevice();
-	auto d3dContext = deviceRes->GetD3DDeviceContext();
-
-	ID3D11ShaderResourceView* srvs[] = { shaderRV.Get() };
-	d3dContext->PSSetShaderResources(slot, 1, srvs);
+	deviceRes->GetStateCache()->SetPSShaderResource(slot, shaderRV.Get());
 }
\ No newline at end of file
@@ -2,9 +2,10 @@
 
 #include "Shader.h"
 
-std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11InputLayout>> g_inputLayouts = {};
+std::array<Microsoft::WRL::ComPtr<ID3D11InputLayout>, std::tuple_size<VertexLayouts>::value> g_inputLayouts = {};
 
 void Shader::Create(DeviceResources* deviceRes) {
+	if (deviceRes->IsHeadless()) return;
 	auto d3dDevice = deviceRes->GetD3DDevice();
 	vsBytecode = DX::ReadData((std::wstring(L"Shaders/Compiled/") + shaderName + L"_vs.cso").c_str());
 	psBytecode = DX::ReadData((std::wstring(L"Shaders/Compiled/") + shaderName + L"_ps.cso").c_str());
@@ -14,7 +15,7 @@ void Shader::Create(DeviceResources* deviceRes) {
 }
 
 void Shader::Apply(DeviceResources* deviceRes) {
-	auto d3dContext = deviceRes->GetD3DDeviceContext();
-	d3dContext->VSSetShader(vertexShader.Get(), nullptr, 0);
-	d3dContext->PSSetShader(pixelShader.Get(), nullptr, 0);
+	auto stateCache = deviceRes->GetStateCache();
+	stateCache->SetVertexShader(vertexShader.Get());
+	stateCache->SetPixelShader(pixelShader.Get());
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Engine/VertexLayout.h"
+
 using namespace DirectX::SimpleMath;
 using Microsoft::WRL::ComPtr;
 
@@ -17,23 +19,24 @@ public:
 	void Apply(DeviceResources* deviceRes);
 };
 
-extern std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11InputLayout>> g_inputLayouts;
+// One slot per entry of VertexLayouts, so binding a layout is an array lookup instead of a string hash.
+extern std::array<Microsoft::WRL::ComPtr<ID3D11InputLayout>, std::tuple_size<VertexLayouts>::value> g_inputLayouts;
 
 template <typename T>
 void GenerateInputLayout(DeviceResources* deviceRes, Shader* basicShader) {
-	auto it = g_inputLayouts.find(typeid(T).name());
-	if (it != g_inputLayouts.end()) return;
+	auto& layout = g_inputLayouts[VertexLayoutIndex<T, VertexLayouts>::value];
+	if (layout || deviceRes->IsHeadless()) return;
 	deviceRes->GetD3DDevice()->CreateInputLayout(
-		typename T::InputElementDescs.data(),
-		typename T::InputElementDescs.size(),
+		T::InputElementDescs.data(),
+		(UINT)T::InputElementDescs.size(),
 		basicShader->vsBytecode.data(),
 		basicShader->vsBytecode.size(),
-		g_inputLayouts[typeid(T).name()].ReleaseAndGetAddressOf());
+		layout.ReleaseAndGetAddressOf());
 }
 
 template <typename T>
 void ApplyInputLayout(DeviceResources* deviceRes) {
-	auto it = g_inputLayouts.find(typeid(T).name());
-	assert(it != g_inputLayouts.end());
-	deviceRes->GetD3DDeviceContext()->IASetInputLayout(it->second.Get());
+	auto& layout = g_inputLayouts[VertexLayoutIndex<T, VertexLayouts>::value];
+	assert(layout);
+	deviceRes->GetStateCache()->SetInputLayout(layout.Get());
 }
\ No newline at end of file
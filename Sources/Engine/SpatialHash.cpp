@@ -0,0 +1,26 @@
+#include "pch.h"
+
+#include "SpatialHash.h"
+
+void SpatialHash::Build(const Vector3* positions, uint32_t count) {
+	// Twice as many buckets as items keeps most buckets to a single cell
+	uint32_t buckets = 64;
+	while (buckets < count * 2)
+		buckets *= 2;
+	bucketMask = buckets - 1;
+
+	bucketStart.assign(buckets + 1, 0);
+	itemBucket.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		int x, y, z;
+		GetCell(positions[i], x, y, z);
+		itemBucket[i] = GetBucket(x, y, z);
+		bucketStart[itemBucket[i] + 1]++;
+	}
+	std::partial_sum(bucketStart.begin(), bucketStart.end(), bucketStart.begin());
+
+	items.resize(count);
+	std::vector<uint32_t> next(bucketStart.begin(), bucketStart.end() - 1);
+	for (uint32_t i = 0; i < count; i++)
+		items[next[itemBucket[i]]++] = i;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+using namespace DirectX::SimpleMath;
+
+// Uniform grid broadphase rebuilt from scratch every tick. Cells are hashed into a bucket table and
+// items are counting sorted by bucket. The hash is linear in X, so the 3 cells of a row are 3 consecutive
+// buckets and a lookup reads 9 contiguous ranges instead of 27 scattered ones.
+// Items are stored at the cell of their position: ForEachNear finds every item closer than cellSize.
+class SpatialHash {
+	float invCellSize;
+	uint32_t bucketMask = 0;
+	std::vector<uint32_t> bucketStart; // bucketMask + 2 entries, items of bucket b are [bucketStart[b], bucketStart[b + 1])
+	std::vector<uint32_t> items;
+	std::vector<uint32_t> itemBucket;
+
+	void GetCell(const Vector3& position, int& x, int& y, int& z) const {
+		x = (int)floor(position.x * invCellSize);
+		y = (int)floor(position.y * invCellSize);
+		z = (int)floor(position.z * invCellSize);
+	}
+	uint32_t GetBucket(int x, int y, int z) const {
+		return ((uint32_t)x + (uint32_t)y * 92837111u + (uint32_t)z * 689287499u) & bucketMask;
+	}
+public:
+	explicit SpatialHash(float cellSize) : invCellSize(1.0f / cellSize) {}
+
+	void Build(const Vector3* positions, uint32_t count);
+	// Items in bucket order: neighbours in space are mostly neighbours here, so data gathered in this order
+	// and lookups made in this order stay in cache
+	const std::vector<uint32_t>& GetSortedItems() const { return items; }
+
+	// Calls fn(sortedIndex) once for each item of the 27 cells around position, the item is GetSortedItems()[sortedIndex].
+	// Cells sharing buckets bring unrelated items, callers still test the distance.
+	template<typename TFn>
+	void ForEachNear(const Vector3& position, const TFn& fn) const {
+		if (items.empty()) return;
+		int cx, cy, cz;
+		GetCell(position, cx, cy, cz);
+
+		// Item ranges of the 9 rows, rows wrapping around the table are split in two
+		std::pair<uint32_t, uint32_t> ranges[18];
+		int rangeCount = 0;
+		for (int z = cz - 1; z <= cz + 1; z++) {
+			for (int y = cy - 1; y <= cy + 1; y++) {
+				const uint32_t first = GetBucket(cx - 1, y, z);
+				const uint32_t last = (first + 2) & bucketMask;
+				if (first <= last) {
+					ranges[rangeCount++] = { bucketStart[first], bucketStart[last + 1] };
+				} else {
+					ranges[rangeCount++] = { bucketStart[first], bucketStart[bucketMask + 1] };
+					ranges[rangeCount++] = { bucketStart[0], bucketStart[last + 1] };
+				}
+			}
+		}
+
+		// Rows may share buckets, merged ranges visit each item once
+		std::sort(ranges, ranges + rangeCount);
+		uint32_t visitedEnd = 0;
+		for (int r = 0; r < rangeCount; r++) {
+			for (uint32_t i = std::max(ranges[r].first, visitedEnd); i < ranges[r].second; i++)
+				fn(i);
+			visitedEnd = std::max(visitedEnd, ranges[r].second);
+		}
+	}
+
+	uint32_t GetBucketCount() const { return bucketMask + 1; }
+};
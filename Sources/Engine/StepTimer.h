@@ -8,6 +8,8 @@
 #include <cstdint>
 #include <exception>
 
+#include "Engine/Clock.h"
+
 
 namespace DX
 {
@@ -15,7 +17,8 @@ namespace DX
 	class StepTimer
 	{
 	public:
-		StepTimer() noexcept(false) :
+		StepTimer(IClock* clock = nullptr) noexcept(false) :
+			m_clock(clock ? clock : &SystemClock::Get()),
 			m_elapsedTicks(0),
 			m_totalTicks(0),
 			m_leftOverTicks(0),
@@ -23,21 +26,28 @@ namespace DX
 			m_framesPerSecond(0),
 			m_framesThisSecond(0),
 			m_qpcSecondCounter(0),
+			m_updatesThisFrame(0),
+			m_droppedTicks(0),
 			m_isFixedTimeStep(false),
-			m_targetElapsedTicks(TicksPerSecond / 60)
+			m_targetElapsedTicks(TicksPerSecond / 60),
+			m_maxUpdatesPerFrame(0)
 		{
-			if (!QueryPerformanceFrequency(&m_qpcFrequency))
-			{
-				throw std::exception();
-			}
-
-			if (!QueryPerformanceCounter(&m_qpcLastTime))
-			{
-				throw std::exception();
-			}
+			m_qpcFrequency = m_clock->GetFrequency();
+			m_qpcLastTime = m_clock->GetCounter();
 
 			// Initialize max delta to 1/10 of a second.
-			m_qpcMaxDelta = static_cast<uint64_t>(m_qpcFrequency.QuadPart / 10);
+			m_qpcMaxDelta = m_qpcFrequency / 10;
+		}
+
+		// Time source used by this timer.
+		IClock& GetClock() const noexcept { return *m_clock; }
+
+		void SetClock(IClock* clock) noexcept
+		{
+			m_clock = clock ? clock : &SystemClock::Get();
+			m_qpcFrequency = m_clock->GetFrequency();
+			m_qpcMaxDelta = m_qpcFrequency / 10;
+			ResetElapsedTime();
 		}
 
 		// Get elapsed time since the previous Update call.
@@ -54,6 +64,18 @@ namespace DX
 		// Get the current framerate.
 		uint32_t GetFramesPerSecond() const noexcept { return m_framesPerSecond; }
 
+		// Number of Update calls made by the last Tick.
+		uint32_t GetUpdatesThisFrame() const noexcept { return m_updatesThisFrame; }
+
+		// Simulation time thrown away by the catch-up cap since the start of the program.
+		uint64_t GetDroppedTicks() const noexcept { return m_droppedTicks; }
+
+		// How far rendering is between the last fixed update and the next one, in [0, 1).
+		double GetInterpolationAlpha() const noexcept
+		{
+			return m_isFixedTimeStep ? static_cast<double>(m_leftOverTicks) / static_cast<double>(m_targetElapsedTicks) : 1.0;
+		}
+
 		// Set whether to use fixed or variable timestep mode.
 		void SetFixedTimeStep(bool isFixedTimestep) noexcept { m_isFixedTimeStep = isFixedTimestep; }
 
@@ -61,6 +83,10 @@ namespace DX
 		void SetTargetElapsedTicks(uint64_t targetElapsed) noexcept { m_targetElapsedTicks = targetElapsed; }
 		void SetTargetElapsedSeconds(double targetElapsed) noexcept { m_targetElapsedTicks = SecondsToTicks(targetElapsed); }
 
+		// Limit the catch-up Update calls of a single Tick in fixed timestep mode (0 = no limit).
+		// When a frame falls further behind, the extra time is dropped instead of making the next frame even slower.
+		void SetMaxUpdatesPerFrame(uint32_t maxUpdates) noexcept { m_maxUpdatesPerFrame = maxUpdates; }
+
 		// Integer format represents time using 10,000,000 ticks per second.
 		static constexpr uint64_t TicksPerSecond = 10000000;
 
@@ -73,10 +99,7 @@ namespace DX
 
 		void ResetElapsedTime()
 		{
-			if (!QueryPerformanceCounter(&m_qpcLastTime))
-			{
-				throw std::exception();
-			}
+			m_qpcLastTime = m_clock->GetCounter();
 
 			m_leftOverTicks = 0;
 			m_framesPerSecond = 0;
@@ -89,14 +112,9 @@ namespace DX
 		void Tick(const TUpdate& update)
 		{
 			// Query the current time.
-			LARGE_INTEGER currentTime;
-
-			if (!QueryPerformanceCounter(&currentTime))
-			{
-				throw std::exception();
-			}
+			const uint64_t currentTime = m_clock->GetCounter();
 
-			uint64_t timeDelta = static_cast<uint64_t>(currentTime.QuadPart - m_qpcLastTime.QuadPart);
+			uint64_t timeDelta = currentTime - m_qpcLastTime;
 
 			m_qpcLastTime = currentTime;
 			m_qpcSecondCounter += timeDelta;
@@ -109,9 +127,10 @@ namespace DX
 
 			// Convert QPC units into a canonical tick format. This cannot overflow due to the previous clamp.
 			timeDelta *= TicksPerSecond;
-			timeDelta /= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+			timeDelta /= m_qpcFrequency;
 
 			const uint32_t lastFrameCount = m_frameCount;
+			m_updatesThisFrame = 0;
 
 			if (m_isFixedTimeStep)
 			{
@@ -133,6 +152,15 @@ namespace DX
 
 				while (m_leftOverTicks >= m_targetElapsedTicks)
 				{
+					if (m_maxUpdatesPerFrame != 0 && m_updatesThisFrame == m_maxUpdatesPerFrame)
+					{
+						const uint64_t dropped = m_leftOverTicks - m_leftOverTicks % m_targetElapsedTicks;
+						m_droppedTicks += dropped;
+						m_leftOverTicks -= dropped;
+						break;
+					}
+
+					m_updatesThisFrame++;
 					m_elapsedTicks = m_targetElapsedTicks;
 					m_totalTicks += m_targetElapsedTicks;
 					m_leftOverTicks -= m_targetElapsedTicks;
@@ -148,6 +176,7 @@ namespace DX
 				m_totalTicks += timeDelta;
 				m_leftOverTicks = 0;
 				m_frameCount++;
+				m_updatesThisFrame = 1;
 
 				update();
 			}
@@ -158,18 +187,19 @@ namespace DX
 				m_framesThisSecond++;
 			}
 
-			if (m_qpcSecondCounter >= static_cast<uint64_t>(m_qpcFrequency.QuadPart))
+			if (m_qpcSecondCounter >= m_qpcFrequency)
 			{
 				m_framesPerSecond = m_framesThisSecond;
 				m_framesThisSecond = 0;
-				m_qpcSecondCounter %= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+				m_qpcSecondCounter %= m_qpcFrequency;
 			}
 		}
 
 	private:
-		// Source timing data uses QPC units.
-		LARGE_INTEGER m_qpcFrequency;
-		LARGE_INTEGER m_qpcLastTime;
+		// Source timing data uses the clock units (QPC units on Windows).
+		IClock* m_clock;
+		uint64_t m_qpcFrequency;
+		uint64_t m_qpcLastTime;
 		uint64_t m_qpcMaxDelta;
 
 		// Derived timing data uses a canonical tick format.
@@ -182,9 +212,12 @@ namespace DX
 		uint32_t m_framesPerSecond;
 		uint32_t m_framesThisSecond;
 		uint64_t m_qpcSecondCounter;
+		uint32_t m_updatesThisFrame;
+		uint64_t m_droppedTicks;
 
 		// Members for configuring fixed timestep mode.
 		bool m_isFixedTimeStep;
 		uint64_t m_targetElapsedTicks;
+		uint32_t m_maxUpdatesPerFrame;
 	};
 }
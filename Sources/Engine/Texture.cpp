@@ -7,6 +7,7 @@
 using namespace DirectX;
 
 void Texture::Create(DeviceResources* deviceRes) {
+	if (deviceRes->IsHeadless()) return;
 	auto d3dDevice = deviceRes->GetD3DDevice();
 	auto d3dContext = deviceRes->GetD3DDeviceContext();
 
@@ -22,11 +23,7 @@ void Texture::Create(DeviceResources* deviceRes) {
 }
 
 void Texture::Apply(DeviceResources* deviceRes) {
-	auto d3dContext = deviceRes->GetD3DDeviceContext();
-
-	ID3D11ShaderResourceView* srv[] = { textureRV.Get() };
-	d3dContext->PSSetShaderResources(0, 1, srv);
-
-	ID3D11SamplerState* samplers[] = { samplerState.Get() };
-	d3dContext->PSSetSamplers(0, 1, samplers);
+	auto stateCache = deviceRes->GetStateCache();
+	stateCache->SetPSShaderResource(0, textureRV.Get());
+	stateCache->SetPSSampler(0, samplerState.Get());
 }
@@ -0,0 +1,51 @@
+#include "pch.h"
+
+#include "Transport.h"
+
+LoopbackTransport::~LoopbackTransport() {
+	// The peer sees the connection drop once it read what was sent
+	if (outgoing) {
+		std::lock_guard<std::mutex> lock(outgoing->mutex);
+		outgoing->closed = true;
+	}
+}
+
+void LoopbackTransport::Send(const void* data, size_t size) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	{
+		std::lock_guard<std::mutex> lock(outgoing->mutex);
+		outgoing->messages.emplace_back(bytes, bytes + size);
+	}
+	stats.bytesSent += size;
+	stats.messagesSent++;
+}
+
+bool LoopbackTransport::Receive(std::vector<uint8_t>& message) {
+	{
+		std::lock_guard<std::mutex> lock(incoming->mutex);
+		if (incoming->messages.empty()) return false;
+		message.swap(incoming->messages.front());
+		incoming->messages.pop_front();
+	}
+	stats.bytesReceived += message.size();
+	stats.messagesReceived++;
+	return true;
+}
+
+bool LoopbackTransport::IsConnected() const {
+	std::lock_guard<std::mutex> lock(incoming->mutex);
+	return !incoming->closed || !incoming->messages.empty();
+}
+
+void LoopbackTransport::CreatePair(std::unique_ptr<ITransport>& first, std::unique_ptr<ITransport>& second) {
+	auto forward = std::make_shared<Pipe>();
+	auto backward = std::make_shared<Pipe>();
+	auto a = std::make_unique<LoopbackTransport>();
+	auto b = std::make_unique<LoopbackTransport>();
+	a->outgoing = forward;
+	a->incoming = backward;
+	b->outgoing = backward;
+	b->incoming = forward;
+	first = std::move(a);
+	second = std::move(b);
+}
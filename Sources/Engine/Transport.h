@@ -0,0 +1,42 @@
+#pragma once
+
+struct TransportStats {
+	uint64_t bytesSent = 0;
+	uint64_t bytesReceived = 0;
+	uint64_t messagesSent = 0;
+	uint64_t messagesReceived = 0;
+};
+
+// Reliable, ordered messages between two endpoints. Send and Receive never block, so one thread can
+// serve many endpoints, and each endpoint may be used from a different thread than its peer.
+class ITransport {
+public:
+	virtual ~ITransport() = default;
+	virtual void Send(const void* data, size_t size) = 0;
+	// Returns false when no message is waiting
+	virtual bool Receive(std::vector<uint8_t>& message) = 0;
+	virtual bool IsConnected() const = 0;
+
+	TransportStats stats;
+};
+
+// In-process pipe: what one endpoint sends is queued for the other. Lets a server and its clients run in the
+// same process, on any platform, for tests and benchmarks.
+class LoopbackTransport : public ITransport {
+	struct Pipe {
+		std::mutex mutex;
+		std::deque<std::vector<uint8_t>> messages;
+		bool closed = false;
+	};
+	std::shared_ptr<Pipe> outgoing;
+	std::shared_ptr<Pipe> incoming;
+public:
+	~LoopbackTransport() override;
+
+	void Send(const void* data, size_t size) override;
+	bool Receive(std::vector<uint8_t>& message) override;
+	bool IsConnected() const override;
+
+	// Two connected endpoints
+	static void CreatePair(std::unique_ptr<ITransport>& first, std::unique_ptr<ITransport>& second);
+};
@@ -83,3 +83,47 @@ struct VertexLayout_PositionNormalUV {
 		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	};
 };
+
+// Cube vertices in slot 0 and one transform per instance in slot 1, the struct itself is the instance data
+struct VertexLayout_BlockInstance {
+	// Constructor for ease of use
+	VertexLayout_BlockInstance() = default;
+	VertexLayout_BlockInstance(Matrix const& transform) noexcept : transform(transform) { }
+
+	// The actual data inside the struct
+	Matrix transform;
+
+	// Input Layout Descriptor
+	static inline const std::vector<D3D11_INPUT_ELEMENT_DESC> InputElementDescs = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "INSTANCE", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCE", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCE", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCE", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	};
+};
+
+// Every vertex layout the game can bind. Each gets a fixed slot in g_inputLayouts, resolved at compile time.
+using VertexLayouts = std::tuple<
+	VertexLayout_Position,
+	VertexLayout_PositionColor,
+	VertexLayout_PositionColorUV,
+	VertexLayout_PositionUV,
+	VertexLayout_PositionNormalUV,
+	VertexLayout_BlockInstance
+>;
+
+template<typename T, typename TList>
+struct VertexLayoutIndex;
+
+template<typename T, typename... TRest>
+struct VertexLayoutIndex<T, std::tuple<T, TRest...>> {
+	static constexpr size_t value = 0;
+};
+
+template<typename T, typename TFirst, typename... TRest>
+struct VertexLayoutIndex<T, std::tuple<TFirst, TRest...>> {
+	static constexpr size_t value = 1 + VertexLayoutIndex<T, std::tuple<TRest...>>::value;
+};
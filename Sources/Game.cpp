@@ -11,7 +11,22 @@
 #include "Engine/VertexLayout.h"
 #include "Engine/Texture.h"
 #include "Engine/DefaultResources.h"
+#include "Engine/Profiler.h"
+#include "Engine/RenderBackends.h"
+#include "Engine/JobSystem.h"
+#include "Bench/Bench.h"
 #include "Minicraft/World.h"
+#include "Minicraft/WorldEditBatch.h"
+#include "Minicraft/WorldEditQueue.h"
+#include "Minicraft/EntityStore.h"
+#include "Minicraft/EntityRenderer.h"
+#include "Minicraft/BlockMeshCache.h"
+#include "Minicraft/BlockTicks.h"
+#include "Minicraft/BlockBehaviours.h"
+#include "Minicraft/FluidSimulation.h"
+#include "Minicraft/ExplosionSystem.h"
+#include "Minicraft/Pathfinder.h"
+#include "Minicraft/WorldServer.h"
 #include "Minicraft/Player.h"
 #include "Minicraft/Utils.h"
 
@@ -26,58 +41,176 @@ using Microsoft::WRL::ComPtr;
 DefaultResources gpuResources;
 Shader basicShader(L"Basic");
 Shader blockShader(L"Block");
+Shader blockInstancedShader(L"BlockInstanced");
 VertexBuffer<VertexLayout_PositionColor> crosshairLine;
 
 Texture texture(L"terrain");
 World world;
 Player player(&world, Vector3(16, 32, 16));
+EntityStore entities;
+EntityRenderer entityRenderer;
+BlockTickScheduler blockTicks(&world);
+FluidSimulation fluids(&world);
+ExplosionSystem explosions(&world);
+Pathfinder pathfinder(&world);
+WorldServer server(&world);
+WorldEditQueue editQueue(&world);
 OrthographicCamera hudCamera(400, 600);
 
+namespace {
+	// printf at the end of a string, sized by a first pass so a line never gets cut when it gains fields
+	template<typename... Args>
+	void AppendFormat(std::string& out, const char* format, Args... args) {
+		const int length = snprintf(nullptr, 0, format, args...);
+		if (length <= 0) return;
+		const size_t start = out.size();
+		out.resize(start + length + 1);
+		snprintf(&out[start], length + 1, format, args...);
+		out.resize(start + length);
+	}
+}
+
 // Game
 Game::Game() noexcept(false) {
 	m_deviceResources = std::make_unique<DeviceResources>(DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, DXGI_FORMAT_D32_FLOAT, 2);
 	m_deviceResources->RegisterDeviceNotify(this);
+
+	m_timer.SetFixedTimeStep(true);
+	m_timer.SetTargetElapsedSeconds(1.0 / c_TicksPerSecond);
+	m_timer.SetMaxUpdatesPerFrame(c_MaxTicksPerFrame);
 }
 
 Game::~Game() {
-	g_inputLayouts.clear();
+	world.WaitForLoadJobs();
+	for (auto& layout : g_inputLayouts)
+		layout.Reset();
 }
 
 void Game::Initialize(HWND window, int width, int height) {
+	m_startupStart = DX::SystemClock::Get().GetCounter();
+
 	// Create input devices
 	m_gamePad = std::make_unique<GamePad>();
 	m_keyboard = std::make_unique<Keyboard>();
 	m_mouse = std::make_unique<Mouse>();
 	m_mouse->SetWindow(window);
 	m_mouse->SetMode(Mouse::MODE_RELATIVE);
+	m_input = std::make_unique<DeviceInputSource>(m_keyboard.get(), m_mouse.get());
 
 	// Initialize the Direct3D resources
 	m_deviceResources->SetWindow(window, width, height);
 	m_deviceResources->CreateDeviceResources();
 	m_deviceResources->CreateWindowSizeDependentResources();
+	m_renderBackend = std::make_unique<D3D11RenderBackend>(m_deviceResources.get());
 
+	CreateResources(width, height);
+}
+
+void Game::InitializeHeadless(int width, int height) {
+	m_startupStart = DX::SystemClock::Get().GetCounter();
+	m_headless = true;
+	m_input = std::make_unique<ScriptedInputSource>();
+	m_renderBackend = std::make_unique<NullRenderBackend>();
+	m_timer.SetClock(&m_headlessClock);
+
+	CreateResources(width, height);
+}
+
+void Game::RunHeadless(uint32_t ticks) {
+	assert(m_headless);
+	m_frameStats = FrameStats(ticks);
+	for (uint32_t i = 0; i < ticks; i++) {
+		m_headlessClock.AdvanceSeconds(1.0 / 60.0);
+		Tick();
+	}
+}
+
+void Game::RunReplay(const InputRecording& recording) {
+	assert(m_headless);
+	m_input = std::make_unique<ReplayInputSource>(recording);
+	m_frameStats = FrameStats(std::max<uint32_t>((uint32_t)recording.frames.size(), 1));
+	for (auto& frame : recording.frames) {
+		// The headless clock runs at StepTimer::TicksPerSecond, so counts are ticks
+		m_headlessClock.Advance(frame.dtTicks);
+		Tick();
+	}
+}
+
+std::string Game::RunBenchmark(const BenchEntry& bench, const std::wstring& argument, bool& failed) {
+	assert(m_headless && !world.IsLoading());
+	BenchContext context;
+	context.deviceResources = m_deviceResources.get();
+	context.worldSeed = m_worldSeed;
+	context.world = &world;
+	context.entities = &entities;
+	context.entityRenderer = &entityRenderer;
+	context.blockTicks = &blockTicks;
+	context.fluids = &fluids;
+	context.explosions = &explosions;
+	context.pathfinder = &pathfinder;
+	context.server = &server;
+	context.editQueue = &editQueue;
+	context.blockState.camera = &m_frames[0].camera;
+	context.blockState.shader = &blockShader;
+	context.blockState.inputLayout = &ApplyInputLayout<VertexLayout_PositionNormalUV>;
+	context.blockState.blend = &gpuResources.opaque;
+	context.blockState.depth = &gpuResources.defaultDepth;
+	context.blockState.texture = &texture;
+	context.instancedState = context.blockState;
+	context.instancedState.shader = &blockInstancedShader;
+	context.instancedState.inputLayout = &ApplyInputLayout<VertexLayout_BlockInstance>;
+	context.argument = argument;
+
+	std::string report = bench.run(context);
+	context.ClearSystems();
+	failed = context.failed;
+	return report;
+}
+
+bool Game::StartRecording(const std::filesystem::path& path) {
+	return m_recorder.Open(path, m_worldSeed);
+}
+
+void Game::CreateResources(int width, int height) {
 	basicShader.Create(m_deviceResources.get());
 	blockShader.Create(m_deviceResources.get());
+	blockInstancedShader.Create(m_deviceResources.get());
 	GenerateInputLayout<VertexLayout_PositionColor>(m_deviceResources.get(), &basicShader);
 	GenerateInputLayout<VertexLayout_PositionNormalUV>(m_deviceResources.get(), &blockShader);
+	GenerateInputLayout<VertexLayout_BlockInstance>(m_deviceResources.get(), &blockInstancedShader);
 
 	texture.Create(m_deviceResources.get());
 
 	gpuResources.Create(m_deviceResources.get());
 
-	player.GenerateGPUResources(m_deviceResources.get());
-	player.GetCamera()->UpdateAspectRatio((float)width / (float)height);
+	BlockMeshCache::Get().Create(m_deviceResources.get());
+	world.AddBlockListener(&blockTicks);
+	world.AddBlockListener(&fluids);
+	world.AddBlockListener(&pathfinder);
+	world.AddBlockListener(&server);
+	blockTicks.SetEntityStore(&entities);
+	blockTicks.SetExplosionSystem(&explosions);
+	player.SetEditQueue(&editQueue);
+	RegisterBlockBehaviours(blockTicks);
+	for (auto& frame : m_frames)
+		frame.camera.UpdateAspectRatio((float)width / (float)height);
 	hudCamera.UpdateSize((float)width, (float)height);
 
-	world.Generate(m_deviceResources.get());
+	if (m_progressiveStartup) {
+		world.StartProgressiveGeneration(m_deviceResources.get(), m_worldSeed, player.GetEyePosition());
+	} else {
+		world.Generate(m_deviceResources.get(), m_worldSeed);
+		m_fullWorldMs = DX::SystemClock::Get().MillisecondsSince(m_startupStart);
+	}
 
 	Vector3 dir(-0.5, -0.8, -0.2);
 	dir.Normalize();
 	auto res = Raycast(Vector3(20, 15, 20) + Vector3(0.5, 0.5, 0.5), dir, 20);
 
-	for (auto& cube : res) {
-		world.UpdateBlock(cube[0], cube[1], cube[2], STONE);
-	}
+	WorldEditBatch line(&world);
+	for (auto& cube : res)
+		line.Set(cube[0], cube[1], cube[2], STONE);
+	line.Commit();
 
 	crosshairLine.PushVertex({ {-7, 0, 1, 1}, {1, 1, 1, 1} });
 	crosshairLine.PushVertex({ {6, 0, 1, 1}, {1, 1, 1, 1} });
@@ -88,64 +221,219 @@ void Game::Initialize(HWND window, int width, int height) {
 }
 
 void Game::Tick() {
-	// DX::StepTimer will compute the elapsed time and call Update() for us
-	// We pass Update as a callback to Tick() because StepTimer can be set to a "fixed time" step mode, allowing us to call Update multiple time in a row if the framerate is too low (useful for physics stuffs)
-	m_timer.Tick([&]() { Update(m_timer); });
+	// Costs are always measured in wall time, even when the simulation runs on the headless clock
+	auto& clock = DX::SystemClock::Get();
+	const uint64_t frameStart = clock.GetCounter();
+	FrameTiming timing;
+
+	PollInput();
+	HandleDebugKeys();
+
+	// Runs the simulation ticks, then records what they produced into a frame buffer
+	auto simulate = [&](FrameBuffer& frame) {
+		frame.simulationStart = clock.GetCounter();
+
+		// DX::StepTimer will compute the elapsed time and call Update() for us
+		// It runs in fixed timestep mode: Update is called 0 to c_MaxTicksPerFrame times depending on how much time passed
+		m_timer.Tick([&]() {
+			const uint64_t updateStart = clock.GetCounter();
+			Update(m_timer);
+			const double tickMs = clock.MillisecondsSince(updateStart);
+			timing.updateMs += tickMs;
+			timing.tickMs = std::max(timing.tickMs, tickMs);
+		});
+		timing.ticks = m_timer.GetUpdatesThisFrame();
+
+		const uint64_t recordStart = clock.GetCounter();
+		RecordFrame(frame);
+		timing.renderMs += clock.MillisecondsSince(recordStart);
+		timing.regenMs = world.stats.regenMs;
+	};
+
+	FrameBuffer& front = m_frames[m_frameIndex];
+	FrameBuffer& back = m_frames[m_frameIndex ^ 1];
+	double submitMs = 0;
+	if (m_pipelined) {
+		// The next frame is simulated and recorded on a worker while this thread submits the previous one:
+		// better throughput, but what is shown is one frame older than the input just read.
+		JobCounter simulation;
+		JobSystem::Get().Submit([&]() { simulate(back); }, &simulation);
+
+		const uint64_t submitStart = clock.GetCounter();
+		SubmitFrame(front);
+		submitMs = clock.MillisecondsSince(submitStart);
+		if (front.recorded)
+			timing.latencyMs = clock.MillisecondsSince(front.simulationStart);
+
+		JobSystem::Get().Wait(simulation);
+		m_frameIndex ^= 1;
+	} else {
+		simulate(front);
+
+		const uint64_t submitStart = clock.GetCounter();
+		SubmitFrame(front);
+		submitMs = clock.MillisecondsSince(submitStart);
+		if (front.recorded)
+			timing.latencyMs = clock.MillisecondsSince(front.simulationStart);
+	}
+
+	if (front.recorded && m_firstFrameMs < 0)
+		m_firstFrameMs = clock.MillisecondsSince(m_startupStart);
+	if (m_fullWorldMs < 0 && !world.IsLoading())
+		m_fullWorldMs = clock.MillisecondsSince(m_startupStart);
 
-	Render(m_timer);
+	timing.renderMs += submitMs;
+	timing.frameMs = clock.MillisecondsSince(frameStart);
+	m_frameStats.AddFrame(timing);
 }
 
-// Updates the world.
-void Game::Update(DX::StepTimer const& timer) {
-	auto const kb = m_keyboard->GetState();
-	auto const ms = m_mouse->GetState();
-	m_mouse->ResetScrollWheelValue();
-	
-	player.Update(timer.GetElapsedSeconds(), kb, ms);
+void Game::PollInput() {
+	Mouse::State ms;
+	m_input->Poll(m_kb, ms);
+	ms.x += m_ms.x;
+	ms.y += m_ms.y;
+	ms.scrollWheelValue += m_ms.scrollWheelValue;
+	m_ms = ms;
+}
 
-	if (kb.Escape)
+// Per frame keys, handled on the main thread before the simulation may start on a worker.
+void Game::HandleDebugKeys() {
+	m_keyboardTracker.Update(m_kb);
+	if (m_keyboardTracker.IsKeyPressed(Keyboard::F1))
+		Profiler::SetEnabled(!Profiler::IsEnabled());
+	if (m_keyboardTracker.IsKeyPressed(Keyboard::F2))
+		Profiler::ExportChromeTrace("minicraft_trace.json");
+	if (m_keyboardTracker.IsKeyPressed(Keyboard::F3))
+		OutputDebugStringA((FormatStats() + "\n").c_str());
+	if (m_keyboardTracker.IsKeyPressed(Keyboard::F4))
+		SetPipelined(!m_pipelined);
+
+	if (m_kb.Escape)
 		ExitGame();
 
-	auto const pad = m_gamePad->GetState(0);
+	if (m_gamePad) {
+		auto const pad = m_gamePad->GetState(0);
+	}
+}
+
+// Advances the simulation by one fixed tick.
+void Game::Update(DX::StepTimer const& timer) {
+	PROFILE_ZONE("Game::Update");
+
+	auto const kb = m_kb;
+	auto const ms = m_ms;
+	m_ms.x = 0;
+	m_ms.y = 0;
+	m_ms.scrollWheelValue = 0;
+	if (m_recorder.IsOpen())
+		m_recorder.Write(timer.GetElapsedTicks(), kb, ms);
+
+	player.Update(timer.GetElapsedSeconds(), kb, ms);
+	// Edits queued since the last tick, by the player and by any other thread, before the systems react to them
+	editQueue.Drain();
+	blockTicks.Update((float)timer.GetElapsedSeconds(), &JobSystem::Get());
+	explosions.Update((float)timer.GetElapsedSeconds(), &JobSystem::Get());
+	fluids.Update((float)timer.GetElapsedSeconds(), &JobSystem::Get());
+	entities.Update(&world, (float)timer.GetElapsedSeconds(), &JobSystem::Get());
+	// Paths found during the next tick see every edit of this one
+	pathfinder.Refresh(&JobSystem::Get());
+	server.Tick(&JobSystem::Get());
+	Vector3 eye = player.GetEyePosition();
+	m_cameraPathHash = HashBytes(m_cameraPathHash, &eye, sizeof(eye));
+}
+
+std::string Game::FormatStats() {
+	auto& render = m_frames[m_submittedIndex].commands.GetStats();
+	auto& device = m_deviceResources->GetStateCache()->GetStats();
+	std::string stats = m_frameStats.Format();
+	AppendFormat(stats, " | draws %u, state changes %u, redundant binds %u, cb updates %u, d3d calls %u (%u filtered)",
+		render.drawCalls, render.stateChanges, render.redundantBinds, render.cbUpdates, device.issued, device.skipped);
+	AppendFormat(stats, " | rebuild queue %d, oldest %.1f ms | %s | dropped %.2f s | edits %d hash %08x, camera path %08x",
+		world.stats.pendingRebuilds, world.stats.oldestRebuildMs, m_pipelined ? "pipelined" : "serial",
+		DX::StepTimer::TicksToSeconds(m_timer.GetDroppedTicks()), world.stats.blockEdits, world.stats.editHash, m_cameraPathHash);
+	AppendFormat(stats, " | first frame %.0f ms, full world %.0f ms, loading %d columns %d meshes | entities %d",
+		m_firstFrameMs, m_fullWorldMs, world.stats.loadingColumns, world.stats.loadingMeshes, entities.stats.count);
+	AppendFormat(stats, " | block ticks %d + %d random, %d pending (%.2f ms) | water %d active (%.2f ms)",
+		blockTicks.stats.scheduledTicks, blockTicks.stats.randomTicks, blockTicks.stats.pendingTicks, blockTicks.stats.tickMs,
+		fluids.stats.activeCells, fluids.stats.tickMs);
+	AppendFormat(stats, " | explosions %d, %d pending (%.2f ms) | edit queue %d (%.2f ms)",
+		explosions.stats.explosions, explosions.stats.pending, explosions.stats.tickMs, editQueue.stats.depth, editQueue.stats.applyMs);
+	return stats;
 }
 
-// Draws the scene.
-void Game::Render(DX::StepTimer const& timer) {
+// Records the scene into a frame buffer, the only place reading the world and the player for rendering.
+void Game::RecordFrame(FrameBuffer& frame) {
+	frame.commands.Clear();
 	// Don't try to render anything before the first Update.
-	if (m_timer.GetFrameCount() == 0)
+	frame.recorded = m_timer.GetFrameCount() != 0;
+	if (!frame.recorded)
 		return;
 
-	auto context = m_deviceResources->GetD3DDeviceContext();
-	auto renderTarget = m_deviceResources->GetRenderTargetView();
-	auto depthStencil = m_deviceResources->GetDepthStencilView();
-	auto const viewport = m_deviceResources->GetScreenViewport();
+	PROFILE_ZONE("Game::RecordFrame");
+
+	player.Interpolate((float)m_timer.GetInterpolationAlpha(), frame.camera);
+
+	RenderState worldState;
+	worldState.camera = &frame.camera;
+	worldState.shader = &blockShader;
+	worldState.inputLayout = &ApplyInputLayout<VertexLayout_PositionNormalUV>;
+	worldState.texture = &texture;
+	world.Draw(m_deviceResources.get(), frame.commands, worldState);
+
+	RenderState entityState = worldState;
+	entityState.shader = &blockInstancedShader;
+	entityState.inputLayout = &ApplyInputLayout<VertexLayout_BlockInstance>;
+	entityState.blend = &gpuResources.opaque;
+	entityState.depth = &gpuResources.defaultDepth;
+	entityRenderer.BuildInstances(entities);
+	entityRenderer.Draw(m_deviceResources.get(), frame.commands, entityState);
+
+	player.Draw(m_deviceResources.get(), frame.commands, worldState);
+
+	RenderState hudState;
+	hudState.camera = &hudCamera;
+	hudState.shader = &basicShader;
+	hudState.inputLayout = &ApplyInputLayout<VertexLayout_PositionColor>;
+	hudState.blend = &gpuResources.alphaBlend;
+	hudState.depth = &gpuResources.defaultDepth;
+	hudState.texture = &texture;
+
+	RenderGeometry crosshair;
+	crosshair.vertexBuffer = crosshairLine.Get();
+	crosshair.stride = sizeof(VertexLayout_PositionColor);
+	crosshair.count = 4;
+	crosshair.topology = D3D11_PRIMITIVE_TOPOLOGY_LINELIST;
+	frame.commands.Add(RP_HUD, hudState, crosshair, Matrix::Identity);
+
+	frame.commands.Sort();
+}
 
-	context->ClearRenderTargetView(renderTarget, Colors::CornflowerBlue);
-	context->ClearDepthStencilView(depthStencil, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
-	context->RSSetViewports(1, &viewport);
-	context->OMSetRenderTargets(1, &renderTarget, depthStencil);
-	
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	
-	ApplyInputLayout<VertexLayout_PositionNormalUV>(m_deviceResources.get());
+// Executes a recorded frame on the device and presents it, only touches the immediate context.
+void Game::SubmitFrame(FrameBuffer& frame) {
+	if (!frame.recorded)
+		return;
 
-	player.GetCamera()->ApplyCamera(m_deviceResources.get());
+	PROFILE_ZONE("Game::SubmitFrame");
+	m_submittedIndex = (int)(&frame - m_frames);
 
-	blockShader.Apply(m_deviceResources.get());
-	texture.Apply(m_deviceResources.get());
-	world.Draw(player.GetCamera(), m_deviceResources.get());
-	player.Draw(m_deviceResources.get());
+	if (!m_headless) {
+		auto context = m_deviceResources->GetD3DDeviceContext();
+		auto renderTarget = m_deviceResources->GetRenderTargetView();
+		auto depthStencil = m_deviceResources->GetDepthStencilView();
+		auto const viewport = m_deviceResources->GetScreenViewport();
 
-	hudCamera.ApplyCamera(m_deviceResources.get());
-	ApplyInputLayout<VertexLayout_PositionColor>(m_deviceResources.get());
-	basicShader.Apply(m_deviceResources.get());
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
-	crosshairLine.Apply(m_deviceResources.get());
-	context->Draw(4, 0);
+		context->ClearRenderTargetView(renderTarget, Colors::CornflowerBlue);
+		context->ClearDepthStencilView(depthStencil, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+		context->RSSetViewports(1, &viewport);
+		context->OMSetRenderTargets(1, &renderTarget, depthStencil);
+	}
 
-	m_deviceResources->Present();
-}
+	m_deviceResources->GetStateCache()->ResetStats();
+	frame.commands.Execute(*m_renderBackend);
 
+	if (!m_headless)
+		m_deviceResources->Present();
+}
 
 #pragma region Message Handlers
 void Game::OnActivated() {}
@@ -173,7 +461,8 @@ void Game::OnWindowSizeChanged(int width, int height) {
 
 	// The windows size has changed:
 	// We can realloc here any resources that depends on the target resolution (post processing etc)
-	player.GetCamera()->UpdateAspectRatio((float)width / (float)height);
+	for (auto& frame : m_frames)
+		frame.camera.UpdateAspectRatio((float)width / (float)height);
 	hudCamera.UpdateSize((float)width, (float)height);
 }
 
@@ -2,19 +2,51 @@
 
 #include "Engine/DeviceResources.h"
 #include "Engine/StepTimer.h"
+#include "Engine/FrameStats.h"
+#include "Engine/RenderCommands.h"
+#include "Engine/InputRecording.h"
+#include "Engine/Camera.h"
+#include "Engine/JobSystem.h"
+#include "Minicraft/Utils.h"
+
+struct BenchEntry;
 
 // A basic game implementation that creates a D3D11 device and
 // provides a game loop.
 class Game final : public IDeviceNotify {
 public:
+	// Simulation runs at a fixed rate, rendering interpolates between its two last ticks
+	static constexpr double c_TicksPerSecond = 60.0;
+	// Past this many catch-up ticks in one frame, the late simulation time is dropped
+	static constexpr uint32_t c_MaxTicksPerFrame = 4;
+
 	Game() noexcept(false);
 	~Game();
 
 	// Initialization and management
 	void Initialize(HWND window, int width, int height);
+	// No window and no device: scripted input, draws go to a null backend
+	void InitializeHeadless(int width, int height);
 
 	// Basic game loop
 	void Tick();
+	// Runs a fixed number of 60 Hz ticks as fast as possible, frame stats only keep this run
+	void RunHeadless(uint32_t ticks);
+	// Headless too: one tick per recorded frame, with the recorded dt and input
+	void RunReplay(const InputRecording& recording);
+	// Headless: runs one of Bench/Bench.h against the generated world, then drops what it left pending.
+	// failed is set when the checks of the benchmark did not pass
+	std::string RunBenchmark(const BenchEntry& bench, const std::wstring& argument, bool& failed);
+
+	// Must be set before initializing, a recording stores it for its replays
+	void SetWorldSeed(uint32_t seed) noexcept { m_worldSeed = seed; }
+	bool StartRecording(const std::filesystem::path& path);
+
+	// Simulates and records the next frame on a worker while the current one is submitted (F4)
+	void SetPipelined(bool pipelined) noexcept { m_pipelined = pipelined; }
+	bool IsPipelined() const noexcept { return m_pipelined; }
+	// Must be set before initializing: only the chunks around the spawn are ready for the first frame
+	void SetProgressiveStartup(bool progressive) noexcept { m_progressiveStartup = progressive; }
 
 	// IDeviceNotify
 	void OnDeviceLost() override;
@@ -31,19 +63,59 @@ public:
 
 	// Properties
 	void GetDefaultSize(int& width, int& height) const noexcept;
+	const FrameStats& GetFrameStats() const noexcept { return m_frameStats; }
+	std::string FormatStats();
 
 private:
+	void CreateResources(int width, int height);
+	void PollInput();
+	void HandleDebugKeys();
 	void Update(DX::StepTimer const& timer);
-	void Render(DX::StepTimer const& timer);
+
+	// Everything the submission of a frame reads, recorded at the end of its simulation
+	struct FrameBuffer {
+		RenderCommandList commands;
+		PerspectiveCamera camera = PerspectiveCamera(75, 1);
+		uint64_t simulationStart = 0;
+		bool recorded = false;
+	};
+	void RecordFrame(FrameBuffer& frame);
+	void SubmitFrame(FrameBuffer& frame);
 
 	// Device resources.
 	std::unique_ptr<DeviceResources>		m_deviceResources;
 
 	// Rendering loop timer.
 	DX::StepTimer                           m_timer;
+	// Headless runs advance time by hand so every run simulates the same thing.
+	DX::ManualClock                         m_headlessClock;
+	bool                                    m_headless = false;
+
+	uint32_t                                m_worldSeed = 0;
+	InputRecorder                           m_recorder;
+	uint32_t                                m_cameraPathHash = FNV_OFFSET_BASIS;
+	FrameStats                              m_frameStats;
+
+	// Startup times, from the start of the initialization
+	bool                                    m_progressiveStartup = false;
+	uint64_t                                m_startupStart = 0;
+	double                                  m_firstFrameMs = -1;
+	double                                  m_fullWorldMs = -1;
+
+	// Double buffered so the next frame can be recorded while the current one is submitted.
+	FrameBuffer                             m_frames[2];
+	int                                     m_frameIndex = 0;
+	int                                     m_submittedIndex = 0;
+	bool                                    m_pipelined = false;
+	std::unique_ptr<IRenderBackend>         m_renderBackend;
 
 	// Input devices.
 	std::unique_ptr<DirectX::GamePad>       m_gamePad;
 	std::unique_ptr<DirectX::Keyboard>      m_keyboard;
 	std::unique_ptr<DirectX::Mouse>         m_mouse;
+	std::unique_ptr<IInputSource>           m_input;
+	// Input read this frame, mouse motion is kept until a tick consumes it
+	DirectX::Keyboard::State                m_kb = {};
+	DirectX::Mouse::State                   m_ms = {};
+	DirectX::Keyboard::KeyboardStateTracker m_keyboardTracker;
 };
\ No newline at end of file
@@ -10,4 +10,4 @@ const BlockData blocksData[] = {
 const BlockData& BlockData::Get(const BlockId id) {
 	if (id < 0 || id > COUNT) return blocksData[EMPTY];
 	return blocksData[id];
-}
\ No newline at end of file
+}
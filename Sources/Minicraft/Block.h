@@ -19,50 +19,51 @@ enum BlockFlags : uint64_t {
 	BF_HALF_BLOCK = 1 << 5,
 };
 
+// Name, blast resistance, then the textures and flags
 #define BLOCKS(F) \
-	F( EMPTY,				-1, BF_NO_PHYSICS | BF_NO_RAYCAST ) \
-	F( STONE,				1 ) \
-	F( DIRT,				2 ) \
-	F( GRASS,				3, 0, 2 ) \
-	F( WOOD,				4 ) \
-	F( HALF_SLAB,		    5, 6, 6, BF_HALF_BLOCK ) \
-	F( SLAB,				5, 6, 6 ) \
-	F( BRICK,				7 ) \
-	F( STONE_BRICK,			54 ) \
-	F( BOOKSHELF,			35, 4, 4 ) \
-	F( DUNGEON_STONE,		36 ) \
-	F( TNT,					8, 9, 10 ) \
-	F( COBBLESTONE,			16 ) \
-	F( BEDROCK,				17 ) \
-	F( SAND,				18 ) \
-	F( GRAVEL,				19 ) \
-	F( LOG,					20, 21, 21 ) \
-	F( SPONGE,				48 ) \
-	F( WOOL,				64 ) \
+	F( EMPTY,				0.0f,		-1, BF_NO_PHYSICS | BF_NO_RAYCAST ) \
+	F( STONE,				6.0f,		1 ) \
+	F( DIRT,				0.5f,		2 ) \
+	F( GRASS,				0.5f,		3, 0, 2 ) \
+	F( WOOD,				3.0f,		4 ) \
+	F( HALF_SLAB,		    6.0f,		5, 6, 6, BF_HALF_BLOCK ) \
+	F( SLAB,				6.0f,		5, 6, 6 ) \
+	F( BRICK,				6.0f,		7 ) \
+	F( STONE_BRICK,			6.0f,		54 ) \
+	F( BOOKSHELF,			1.5f,		35, 4, 4 ) \
+	F( DUNGEON_STONE,		6.0f,		36 ) \
+	F( TNT,					0.0f,		8, 9, 10 ) \
+	F( COBBLESTONE,			6.0f,		16 ) \
+	F( BEDROCK,				3600000.0f,	17 ) \
+	F( SAND,				0.5f,		18 ) \
+	F( GRAVEL,				0.6f,		19 ) \
+	F( LOG,					3.0f,		20, 21, 21 ) \
+	F( SPONGE,				0.5f,		48 ) \
+	F( WOOL,				0.8f,		64 ) \
 /* ORE */ \
-	F( COAL,				34 ) \
-	F( IRON_ORE,			33 ) \
-	F( IRON_BLOCK,			22 ) \
-	F( GOLD_ORE,			32 ) \
-	F( GOLD_BLOCK,			23 ) \
-	F( DIAMOND_ORE,			50 ) \
-	F( DIAMOND_BLOCK,		24 ) \
-	F( EMERALD_BLOCK,		25 ) \
-	F( REDSTONE_ORE,		51 ) \
-	F( OBSIDIAN,			37 ) \
+	F( COAL,				6.0f,		34 ) \
+	F( IRON_ORE,			6.0f,		33 ) \
+	F( IRON_BLOCK,			6.0f,		22 ) \
+	F( GOLD_ORE,			6.0f,		32 ) \
+	F( GOLD_BLOCK,			6.0f,		23 ) \
+	F( DIAMOND_ORE,			6.0f,		50 ) \
+	F( DIAMOND_BLOCK,		6.0f,		24 ) \
+	F( EMERALD_BLOCK,		6.0f,		25 ) \
+	F( REDSTONE_ORE,		6.0f,		51 ) \
+	F( OBSIDIAN,			1200.0f,	37 ) \
 \
 /* OBJECTS */ \
-	F( CRAFTING_TABLE,		59, 43, 4 ) /* there is a side variation at index 60 */ \
-	F( FURNACE,				44, 62, 62 ) /* need an orientation & on/off flag */ \
-	F( DISPENSER,			46, 62, 62 ) /* need an orientation flag */ \
+	F( CRAFTING_TABLE,		3.0f,		59, 43, 4 ) /* there is a side variation at index 60 */ \
+	F( FURNACE,				3.5f,		44, 62, 62 ) /* need an orientation & on/off flag */ \
+	F( DISPENSER,			3.5f,		46, 62, 62 ) /* need an orientation flag */ \
 /* TRANSPARENT STUFF */ \
-	F( GLASS,				49, BF_CUTOUT ) \
-	F( WATER,				205, BF_NO_PHYSICS | BF_GRAVITY_WATER | BF_NO_RAYCAST, SP_TRANSPARENT ) \
+	F( GLASS,				0.3f,		49, BF_CUTOUT ) \
+	F( WATER,				100.0f,		205, BF_NO_PHYSICS | BF_GRAVITY_WATER | BF_NO_RAYCAST, SP_TRANSPARENT ) \
 /* 38, 39 & 40 contains greyscale grass for biome variation */ \
 /* as an exercice you can try to implement that by adding back some vertex color informations to the pipeline */ \
 /* 52, 53 contains greyscale leaves */ \
-	F( HIGHLIGHT, 180) \
-	F( COUNT, -1)
+	F( HIGHLIGHT, 0.0f, 180) \
+	F( COUNT, 0.0f, -1)
 
 #define EXTRACT_BLOCK_ID( v ) v,
 enum BlockId: uint8_t {
@@ -79,22 +80,26 @@ public:
 
 	uint64_t flags;
 	ShaderPass pass;
+	// How much of an explosion ray a block absorbs, stone is 6
+	float blastResistance;
 public:
-	BlockData(BlockId id, int texId, uint64_t flags = BF_NONE, ShaderPass pass = SP_OPAQUE) :
+	BlockData(BlockId id, float blastResistance, int texId, uint64_t flags = BF_NONE, ShaderPass pass = SP_OPAQUE) :
 		id(id),
 		texIdSide(texId),
 		texIdTop(texId),
 		texIdBottom(texId),
 		flags(flags),
-		pass(pass) {}
+		pass(pass),
+		blastResistance(blastResistance) {}
 
-	BlockData(BlockId id, int texIdSide, int texIdTop, int texIdBottom, uint64_t flags = BF_NONE, ShaderPass pass = SP_OPAQUE) :
+	BlockData(BlockId id, float blastResistance, int texIdSide, int texIdTop, int texIdBottom, uint64_t flags = BF_NONE, ShaderPass pass = SP_OPAQUE) :
 		id(id),
 		texIdSide(texIdSide),
 		texIdTop(texIdTop),
 		texIdBottom(texIdBottom),
 		flags(flags),
-		pass(pass) {}
+		pass(pass),
+		blastResistance(blastResistance) {}
 
 	static const BlockData& Get(const BlockId id);
 };
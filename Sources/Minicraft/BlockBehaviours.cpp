@@ -0,0 +1,57 @@
+#include "pch.h"
+
+#include "BlockBehaviours.h"
+#include "Minicraft/ChunkOccupancy.h"
+
+namespace {
+	bool IsOpaque(BlockId block) {
+		return ChunkOccupancy::GetClass(block) == OC_OPAQUE;
+	}
+
+	void FallIfUnsupported(BlockTickContext& ctx, int gx, int gy, int gz) {
+		const BlockId below = ctx.Get(gx, gy - 1, gz);
+		if (below == EMPTY || below == WATER)
+			ctx.Fall(gx, gy, gz);
+	}
+
+	void Detonate(BlockTickContext& ctx, int gx, int gy, int gz) {
+		ctx.Explode(gx, gy, gz);
+	}
+
+	void DecayGrass(BlockTickContext& ctx, int gx, int gy, int gz) {
+		if (IsOpaque(ctx.Get(gx, gy + 1, gz)))
+			ctx.Set(gx, gy, gz, DIRT);
+	}
+
+	void SpreadGrass(BlockTickContext& ctx, int gx, int gy, int gz) {
+		if (ctx.Get(gx, gy + 1, gz) != EMPTY) return;
+		for (int dz = -1; dz <= 1; dz++)
+			for (int dy = -1; dy <= 1; dy++)
+				for (int dx = -1; dx <= 1; dx++)
+					if (ctx.Get(gx + dx, gy + dy, gz + dz) == GRASS) {
+						ctx.Set(gx, gy, gz, GRASS);
+						return;
+					}
+	}
+}
+
+void RegisterBlockBehaviours(BlockTickScheduler& scheduler) {
+	BlockTickHandler falling;
+	falling.scheduled = &FallIfUnsupported;
+	falling.delay = 2;
+	scheduler.Register(SAND, falling);
+	scheduler.Register(GRAVEL, falling);
+
+	// Not lit by changes around it, only by BlockTickScheduler::Schedule with a fuse
+	BlockTickHandler tnt;
+	tnt.scheduled = &Detonate;
+	scheduler.Register(TNT, tnt);
+
+	BlockTickHandler grass;
+	grass.random = &DecayGrass;
+	scheduler.Register(GRASS, grass);
+
+	BlockTickHandler dirt;
+	dirt.random = &SpreadGrass;
+	scheduler.Register(DIRT, dirt);
+}
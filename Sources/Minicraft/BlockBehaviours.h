@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Minicraft/BlockTicks.h"
+
+// Block ticks between lighting TNT and its explosion
+constexpr uint32_t TNT_FUSE_TICKS = 80;
+
+// Sand and gravel fall, TNT explodes when its fuse runs out, grass spreads over lit dirt.
+// Water has its own simulation, see FluidSimulation.
+void RegisterBlockBehaviours(BlockTickScheduler& scheduler);
@@ -0,0 +1,38 @@
+#include "pch.h"
+
+#include "BlockMeshCache.h"
+#include "ChunkMesh.h"
+
+BlockMeshCache& BlockMeshCache::Get() {
+	static BlockMeshCache s_cache;
+	return s_cache;
+}
+
+BlockMeshCache::BlockMeshCache() {
+	for (int id = 0; id < COUNT; id++) {
+		auto& data = BlockData::Get((BlockId)id);
+		firstIndex[id] = (uint32_t)ib.Size();
+		if (data.texIdSide < 0) continue;
+
+		// The same faces as in chunks, so half blocks keep their height
+		for (int face = 0; face < FACE_COUNT; face++)
+			ChunkMesh::AppendBlockFace(vb, ib, (BlockId)id, Vector3::Zero, (BlockFace)face);
+		indexCount[id] = (uint32_t)ib.Size() - firstIndex[id];
+	}
+}
+
+void BlockMeshCache::Create(DeviceResources* deviceRes) {
+	vb.Create(deviceRes);
+	ib.Create(deviceRes);
+}
+
+RenderGeometry BlockMeshCache::GetGeometry(BlockId id) const {
+	RenderGeometry geometry;
+	if (id >= COUNT) return geometry;
+	geometry.vertexBuffer = vb.Get();
+	geometry.stride = sizeof(VertexLayout_PositionNormalUV);
+	geometry.indexBuffer = ib.Get();
+	geometry.start = firstIndex[id];
+	geometry.count = indexCount[id];
+	return geometry;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Engine/Buffers.h"
+#include "Engine/RenderCommands.h"
+#include "Engine/VertexLayout.h"
+#include "Minicraft/Block.h"
+
+// One unit cube per BlockId, all in a single vertex and index buffer built once from BlockData.
+// Cubes are centered on the origin, geometry of a block is a range of the shared index buffer.
+class BlockMeshCache {
+	VertexBuffer<VertexLayout_PositionNormalUV> vb;
+	IndexBuffer ib;
+	uint32_t firstIndex[COUNT] = {};
+	uint32_t indexCount[COUNT] = {};
+
+	BlockMeshCache();
+public:
+	static BlockMeshCache& Get();
+
+	// Uploads the buffers, again after a device loss
+	void Create(DeviceResources* deviceRes);
+	// Empty geometry for blocks without texture
+	RenderGeometry GetGeometry(BlockId id) const;
+};
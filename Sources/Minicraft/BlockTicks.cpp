@@ -0,0 +1,250 @@
+#include "pch.h"
+
+#include "BlockTicks.h"
+#include "Engine/Clock.h"
+#include "Engine/Profiler.h"
+#include "Minicraft/EntityStore.h"
+#include "Minicraft/ExplosionSystem.h"
+
+namespace {
+	constexpr int CHUNK_COUNT = WORLD_SIZE * WORLD_HEIGHT * WORLD_SIZE;
+	constexpr int CHUNKS_PER_JOB = 8;
+
+	bool IsInWorld(int gx, int gy, int gz) {
+		return gx >= 0 && gy >= 0 && gz >= 0
+			&& gx < WORLD_SIZE * CHUNK_SIZE && gy < WORLD_HEIGHT * CHUNK_SIZE && gz < WORLD_SIZE * CHUNK_SIZE;
+	}
+
+	int ChunkIndexOf(int gx, int gy, int gz) {
+		return (gx >> CHUNK_SHIFT) + (gy >> CHUNK_SHIFT) * WORLD_SIZE + (gz >> CHUNK_SHIFT) * WORLD_SIZE * WORLD_HEIGHT;
+	}
+
+	int CellOf(int gx, int gy, int gz) {
+		return (gx & CHUNK_MASK) + ((gy & CHUNK_MASK) << CHUNK_SHIFT) + ((gz & CHUNK_MASK) << (2 * CHUNK_SHIFT));
+	}
+}
+
+void BlockTickContext::Reset(int index, uint64_t currentTick) {
+	chunkIndex = index;
+	cx = index % WORLD_SIZE;
+	cy = (index / WORLD_SIZE) % WORLD_HEIGHT;
+	cz = index / (WORLD_SIZE * WORLD_HEIGHT);
+	chunk = world->GetChunk(cx, cy, cz);
+	tick = currentTick;
+	const uint64_t seed[2] = { currentTick, (uint64_t)index };
+	rng = HashBytes(FNV_OFFSET_BASIS, seed, sizeof(seed)) | 1;
+	scheduledTicks = 0;
+	randomTicks = 0;
+	written.clear();
+	deferred.clear();
+	deferredTicks.clear();
+	falling.clear();
+	explosions.clear();
+}
+
+BlockId BlockTickContext::Get(int gx, int gy, int gz) const {
+	const BlockId* block = world->GetCube(gx, gy, gz);
+	return block ? *block : BEDROCK;
+}
+
+void BlockTickContext::Set(int gx, int gy, int gz, BlockId block) {
+	if (!IsInWorld(gx, gy, gz)) return;
+	if (!IsInChunk(gx, gy, gz)) {
+		deferred.push_back({ gx, gy, gz, block });
+		return;
+	}
+	const int lx = gx & CHUNK_MASK, ly = gy & CHUNK_MASK, lz = gz & CHUNK_MASK;
+	if (*chunk->GetCubeLocal(lx, ly, lz) == block) return;
+	chunk->SetCubeLocal(lx, ly, lz, block);
+	written.push_back({ gx, gy, gz, block });
+}
+
+void BlockTickContext::Schedule(int gx, int gy, int gz, uint32_t delay) {
+	if (!IsInWorld(gx, gy, gz)) return;
+	if (IsInChunk(gx, gy, gz))
+		scheduler->ScheduleCell(chunkIndex, CellOf(gx, gy, gz), delay);
+	else
+		deferredTicks.push_back({ gx, gy, gz, delay });
+}
+
+void BlockTickContext::Fall(int gx, int gy, int gz) {
+	falling.push_back({ gx, gy, gz, Get(gx, gy, gz) });
+	Set(gx, gy, gz, EMPTY);
+}
+
+void BlockTickContext::Explode(int gx, int gy, int gz) {
+	explosions.push_back({ gx, gy, gz, Get(gx, gy, gz) });
+	Set(gx, gy, gz, EMPTY);
+}
+
+BlockTickScheduler::BlockTickScheduler(World* world) : world(world), chunkTicks(CHUNK_COUNT) {
+	// Chunks of a phase share the parity of all three coordinates, so none of them touch
+	for (int cz = 0; cz < WORLD_SIZE; cz++)
+		for (int cy = 0; cy < WORLD_HEIGHT; cy++)
+			for (int cx = 0; cx < WORLD_SIZE; cx++)
+				phaseChunks[(cx & 1) | ((cy & 1) << 1) | ((cz & 1) << 2)].push_back(cx + cy * WORLD_SIZE + cz * WORLD_SIZE * WORLD_HEIGHT);
+}
+
+void BlockTickScheduler::ScheduleCell(int chunkIndex, int cell, uint32_t delay) {
+	auto& ticks = chunkTicks[chunkIndex];
+	if (ticks.pending.test(cell)) return;
+	ticks.pending.set(cell);
+	ticks.queue.push_back({ tick + std::max(delay, 1u), ticks.order++, (uint16_t)cell });
+	std::push_heap(ticks.queue.begin(), ticks.queue.end(), std::greater<ScheduledTick>());
+}
+
+void BlockTickScheduler::Schedule(int gx, int gy, int gz, uint32_t delay) {
+	if (!IsInWorld(gx, gy, gz)) return;
+	ScheduleCell(ChunkIndexOf(gx, gy, gz), CellOf(gx, gy, gz), delay);
+}
+
+void BlockTickScheduler::Clear() {
+	for (auto& ticks : chunkTicks)
+		ticks = ChunkTicks();
+	tick = 0;
+	accumulator = 0;
+}
+
+int BlockTickScheduler::CountPending() const {
+	int pending = 0;
+	for (auto& ticks : chunkTicks)
+		pending += (int)ticks.queue.size();
+	return pending;
+}
+
+void BlockTickScheduler::OnBlockChanged(int gx, int gy, int gz, BlockId block) {
+	static const int offsets[7][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	for (auto& offset : offsets) {
+		const int x = gx + offset[0], y = gy + offset[1], z = gz + offset[2];
+		const BlockId* neighbour = world->GetCube(x, y, z);
+		if (!neighbour) continue;
+		const uint32_t delay = handlers[*neighbour].delay;
+		if (delay) Schedule(x, y, z, delay);
+	}
+}
+
+void BlockTickScheduler::Update(float dt, JobSystem* jobs) {
+	accumulator += dt;
+	while (accumulator >= 1.0f / TICKS_PER_SECOND) {
+		accumulator -= 1.0f / TICKS_PER_SECOND;
+		Tick(jobs);
+	}
+}
+
+void BlockTickScheduler::Tick(JobSystem* jobs) {
+	PROFILE_ZONE("BlockTickScheduler::Tick");
+	auto& clock = DX::SystemClock::Get();
+	const uint64_t start = clock.GetCounter();
+
+	tick++;
+	stats = BlockTickStats();
+	stats.tick = tick;
+
+	for (auto& chunks : phaseChunks) {
+		active.clear();
+		for (int idx : chunks) {
+			const auto& ticks = chunkTicks[idx];
+			const Chunk* chunk = world->chunks[idx];
+			if (!chunk->IsLoaded()) continue;
+			const bool due = !ticks.queue.empty() && ticks.queue.front().due <= tick;
+			if (due || (randomTickRate > 0 && !chunk->GetSummary().IsEmpty()))
+				active.push_back(idx);
+		}
+		if (active.empty()) continue;
+
+		const int count = (int)active.size();
+		if ((int)contexts.size() < count) {
+			contexts.resize(count);
+			for (auto& ctx : contexts) {
+				ctx.scheduler = this;
+				ctx.world = world;
+			}
+		}
+		auto run = [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				contexts[i].Reset(active[i], tick);
+				RunChunk(contexts[i]);
+			}
+		};
+		if (jobs)
+			jobs->ParallelFor(count, CHUNKS_PER_JOB, run);
+		else
+			run(0, count);
+		FinishPhase(count);
+	}
+
+	stats.pendingTicks = CountPending();
+	stats.tickMs = clock.MillisecondsSince(start);
+}
+
+void BlockTickScheduler::RunChunk(BlockTickContext& ctx) {
+	auto& ticks = chunkTicks[ctx.chunkIndex];
+	const int x0 = ctx.cx << CHUNK_SHIFT, y0 = ctx.cy << CHUNK_SHIFT, z0 = ctx.cz << CHUNK_SHIFT;
+
+	auto run = [&](int cell, bool scheduled) {
+		const int lx = cell & CHUNK_MASK, ly = (cell >> CHUNK_SHIFT) & CHUNK_MASK, lz = cell >> (2 * CHUNK_SHIFT);
+		const auto& handler = handlers[*ctx.chunk->GetCubeLocal(lx, ly, lz)];
+		const BlockTickFn fn = scheduled ? handler.scheduled : handler.random;
+		if (!fn) return;
+		fn(ctx, x0 + lx, y0 + ly, z0 + lz);
+		(scheduled ? ctx.scheduledTicks : ctx.randomTicks)++;
+	};
+
+	// New ticks are due next tick at the earliest, so this ends
+	while (!ticks.queue.empty() && ticks.queue.front().due <= ctx.tick) {
+		std::pop_heap(ticks.queue.begin(), ticks.queue.end(), std::greater<ScheduledTick>());
+		const int cell = ticks.queue.back().cell;
+		ticks.queue.pop_back();
+		ticks.pending.reset(cell);
+		run(cell, true);
+	}
+
+	if (ctx.chunk->GetSummary().IsEmpty()) return;
+	for (int i = 0; i < randomTickRate; i++)
+		run(ctx.Random() & (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE - 1), false);
+}
+
+void BlockTickScheduler::FinishPhase(int contextCount) {
+	WorldEditBatch batch(world);
+	for (int i = 0; i < contextCount; i++) {
+		auto& ctx = contexts[i];
+		stats.activeChunks++;
+		stats.scheduledTicks += ctx.scheduledTicks;
+		stats.randomTicks += ctx.randomTicks;
+		stats.edits += (int)(ctx.written.size() + ctx.deferred.size());
+
+		// Reported back to OnBlockChanged like any other edit, which schedules the blocks around
+		batch.CommitWritten(ctx.written);
+		for (auto& edit : ctx.deferred)
+			batch.Set(edit.x, edit.y, edit.z, edit.block);
+		for (auto& deferred : ctx.deferredTicks)
+			Schedule(deferred.x, deferred.y, deferred.z, deferred.delay);
+	}
+	batch.Commit();
+
+	// Falling blocks see the world as the phase left it, explosions go off in the next wave of the explosion system
+	for (int i = 0; i < contextCount; i++) {
+		for (auto& block : contexts[i].falling)
+			Drop(block, batch);
+		if (!explosions) continue;
+		for (auto& source : contexts[i].explosions)
+			explosions->Detonate(source.x, source.y, source.z, TNT_POWER);
+	}
+	batch.Commit();
+}
+
+void BlockTickScheduler::Drop(const BlockEdit& block, WorldEditBatch& batch) {
+	if (entities) {
+		entities->Spawn(ET_FALLING_BLOCK, Vector3((float)block.x, (float)block.y, (float)block.z), Vector3::Zero, Vector3(0.49f, 0.49f, 0.49f), block.block);
+		return;
+	}
+	// Lands right away, committed one by one so blocks falling down the same column stack up
+	int y = block.y;
+	while (true) {
+		const BlockId* below = world->GetCube(block.x, y - 1, block.z);
+		if (!below || (*below != EMPTY && *below != WATER)) break;
+		y--;
+	}
+	batch.Set(block.x, y, block.z, block.block);
+	batch.Commit();
+}
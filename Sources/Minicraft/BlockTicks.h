@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Engine/JobSystem.h"
+#include "Minicraft/Block.h"
+#include "Minicraft/Chunk.h"
+#include "Minicraft/World.h"
+#include "Minicraft/WorldEditBatch.h"
+
+class BlockTickContext;
+typedef void (*BlockTickFn)(BlockTickContext& ctx, int gx, int gy, int gz);
+
+struct BlockTickHandler {
+	BlockTickFn scheduled = nullptr; // a tick scheduled on the block is due
+	BlockTickFn random = nullptr;    // the block was picked by the random ticks of its chunk
+	uint32_t delay = 0;              // ticks from a change next to the block to its scheduled tick, 0 ignores changes
+};
+
+// Counters of the last block tick, except tick
+struct BlockTickStats {
+	uint64_t tick = 0;
+	int scheduledTicks = 0;
+	int randomTicks = 0;
+	int pendingTicks = 0;
+	int activeChunks = 0;
+	int edits = 0;
+	double tickMs = 0;
+};
+
+class BlockTickScheduler;
+// What a handler can do while its chunk ticks. Reads reach at most one chunk away: chunks ticking together
+// are never neighbours, so nothing read is being written. Writes and schedules inside the ticking chunk apply
+// right away, the others wait for the end of the phase like falling blocks and explosions.
+class BlockTickContext {
+	struct DeferredTick {
+		int x, y, z;
+		uint32_t delay;
+	};
+	BlockTickScheduler* scheduler = nullptr;
+	World* world = nullptr;
+	Chunk* chunk = nullptr;
+	int chunkIndex = 0;
+	int cx = 0, cy = 0, cz = 0;
+	uint64_t tick = 0;
+	uint32_t rng = 0;
+	int scheduledTicks = 0;
+	int randomTicks = 0;
+
+	std::vector<BlockEdit> written;  // already in the chunk, reported at the end of the phase
+	std::vector<BlockEdit> deferred; // other chunks
+	std::vector<DeferredTick> deferredTicks;
+	std::vector<BlockEdit> falling;
+	std::vector<BlockEdit> explosions;
+
+	bool IsInChunk(int gx, int gy, int gz) const {
+		return (gx >> CHUNK_SHIFT) == cx && (gy >> CHUNK_SHIFT) == cy && (gz >> CHUNK_SHIFT) == cz;
+	}
+	void Reset(int chunkIndex, uint64_t tick);
+	friend class BlockTickScheduler;
+public:
+	// Outside of the world and unloaded chunks read as BEDROCK, so nothing flows or falls out
+	BlockId Get(int gx, int gy, int gz) const;
+	void Set(int gx, int gy, int gz, BlockId block);
+	void Schedule(int gx, int gy, int gz, uint32_t delay);
+	// Removes the block, it falls as an entity, or straight to where it lands without an entity store
+	void Fall(int gx, int gy, int gz);
+	// Removes the block and blows up what is around on the next explosion tick
+	void Explode(int gx, int gy, int gz);
+
+	uint64_t GetTick() const { return tick; }
+	// Deterministic per chunk and tick, whatever the thread running it
+	uint32_t Random() {
+		rng ^= rng << 13;
+		rng ^= rng >> 17;
+		rng ^= rng << 5;
+		return rng;
+	}
+};
+
+class EntityStore;
+class ExplosionSystem;
+// Block simulation at a fixed 20 ticks per second: per-chunk queues of scheduled ticks and a few random ticks per
+// chunk. Chunks tick in 8 phases by coordinate parity, each phase in parallel on the job system without locks.
+// Every block written through the world is reported to the scheduler, which schedules the handlers around it.
+class BlockTickScheduler : public IBlockListener {
+	struct ScheduledTick {
+		uint64_t due;
+		uint32_t order; // first scheduled first among ticks due together
+		uint16_t cell;
+
+		// With std::greater the heap keeps the tick due first on top
+		bool operator>(const ScheduledTick& other) const {
+			return due != other.due ? due > other.due : order > other.order;
+		}
+	};
+	struct ChunkTicks {
+		std::vector<ScheduledTick> queue; // min heap on due then order
+		std::bitset<CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE> pending;
+		uint32_t order = 0;
+	};
+
+	World* world;
+	EntityStore* entities = nullptr;
+	ExplosionSystem* explosions = nullptr;
+	BlockTickHandler handlers[COUNT] = {};
+	std::vector<ChunkTicks> chunkTicks;
+	std::vector<int> phaseChunks[8];
+	std::vector<int> active;
+	std::vector<BlockTickContext> contexts;
+	uint64_t tick = 0;
+	float accumulator = 0;
+	int randomTickRate = 3;
+
+	void ScheduleCell(int chunkIndex, int cell, uint32_t delay);
+	void RunChunk(BlockTickContext& ctx);
+	// Serial: applies what the contexts of a phase deferred, in chunk order
+	void FinishPhase(int contextCount);
+	void Drop(const BlockEdit& block, WorldEditBatch& batch);
+
+	friend class BlockTickContext;
+public:
+	static constexpr int TICKS_PER_SECOND = 20;
+
+	BlockTickStats stats;
+
+	explicit BlockTickScheduler(World* world);
+
+	void Register(BlockId block, const BlockTickHandler& handler) { handlers[block] = handler; }
+	const BlockTickHandler& GetHandler(BlockId block) const { return handlers[block]; }
+	// Falling blocks spawn there when set
+	void SetEntityStore(EntityStore* store) { entities = store; }
+	// Exploding blocks go off there, without one they only vanish
+	void SetExplosionSystem(ExplosionSystem* system) { explosions = system; }
+	// Blocks picked at random per chunk and tick, 0 disables random ticks
+	void SetRandomTickRate(int blocksPerChunk) { randomTickRate = blocksPerChunk; }
+
+	// From the thread owning the world only, ignored if the block already has a tick pending
+	void Schedule(int gx, int gy, int gz, uint32_t delay);
+	void Clear();
+	int CountPending() const;
+
+	// Runs the fixed ticks due after dt more seconds, without jobs everything runs on the calling thread
+	void Update(float dt, JobSystem* jobs);
+	void Tick(JobSystem* jobs);
+
+	void OnBlockChanged(int gx, int gy, int gz, BlockId block) override;
+};
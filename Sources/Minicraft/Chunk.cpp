@@ -1,105 +1,148 @@
 #include "pch.h"
 
+#include "Engine/Profiler.h"
 #include "Chunk.h"
-#include "Utils.h"
+#include "ChunkOccupancy.h"
+#include "ChunkSnapshot.h"
 
-Chunk::Chunk(World* world, Vector3 pos) {
-	memset(data, EMPTY, sizeof(data));
+namespace {
+	std::atomic<uint64_t> cloneCount = 0;
+}
+
+Chunk::Chunk(World* world, Vector3 pos) : storage(new ChunkBlocks()) {
+	data = storage->blocks;
+	memset(data, EMPTY, sizeof(storage->blocks));
 
 	this->world = world;
 	model = Matrix::CreateTranslation(pos);
 	bounds = DirectX::BoundingBox(pos + Vector3(CHUNK_SIZE / 2 - 0.5, CHUNK_SIZE / 2 - 0.5, CHUNK_SIZE / 2 - 0.5), Vector3(CHUNK_SIZE / 2, CHUNK_SIZE / 2, CHUNK_SIZE / 2));
 }
 
-BlockId* Chunk::GetCubeLocal(int lx, int ly, int lz) {
-	if (lx < 0) return adjXNeg ? adjXNeg->GetCubeLocal(CHUNK_SIZE - 1, ly, lz) : nullptr;
-	if (ly < 0) return adjYNeg ? adjYNeg->GetCubeLocal(lx, CHUNK_SIZE - 1, lz) : nullptr;
-	if (lz < 0) return adjZNeg ? adjZNeg->GetCubeLocal(lx, ly, CHUNK_SIZE - 1) : nullptr;
-	if (lx >= CHUNK_SIZE) return adjXPos ? adjXPos->GetCubeLocal(0, ly, lz) : nullptr;
-	if (ly >= CHUNK_SIZE) return adjYPos ? adjYPos->GetCubeLocal(lx, 0, lz) : nullptr;
-	if (lz >= CHUNK_SIZE) return adjZPos ? adjZPos->GetCubeLocal(lx, ly, 0) : nullptr;
-	return &data[lx + ly * CHUNK_SIZE + lz * CHUNK_SIZE * CHUNK_SIZE];
+Chunk::~Chunk() {
+	storage->Release();
 }
 
-void Chunk::PushCube(int x, int y, int z) {
-	auto blockId = GetCubeLocal(x, y, z);
-
-	auto& data = BlockData::Get(*blockId);
-	float uvxSide = (data.texIdSide % 16) / BLOCK_TEXSIZE;
-	float uvySide = (data.texIdSide / 16) / BLOCK_TEXSIZE;
-
-	float scaleY = (data.flags & BF_HALF_BLOCK) ? 0.5f : 1.0f;
-	if (ShouldRenderFace(x, y, z, 0, 0, 1)) PushFace({ -0.5f + x, -0.5f + y, 0.5f + z }, Vector3::Up, Vector3::Right, Vector3::Backward, data.texIdSide, data.pass, scaleY);
-	if (ShouldRenderFace(x, y, z, 1, 0, 0)) PushFace({ 0.5f + x, -0.5f + y, 0.5f + z }, Vector3::Up, Vector3::Forward, Vector3::Right, data.texIdSide, data.pass, scaleY);
-	if (ShouldRenderFace(x, y, z, 0, 0,-1)) PushFace({ 0.5f + x, -0.5f + y,-0.5f + z }, Vector3::Up, Vector3::Left, Vector3::Forward, data.texIdSide, data.pass, scaleY);
-	if (ShouldRenderFace(x, y, z,-1, 0, 0)) PushFace({ -0.5f + x, -0.5f + y,-0.5f + z }, Vector3::Up, Vector3::Backward, Vector3::Left, data.texIdSide, data.pass, scaleY);
-	if (scaleY != 1.0f || ShouldRenderFace(x, y, z, 0, 1, 0)) PushFace({ -0.5f + x, (scaleY - 0.5f) + y, 0.5f + z }, Vector3::Forward, Vector3::Right, Vector3::Up, data.texIdTop, data.pass);
-	if (ShouldRenderFace(x, y, z, 0,-1, 0)) PushFace({ -0.5f + x, -0.5f + y,-0.5f + z }, Vector3::Backward, Vector3::Right, Vector3::Down, data.texIdBottom, data.pass);
+uint64_t Chunk::GetCloneCount() {
+	return cloneCount.load(std::memory_order_relaxed);
 }
 
-void Chunk::PushFace(Vector3 pos, Vector3 up, Vector3 right, Vector3 normal, int id, ShaderPass pass, float scaleY) {
-	Vector2 uv(
-		(id % 16) * BLOCK_TEXSIZE,
-		(id / 16) * BLOCK_TEXSIZE
-	);
-
-	auto a = vb[pass].PushVertex({ ToVec4(pos), ToVec4Normal(normal), uv + Vector2::UnitY * BLOCK_TEXSIZE * scaleY });
-	auto b = vb[pass].PushVertex({ ToVec4(pos + up * scaleY), ToVec4Normal(normal), uv });
-	auto c = vb[pass].PushVertex({ ToVec4(pos + right), ToVec4Normal(normal), uv + Vector2::UnitX * BLOCK_TEXSIZE + Vector2::UnitY * BLOCK_TEXSIZE * scaleY });
-	auto d = vb[pass].PushVertex({ ToVec4(pos + up * scaleY + right), ToVec4Normal(normal), uv + Vector2::UnitX * BLOCK_TEXSIZE });
-	ib[pass].PushTriangle(a, b, c);
-	ib[pass].PushTriangle(c, b, d);
+void Chunk::BeginWrite() {
+	version++;
+	if (!storage->IsShared()) return;
+	// Snapshots keep the old storage, they release it on whichever thread they are dropped
+	ChunkBlocks* clone = new ChunkBlocks();
+	memcpy(clone->blocks, storage->blocks, sizeof(clone->blocks));
+	storage->Release();
+	storage = clone;
+	data = storage->blocks;
+	cloneCount.fetch_add(1, std::memory_order_relaxed);
 }
 
-bool Chunk::ShouldRenderFace(int lx, int ly, int lz, int dx, int dy, int dz) {
-	auto neighbour = GetCubeLocal(lx + dx, ly + dy, lz + dz);
-	if (!neighbour) return true;
-	auto myself = GetCubeLocal(lx, ly, lz);
+const BlockId* Chunk::GetCubeLocal(int lx, int ly, int lz) const {
+	if (lx < 0) return IfLoaded(adjXNeg) ? adjXNeg->GetCubeLocal(CHUNK_SIZE - 1, ly, lz) : nullptr;
+	if (ly < 0) return IfLoaded(adjYNeg) ? adjYNeg->GetCubeLocal(lx, CHUNK_SIZE - 1, lz) : nullptr;
+	if (lz < 0) return IfLoaded(adjZNeg) ? adjZNeg->GetCubeLocal(lx, ly, CHUNK_SIZE - 1) : nullptr;
+	if (lx >= CHUNK_SIZE) return IfLoaded(adjXPos) ? adjXPos->GetCubeLocal(0, ly, lz) : nullptr;
+	if (ly >= CHUNK_SIZE) return IfLoaded(adjYPos) ? adjYPos->GetCubeLocal(lx, 0, lz) : nullptr;
+	if (lz >= CHUNK_SIZE) return IfLoaded(adjZPos) ? adjZPos->GetCubeLocal(lx, ly, 0) : nullptr;
+	return &data[lx + ly * CHUNK_SIZE + lz * CHUNK_SIZE * CHUNK_SIZE];
+}
 
-	const BlockData& myData = BlockData::Get(*myself);
-	const BlockData& neighData = BlockData::Get(*neighbour);
+void Chunk::SetCubeLocal(int lx, int ly, int lz, BlockId id) {
+	const int index = lx + ly * CHUNK_SIZE + lz * CHUNK_SIZE * CHUNK_SIZE;
+	if (data[index] == id) return;
+	BeginWrite();
+	auto& block = data[index];
+	CountBlock(block, lx, ly, lz, -1);
+	CountBlock(id, lx, ly, lz, 1);
+	UpdateSolidity(id, lx, ly, lz);
+	block = id;
+}
 
-	if (neighData.flags & BF_HALF_BLOCK)
-		return true;
+void Chunk::CountBlock(BlockId id, int lx, int ly, int lz, int delta) {
+	if (id == EMPTY) return;
+	summary.blockCount += delta;
+	if (ChunkOccupancy::GetClass(id) != OC_OPAQUE) return;
+
+	summary.opaqueCount += delta;
+	if (lx == 0) summary.faceOpaqueCount[FACE_X_NEG] += delta;
+	if (ly == 0) summary.faceOpaqueCount[FACE_Y_NEG] += delta;
+	if (lz == 0) summary.faceOpaqueCount[FACE_Z_NEG] += delta;
+	if (lx == CHUNK_SIZE - 1) summary.faceOpaqueCount[FACE_X_POS] += delta;
+	if (ly == CHUNK_SIZE - 1) summary.faceOpaqueCount[FACE_Y_POS] += delta;
+	if (lz == CHUNK_SIZE - 1) summary.faceOpaqueCount[FACE_Z_POS] += delta;
+}
 
-	if (neighData.flags & BF_CUTOUT)
-		return !(myData.flags & BF_CUTOUT);
+void Chunk::UpdateSolidity(BlockId id, int lx, int ly, int lz) {
+	const uint16_t bit = (uint16_t)(1u << lx);
+	const int row = ly + lz * CHUNK_SIZE;
+	const uint64_t flags = BlockData::Get(id).flags;
+	if (flags & BF_NO_PHYSICS) solidRows[row] &= ~bit;
+	else solidRows[row] |= bit;
+	if (flags & BF_HALF_BLOCK) halfRows[row] |= bit;
+	else halfRows[row] &= ~bit;
+}
 
-	bool isNeighTransp = neighData.pass == SP_TRANSPARENT;
-	if (isNeighTransp) {
-		bool isTransp = myData.pass == SP_TRANSPARENT;
-		return !isTransp;
+void Chunk::RebuildSummary() {
+	summary = ChunkSummary();
+	for (int z = 0; z < CHUNK_SIZE; z++) {
+		for (int y = 0; y < CHUNK_SIZE; y++) {
+			for (int x = 0; x < CHUNK_SIZE; x++) {
+				const BlockId id = data[x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE];
+				CountBlock(id, x, y, z, 1);
+				UpdateSolidity(id, x, y, z);
+			}
+		}
 	}
+}
 
-	return *neighbour == EMPTY;
+bool Chunk::IsBuried() const {
+	if (!summary.IsAllOpaque()) return false;
+	return IfLoaded(adjXNeg) && adjXNeg->summary.IsFaceOpaque(FACE_X_POS)
+		&& IfLoaded(adjXPos) && adjXPos->summary.IsFaceOpaque(FACE_X_NEG)
+		&& IfLoaded(adjYNeg) && adjYNeg->summary.IsFaceOpaque(FACE_Y_POS)
+		&& IfLoaded(adjYPos) && adjYPos->summary.IsFaceOpaque(FACE_Y_NEG)
+		&& IfLoaded(adjZNeg) && adjZNeg->summary.IsFaceOpaque(FACE_Z_POS)
+		&& IfLoaded(adjZPos) && adjZPos->summary.IsFaceOpaque(FACE_Z_NEG);
 }
 
 void Chunk::Generate(DeviceResources* deviceRes) {
-	for (int pass = SP_OPAQUE; pass < SP_COUNT; pass++) {
-		vb[pass].Clear();
-		ib[pass].Clear();
-	}
+	PROFILE_ZONE("Chunk::Generate");
 
-	for (int x = 0; x < CHUNK_SIZE; x++) {
-		for (int z = 0; z < CHUNK_SIZE; z++) {
-			for (int y = 0; y < CHUNK_SIZE; y++) {
-				auto block = GetCubeLocal(x, y, z);
-				if (EMPTY == *block) continue;
-				PushCube(x, y, z);
-			}
-		}
+	needRegen = false;
+	rebuildUrgent = false;
+	meshRequest++;
+
+	ChunkSnapshot snapshot;
+	auto result = PrepareMesh(snapshot);
+	if (result == CMR_MESHED) {
+		mesh.Build(snapshot);
+	} else {
+		mesh.Clear();
 	}
+	mesh.Create(deviceRes);
+	world->CountMeshResult(result);
+}
 
-	for (int pass = SP_OPAQUE; pass < SP_COUNT; pass++) {
-		vb[pass].Create(deviceRes);
-		ib[pass].Create(deviceRes);
-	}
-	needRegen = false;
+ChunkMeshResult Chunk::PrepareMesh(ChunkSnapshot& snapshot) const {
+	if (summary.IsEmpty()) return CMR_EMPTY;
+	if (IsBuried()) return CMR_BURIED;
+	snapshot.Capture(this);
+	return CMR_MESHED;
 }
 
-void Chunk::Draw(DeviceResources* deviceRes, ShaderPass pass) {
-	if (vb[pass].Size() == 0) return;
-	vb[pass].Apply(deviceRes, 0);
-	ib[pass].Apply(deviceRes);
-	deviceRes->GetD3DDeviceContext()->DrawIndexed(ib[pass].Size(), 0, 0);
+ChunkMeshResult Chunk::PrepareMesh(ChunkMeshSource& source) const {
+	if (summary.IsEmpty()) return CMR_EMPTY;
+	if (IsBuried()) return CMR_BURIED;
+	const Chunk* neighbours[FACE_COUNT];
+	neighbours[FACE_X_NEG] = IfLoaded(adjXNeg);
+	neighbours[FACE_X_POS] = IfLoaded(adjXPos);
+	neighbours[FACE_Y_NEG] = IfLoaded(adjYNeg);
+	neighbours[FACE_Y_POS] = IfLoaded(adjYPos);
+	neighbours[FACE_Z_NEG] = IfLoaded(adjZNeg);
+	neighbours[FACE_Z_POS] = IfLoaded(adjZPos);
+	source.blocks = TakeSnapshot();
+	for (int face = 0; face < FACE_COUNT; face++)
+		source.neighbours[face] = neighbours[face] ? neighbours[face]->TakeSnapshot() : ChunkBlocksSnapshot();
+	return CMR_MESHED;
 }
\ No newline at end of file
@@ -4,15 +4,76 @@
 #include "Engine/VertexLayout.h"
 #include "Minicraft/World.h"
 #include "Minicraft/Block.h"
+#include "Minicraft/ChunkMesh.h"
 
 #define CHUNK_SIZE 16
+// Global to chunk coordinates with shifts and masks, which also floor negative coordinates
+#define CHUNK_SHIFT 4
+#define CHUNK_MASK (CHUNK_SIZE - 1)
+static_assert(CHUNK_SIZE == 1 << CHUNK_SHIFT, "CHUNK_SIZE must be 1 << CHUNK_SHIFT");
+
+// Block counts kept up to date on every write, used to skip meshing chunks that can't produce faces
+struct ChunkSummary {
+	int blockCount = 0;
+	int opaqueCount = 0;
+	int faceOpaqueCount[FACE_COUNT] = {}; // opaque blocks on the border layer facing each direction
+
+	bool IsEmpty() const { return blockCount == 0; }
+	bool IsAllOpaque() const { return opaqueCount == CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE; }
+	bool IsFaceOpaque(BlockFace face) const { return faceOpaqueCount[face] == CHUNK_SIZE * CHUNK_SIZE; }
+};
+
+// Blocks of a chunk, shared by the chunk and the snapshots taken since its last write
+struct ChunkBlocks {
+	std::atomic<int> refs = 1;
+	BlockId blocks[CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE];
+
+	void Retain() { refs.fetch_add(1, std::memory_order_relaxed); }
+	void Release() {
+		if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+	}
+	// Acquire pairs with the release of the other holders, whatever they read is done once they let go
+	bool IsShared() const { return refs.load(std::memory_order_acquire) > 1; }
+};
+
+// Immutable blocks of a chunk at one version, cheap to take and to copy: no block is copied until the chunk
+// is written while a snapshot is held. Can be read and released from any thread.
+class ChunkBlocksSnapshot {
+	ChunkBlocks* storage = nullptr;
+	uint32_t version = 0;
+public:
+	ChunkBlocksSnapshot() = default;
+	ChunkBlocksSnapshot(ChunkBlocks* storage, uint32_t version) : storage(storage), version(version) { storage->Retain(); }
+	ChunkBlocksSnapshot(const ChunkBlocksSnapshot& other) : storage(other.storage), version(other.version) { if (storage) storage->Retain(); }
+	ChunkBlocksSnapshot(ChunkBlocksSnapshot&& other) noexcept : storage(other.storage), version(other.version) { other.storage = nullptr; }
+	ChunkBlocksSnapshot& operator=(ChunkBlocksSnapshot other) noexcept {
+		std::swap(storage, other.storage);
+		version = other.version;
+		return *this;
+	}
+	~ChunkBlocksSnapshot() { if (storage) storage->Release(); }
+
+	bool IsValid() const { return storage != nullptr; }
+	uint32_t GetVersion() const { return version; }
+	const BlockId* GetBlocks() const { return storage->blocks; }
+	BlockId Get(int lx, int ly, int lz) const { return storage->blocks[lx + ly * CHUNK_SIZE + lz * CHUNK_SIZE * CHUNK_SIZE]; }
+};
+
 class World;
+struct ChunkSnapshot;
+struct ChunkMeshSource;
 class Chunk {
-	BlockId data[CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE];
+	// Copy on write: a write while snapshots hold the storage clones it first
+	ChunkBlocks* storage;
+	BlockId* data; // storage->blocks
+	uint32_t version = 0;
 	World* world;
 
-	VertexBuffer<VertexLayout_PositionNormalUV> vb[SP_COUNT];
-	IndexBuffer ib[SP_COUNT];
+	ChunkMesh mesh;
+	ChunkSummary summary;
+	// Bit lx of row ly + lz * CHUNK_SIZE is set for blocks with physics, half blocks are in both sets
+	uint16_t solidRows[CHUNK_SIZE * CHUNK_SIZE] = {};
+	uint16_t halfRows[CHUNK_SIZE * CHUNK_SIZE] = {};
 
 	Chunk* adjXPos = nullptr;
 	Chunk* adjXNeg = nullptr;
@@ -20,21 +81,60 @@ class Chunk {
 	Chunk* adjYNeg = nullptr;
 	Chunk* adjZPos = nullptr;
 	Chunk* adjZNeg = nullptr;
+
+	// Cleared while a loading job writes the terrain, then only the thread owning the world touches the chunk
+	std::atomic<bool> loaded = true;
+	// Set once the chunk got its first mesh request, rebuilds are pointless before that
+	bool firstMeshQueued = true;
+	// Bumped by every mesh request so a mesh built off-thread from an older snapshot can be dropped
+	uint32_t meshRequest = 0;
 public:
 	Matrix model;
 	DirectX::BoundingBox bounds;
 	bool needRegen = false;
+	// Set while queued for a rebuild the player is waiting on, read by the rebuild scheduler when it sorts
+	bool rebuildUrgent = false;
 
 	Chunk(World* world, Vector3 pos);
+	~Chunk();
+	Chunk(const Chunk&) = delete;
+	Chunk& operator=(const Chunk&) = delete;
 
 	void Generate(DeviceResources* deviceRes);
-	void Draw(DeviceResources* deviceRes, ShaderPass pass);
+	// Captures what the mesher needs when there is something to mesh, can then be built on any thread
+	ChunkMeshResult PrepareMesh(ChunkSnapshot& snapshot) const;
+	// Same check, but only holds the blocks and leaves the copy to the thread building the mesh.
+	// From the thread owning the world, like TakeSnapshot.
+	ChunkMeshResult PrepareMesh(ChunkMeshSource& source) const;
+	bool IsLoaded() const { return loaded.load(std::memory_order_acquire); }
+
+	const BlockId* GetCubeLocal(int lx, int ly, int lz) const;
+	void SetCubeLocal(int lx, int ly, int lz, BlockId id);
+
+	// Bumped by every write, data derived from the blocks is stale once its version differs
+	uint32_t GetVersion() const { return version; }
+	// From the thread owning the world, like writes
+	ChunkBlocksSnapshot TakeSnapshot() const { return ChunkBlocksSnapshot(storage, version); }
+	// Storages cloned by writes over a snapshot, since startup
+	static uint64_t GetCloneCount();
 
-	BlockId* GetCubeLocal(int lx, int ly, int lz);
+	const ChunkSummary& GetSummary() const { return summary; }
+	void RebuildSummary();
+	// All opaque and walled in by opaque neighbour faces: nothing inside can ever be seen
+	bool IsBuried() const;
+	bool HasGeometry() { return mesh.HasGeometry(); }
 private:
-	void PushCube(int x, int y, int z);
-	void PushFace(Vector3 pos, Vector3 up, Vector3 right, Vector3 normal, int id, ShaderPass pass, float scaleY = 1.0f);
-	bool ShouldRenderFace(int lx, int ly, int lz, int dx, int dy, int dz);
+	// Before any write: clones the storage when a snapshot holds it, and bumps the version
+	void BeginWrite();
+	void CountBlock(BlockId id, int lx, int ly, int lz, int delta);
+	void UpdateSolidity(BlockId id, int lx, int ly, int lz);
+	// Neighbours still loading are treated like world edges
+	static const Chunk* IfLoaded(const Chunk* chunk) { return chunk && chunk->IsLoaded() ? chunk : nullptr; }
 
 	friend class World;
-};
\ No newline at end of file
+	friend struct ChunkSnapshot;
+	friend class WorldEditBatch;
+	friend class WorldServer;
+	friend class VoxelCursor;
+	friend class VoxelCollider;
+};
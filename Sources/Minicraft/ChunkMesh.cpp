@@ -0,0 +1,208 @@
+#include "pch.h"
+
+#include "ChunkMesh.h"
+#include "ChunkOccupancy.h"
+#include "ChunkSnapshot.h"
+#include "Utils.h"
+
+namespace {
+	// ShouldRenderFace for every pair of blocks, so the scalar mesher does a single lookup per face
+	struct FaceVisibilityTable {
+		bool visible[COUNT + 1][COUNT + 1];
+
+		FaceVisibilityTable() {
+			for (int my = 0; my <= COUNT; my++)
+				for (int neigh = 0; neigh <= COUNT; neigh++)
+					visible[my][neigh] = ChunkMesh::ShouldRenderFace((BlockId)my, (BlockId)neigh);
+		}
+	};
+
+	const FaceVisibilityTable& GetFaceVisibility() {
+		static const FaceVisibilityTable table;
+		return table;
+	}
+
+	const int faceOffsets[FACE_COUNT] = {
+		ChunkSnapshot::STRIDE_Z,
+		ChunkSnapshot::STRIDE_X,
+		-ChunkSnapshot::STRIDE_Z,
+		-ChunkSnapshot::STRIDE_X,
+		ChunkSnapshot::STRIDE_Y,
+		-ChunkSnapshot::STRIDE_Y,
+	};
+
+	template<typename TEmit>
+	void ForEachVisibleFaceScalar(const ChunkSnapshot& snapshot, TEmit&& emit) {
+		auto& visibility = GetFaceVisibility().visible;
+		for (int x = 0; x < CHUNK_SIZE; x++) {
+			for (int z = 0; z < CHUNK_SIZE; z++) {
+				for (int y = 0; y < CHUNK_SIZE; y++) {
+					const int idx = ChunkSnapshot::Index(x, y, z);
+					const BlockId blockId = snapshot.blocks[idx];
+					if (EMPTY == blockId) continue;
+
+					const bool* visible = visibility[blockId];
+					bool isHalf = BlockData::Get(blockId).flags & BF_HALF_BLOCK;
+					for (int face = 0; face < FACE_COUNT; face++) {
+						if ((face == FACE_Y_POS && isHalf) || visible[snapshot.blocks[idx + faceOffsets[face]]])
+							emit(blockId, x, y, z, (BlockFace)face);
+					}
+				}
+			}
+		}
+	}
+
+	// A face is hidden by an opaque neighbour, or by a neighbour of the same cutout/transparent class.
+	// Empty and half block neighbours never hide anything.
+	inline uint32_t VisibleFaces(const uint32_t* my, uint32_t opaque, uint32_t cutout, uint32_t transparent) {
+		uint32_t solid = my[OC_OPAQUE] | my[OC_CUTOUT] | my[OC_TRANSPARENT] | my[OC_HALF_BLOCK];
+		uint32_t hidden = opaque | (my[OC_CUTOUT] & cutout) | (my[OC_TRANSPARENT] & transparent);
+		return solid & ~hidden & ChunkOccupancy::INTERIOR_MASK;
+	}
+
+	template<typename TEmit>
+	void ForEachVisibleFaceBinary(const ChunkSnapshot& snapshot, const ChunkOccupancy& occupancy, TEmit&& emit) {
+		auto& rows = occupancy.rows;
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			for (int y = 0; y < CHUNK_SIZE; y++) {
+				const int row = ChunkOccupancy::RowIndex(y, z);
+				const uint32_t my[OC_COUNT] = { rows[OC_OPAQUE][row], rows[OC_CUTOUT][row], rows[OC_TRANSPARENT][row], rows[OC_HALF_BLOCK][row] };
+				if (!(my[OC_OPAQUE] | my[OC_CUTOUT] | my[OC_TRANSPARENT] | my[OC_HALF_BLOCK])) continue;
+
+				uint32_t faces[FACE_COUNT];
+				const int neighbourRows[] = {
+					ChunkOccupancy::RowIndex(y, z + 1),
+					ChunkOccupancy::RowIndex(y, z - 1),
+					ChunkOccupancy::RowIndex(y + 1, z),
+					ChunkOccupancy::RowIndex(y - 1, z),
+				};
+				faces[FACE_Z_POS] = VisibleFaces(my, rows[OC_OPAQUE][neighbourRows[0]], rows[OC_CUTOUT][neighbourRows[0]], rows[OC_TRANSPARENT][neighbourRows[0]]);
+				faces[FACE_Z_NEG] = VisibleFaces(my, rows[OC_OPAQUE][neighbourRows[1]], rows[OC_CUTOUT][neighbourRows[1]], rows[OC_TRANSPARENT][neighbourRows[1]]);
+				faces[FACE_Y_POS] = VisibleFaces(my, rows[OC_OPAQUE][neighbourRows[2]], rows[OC_CUTOUT][neighbourRows[2]], rows[OC_TRANSPARENT][neighbourRows[2]]) | (my[OC_HALF_BLOCK] & ChunkOccupancy::INTERIOR_MASK);
+				faces[FACE_Y_NEG] = VisibleFaces(my, rows[OC_OPAQUE][neighbourRows[3]], rows[OC_CUTOUT][neighbourRows[3]], rows[OC_TRANSPARENT][neighbourRows[3]]);
+				faces[FACE_X_POS] = VisibleFaces(my, my[OC_OPAQUE] >> 1, my[OC_CUTOUT] >> 1, my[OC_TRANSPARENT] >> 1);
+				faces[FACE_X_NEG] = VisibleFaces(my, my[OC_OPAQUE] << 1, my[OC_CUTOUT] << 1, my[OC_TRANSPARENT] << 1);
+
+				for (int face = 0; face < FACE_COUNT; face++) {
+					uint32_t bits = faces[face];
+					while (bits) {
+						int x = CountTrailingZeros(bits) - 1;
+						bits &= bits - 1;
+						emit(snapshot.Get(x, y, z), x, y, z, (BlockFace)face);
+					}
+				}
+			}
+		}
+	}
+}
+
+bool ChunkMesh::ShouldRenderFace(BlockId myself, BlockId neighbour) {
+	const BlockData& myData = BlockData::Get(myself);
+	const BlockData& neighData = BlockData::Get(neighbour);
+
+	if (neighData.flags & BF_HALF_BLOCK)
+		return true;
+
+	if (neighData.flags & BF_CUTOUT)
+		return !(myData.flags & BF_CUTOUT);
+
+	bool isNeighTransp = neighData.pass == SP_TRANSPARENT;
+	if (isNeighTransp) {
+		bool isTransp = myData.pass == SP_TRANSPARENT;
+		return !isTransp;
+	}
+
+	return neighbour == EMPTY;
+}
+
+bool ChunkMesh::ValidateBinaryCulling(const ChunkSnapshot& snapshot) {
+	ChunkOccupancy occupancy;
+	occupancy.Build(snapshot);
+
+	std::vector<uint32_t> scalarFaces, binaryFaces;
+	auto collect = [](std::vector<uint32_t>& faces) {
+		return [&faces](BlockId, int x, int y, int z, BlockFace face) {
+			faces.push_back(x | (y << 5) | (z << 10) | (face << 15));
+		};
+	};
+	ForEachVisibleFaceScalar(snapshot, collect(scalarFaces));
+	ForEachVisibleFaceBinary(snapshot, occupancy, collect(binaryFaces));
+
+	std::sort(scalarFaces.begin(), scalarFaces.end());
+	std::sort(binaryFaces.begin(), binaryFaces.end());
+	return scalarFaces == binaryFaces;
+}
+
+void ChunkMesh::Clear() {
+	for (int pass = SP_OPAQUE; pass < SP_COUNT; pass++) {
+		vb[pass].Clear();
+		ib[pass].Clear();
+	}
+}
+
+void ChunkMesh::Build(const ChunkSnapshot& snapshot) {
+	Clear();
+
+	ChunkOccupancy occupancy;
+	occupancy.Build(snapshot);
+	ForEachVisibleFaceBinary(snapshot, occupancy, [this](BlockId blockId, int x, int y, int z, BlockFace face) {
+		PushBlockFace(blockId, x, y, z, face);
+	});
+}
+
+void ChunkMesh::BuildScalar(const ChunkSnapshot& snapshot) {
+	Clear();
+
+	ForEachVisibleFaceScalar(snapshot, [this](BlockId blockId, int x, int y, int z, BlockFace face) {
+		PushBlockFace(blockId, x, y, z, face);
+	});
+}
+
+void ChunkMesh::PushBlockFace(BlockId blockId, int x, int y, int z, BlockFace face) {
+	const ShaderPass pass = BlockData::Get(blockId).pass;
+	AppendBlockFace(vb[pass], ib[pass], blockId, Vector3((float)x, (float)y, (float)z), face);
+}
+
+void ChunkMesh::AppendBlockFace(VertexBuffer<VertexLayout_PositionNormalUV>& vb, IndexBuffer& ib, BlockId blockId, Vector3 center, BlockFace face) {
+	auto& data = BlockData::Get(blockId);
+	float scaleY = (data.flags & BF_HALF_BLOCK) ? 0.5f : 1.0f;
+	const float x = center.x, y = center.y, z = center.z;
+	switch (face) {
+	case FACE_Z_POS: AppendFace(vb, ib, { -0.5f + x, -0.5f + y, 0.5f + z }, Vector3::Up, Vector3::Right, Vector3::Backward, data.texIdSide, scaleY); break;
+	case FACE_X_POS: AppendFace(vb, ib, { 0.5f + x, -0.5f + y, 0.5f + z }, Vector3::Up, Vector3::Forward, Vector3::Right, data.texIdSide, scaleY); break;
+	case FACE_Z_NEG: AppendFace(vb, ib, { 0.5f + x, -0.5f + y,-0.5f + z }, Vector3::Up, Vector3::Left, Vector3::Forward, data.texIdSide, scaleY); break;
+	case FACE_X_NEG: AppendFace(vb, ib, { -0.5f + x, -0.5f + y,-0.5f + z }, Vector3::Up, Vector3::Backward, Vector3::Left, data.texIdSide, scaleY); break;
+	case FACE_Y_POS: AppendFace(vb, ib, { -0.5f + x, (scaleY - 0.5f) + y, 0.5f + z }, Vector3::Forward, Vector3::Right, Vector3::Up, data.texIdTop); break;
+	case FACE_Y_NEG: AppendFace(vb, ib, { -0.5f + x, -0.5f + y,-0.5f + z }, Vector3::Backward, Vector3::Right, Vector3::Down, data.texIdBottom); break;
+	}
+}
+
+void ChunkMesh::AppendFace(VertexBuffer<VertexLayout_PositionNormalUV>& vb, IndexBuffer& ib, Vector3 pos, Vector3 up, Vector3 right, Vector3 normal, int id, float scaleY) {
+	Vector2 uv(
+		(id % 16) * BLOCK_TEXSIZE,
+		(id / 16) * BLOCK_TEXSIZE
+	);
+
+	auto a = vb.PushVertex({ ToVec4(pos), ToVec4Normal(normal), uv + Vector2::UnitY * BLOCK_TEXSIZE * scaleY });
+	auto b = vb.PushVertex({ ToVec4(pos + up * scaleY), ToVec4Normal(normal), uv });
+	auto c = vb.PushVertex({ ToVec4(pos + right), ToVec4Normal(normal), uv + Vector2::UnitX * BLOCK_TEXSIZE + Vector2::UnitY * BLOCK_TEXSIZE * scaleY });
+	auto d = vb.PushVertex({ ToVec4(pos + up * scaleY + right), ToVec4Normal(normal), uv + Vector2::UnitX * BLOCK_TEXSIZE });
+	ib.PushTriangle(a, b, c);
+	ib.PushTriangle(c, b, d);
+}
+
+void ChunkMesh::Create(DeviceResources* deviceRes) {
+	for (int pass = SP_OPAQUE; pass < SP_COUNT; pass++) {
+		vb[pass].Create(deviceRes);
+		ib[pass].Create(deviceRes);
+	}
+}
+
+RenderGeometry ChunkMesh::GetGeometry(ShaderPass pass) {
+	RenderGeometry geometry;
+	geometry.vertexBuffer = vb[pass].Get();
+	geometry.stride = sizeof(VertexLayout_PositionNormalUV);
+	geometry.indexBuffer = ib[pass].Get();
+	geometry.count = (uint32_t)ib[pass].Size();
+	return geometry;
+}
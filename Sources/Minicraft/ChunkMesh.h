@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Engine/Buffers.h"
+#include "Engine/RenderCommands.h"
+#include "Engine/VertexLayout.h"
+#include "Minicraft/Block.h"
+
+enum BlockFace {
+	FACE_Z_POS,
+	FACE_X_POS,
+	FACE_Z_NEG,
+	FACE_X_NEG,
+	FACE_Y_POS,
+	FACE_Y_NEG,
+
+	FACE_COUNT
+};
+
+enum ChunkMeshResult {
+	CMR_MESHED,
+	CMR_EMPTY,  // nothing to mesh
+	CMR_BURIED, // nothing visible
+};
+
+struct ChunkSnapshot;
+struct ChunkOccupancy;
+// Geometry of one chunk, one vertex/index buffer pair per shader pass.
+// Build() only reads the snapshot and fills the CPU side, Create() uploads it to the GPU.
+class ChunkMesh {
+	VertexBuffer<VertexLayout_PositionNormalUV> vb[SP_COUNT];
+	IndexBuffer ib[SP_COUNT];
+public:
+	void Clear();
+	// Culls faces with the occupancy bitsets, BuildScalar() is the per voxel reference
+	void Build(const ChunkSnapshot& snapshot);
+	void BuildScalar(const ChunkSnapshot& snapshot);
+	void Create(DeviceResources* deviceRes);
+	RenderGeometry GetGeometry(ShaderPass pass);
+
+	bool HasGeometry(ShaderPass pass) { return ib[pass].Size() > 0; }
+	bool HasGeometry() { return HasGeometry(SP_OPAQUE) || HasGeometry(SP_TRANSPARENT); }
+
+	static bool ShouldRenderFace(BlockId myself, BlockId neighbour);
+	// One face of the block centered on center, half blocks get half height sides and a lowered top.
+	// BlockMeshCache builds its cubes with it too.
+	static void AppendBlockFace(VertexBuffer<VertexLayout_PositionNormalUV>& vb, IndexBuffer& ib, BlockId blockId, Vector3 center, BlockFace face);
+	// Checks that both culling paths find exactly the same faces, "-bench-mesher" runs it over edited chunks
+	static bool ValidateBinaryCulling(const ChunkSnapshot& snapshot);
+private:
+	void PushBlockFace(BlockId blockId, int x, int y, int z, BlockFace face);
+	static void AppendFace(VertexBuffer<VertexLayout_PositionNormalUV>& vb, IndexBuffer& ib, Vector3 pos, Vector3 up, Vector3 right, Vector3 normal, int id, float scaleY = 1.0f);
+};
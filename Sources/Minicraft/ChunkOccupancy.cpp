@@ -0,0 +1,52 @@
+#include "pch.h"
+
+#include "ChunkOccupancy.h"
+
+namespace {
+	struct OpacityClassTable {
+		int8_t classes[COUNT + 1];
+
+		OpacityClassTable() {
+			for (int id = 0; id <= COUNT; id++) {
+				auto& data = BlockData::Get((BlockId)id);
+				bool half = data.flags & BF_HALF_BLOCK;
+				bool cutout = data.flags & BF_CUTOUT;
+				bool transparent = data.pass == SP_TRANSPARENT;
+
+				// Classes are exclusive, a block mixing them would need its own mask to cull like ShouldRenderFace
+				assert(!(half && (cutout || transparent)) && !(cutout && transparent));
+
+				if (id == EMPTY) classes[id] = -1;
+				else if (half) classes[id] = OC_HALF_BLOCK;
+				else if (cutout) classes[id] = OC_CUTOUT;
+				else if (transparent) classes[id] = OC_TRANSPARENT;
+				else classes[id] = OC_OPAQUE;
+			}
+		}
+	};
+
+	const OpacityClassTable& GetOpacityClasses() {
+		static const OpacityClassTable table;
+		return table;
+	}
+}
+
+int ChunkOccupancy::GetClass(BlockId id) {
+	return GetOpacityClasses().classes[id];
+}
+
+void ChunkOccupancy::Build(const ChunkSnapshot& snapshot) {
+	memset(rows, 0, sizeof(rows));
+
+	auto& classes = GetOpacityClasses().classes;
+	for (int z = -1; z <= CHUNK_SIZE; z++) {
+		for (int y = -1; y <= CHUNK_SIZE; y++) {
+			const int row = RowIndex(y, z);
+			const BlockId* blocks = &snapshot.blocks[ChunkSnapshot::Index(-1, y, z)];
+			for (int bit = 0; bit < CHUNK_PADDED; bit++) {
+				int cls = classes[blocks[bit]];
+				if (cls >= 0) rows[cls][row] |= 1u << bit;
+			}
+		}
+	}
+}
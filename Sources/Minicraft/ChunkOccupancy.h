@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Minicraft/ChunkSnapshot.h"
+
+// Opacity classes, following the precedence of ChunkMesh::ShouldRenderFace
+enum OpacityClass {
+	OC_OPAQUE,
+	OC_CUTOUT,
+	OC_TRANSPARENT,
+	OC_HALF_BLOCK,
+
+	OC_COUNT
+};
+
+// Occupancy bitsets of a padded chunk snapshot: one mask per row along X and per opacity class.
+// Bit (lx + 1) of a row is set when the voxel belongs to the class, so the border voxels
+// are in the same word and X neighbours are a shift away.
+struct ChunkOccupancy {
+	static constexpr uint32_t INTERIOR_MASK = ((1u << CHUNK_SIZE) - 1) << 1;
+
+	uint32_t rows[OC_COUNT][CHUNK_PADDED * CHUNK_PADDED];
+
+	void Build(const ChunkSnapshot& snapshot);
+
+	// Local chunk coordinates, from -1 to CHUNK_SIZE included
+	static constexpr int RowIndex(int ly, int lz) { return (ly + 1) + (lz + 1) * CHUNK_PADDED; }
+
+	// Returns -1 for EMPTY
+	static int GetClass(BlockId id);
+};
@@ -0,0 +1,55 @@
+#include "pch.h"
+
+#include "Engine/Camera.h"
+#include "Engine/Clock.h"
+#include "Engine/Profiler.h"
+#include "ChunkRebuildScheduler.h"
+#include "Chunk.h"
+
+void ChunkRebuildScheduler::MarkDirty(Chunk* chunk, bool urgent) {
+	// Already queued: the flag on the chunk upgrades its entry, picked up when sorting
+	chunk->rebuildUrgent |= urgent;
+	if (chunk->needRegen) return;
+
+	chunk->needRegen = true;
+	pending.push_back({ chunk, DX::SystemClock::Get().GetCounter(), false, false, 0 });
+}
+
+int ChunkRebuildScheduler::Run(DeviceResources* deviceRes, const Camera* camera, double budgetMs) {
+	if (pending.empty()) return 0;
+	PROFILE_ZONE("ChunkRebuildScheduler::Run");
+
+	auto& clock = DX::SystemClock::Get();
+	const uint64_t start = clock.GetCounter();
+
+	const Vector3 eye = camera->GetPosition();
+	for (auto& entry : pending) {
+		entry.urgent = entry.chunk->rebuildUrgent;
+		entry.visible = entry.chunk->bounds.Intersects(camera->bounds);
+		entry.distance = Vector3::DistanceSquared(eye, Vector3(entry.chunk->bounds.Center));
+	}
+	// Highest priority last, so rebuilt chunks are popped from the back
+	std::sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+		if (a.urgent != b.urgent) return b.urgent;
+		if (a.visible != b.visible) return b.visible;
+		return a.distance > b.distance;
+	});
+
+	int rebuilt = 0;
+	do {
+		Chunk* chunk = pending.back().chunk;
+		pending.pop_back();
+		if (!chunk->needRegen) continue; // already rebuilt outside of the queue
+		chunk->Generate(deviceRes);
+		rebuilt++;
+	} while (!pending.empty() && clock.MillisecondsSince(start) < budgetMs);
+	return rebuilt;
+}
+
+double ChunkRebuildScheduler::GetOldestAgeMs() const {
+	if (pending.empty()) return 0;
+	uint64_t oldest = pending[0].queuedAt;
+	for (auto& entry : pending)
+		oldest = std::min(oldest, entry.queuedAt);
+	return DX::SystemClock::Get().MillisecondsSince(oldest);
+}
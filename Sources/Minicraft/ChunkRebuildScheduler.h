@@ -0,0 +1,27 @@
+#pragma once
+
+class Chunk;
+class Camera;
+
+// Queue of chunks waiting for a new mesh. A chunk is queued once however many times it is dirtied,
+// and keeps drawing its old mesh until its turn comes.
+class ChunkRebuildScheduler {
+	struct Pending {
+		Chunk* chunk;
+		uint64_t queuedAt;
+		// Filled when sorting, urgent from the chunk
+		bool urgent;
+		bool visible;
+		float distance;
+	};
+	std::vector<Pending> pending;
+public:
+	// Urgent rebuilds (blocks edited by the player) go before everything else
+	void MarkDirty(Chunk* chunk, bool urgent);
+	// Rebuilds urgent, then visible, then nearest chunks first until budgetMs is spent, at least one per call.
+	// Returns the number of chunks rebuilt.
+	int Run(DeviceResources* deviceRes, const Camera* camera, double budgetMs);
+
+	size_t GetQueueLength() const { return pending.size(); }
+	double GetOldestAgeMs() const;
+};
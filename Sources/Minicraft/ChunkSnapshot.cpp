@@ -0,0 +1,55 @@
+#include "pch.h"
+
+#include "ChunkSnapshot.h"
+
+void ChunkSnapshot::Capture(const Chunk* chunk) {
+	auto blocksOf = [](const Chunk* neighbour) -> const BlockId* {
+		neighbour = Chunk::IfLoaded(neighbour);
+		return neighbour ? neighbour->data : nullptr;
+	};
+	const BlockId* neighbours[FACE_COUNT];
+	neighbours[FACE_X_NEG] = blocksOf(chunk->adjXNeg);
+	neighbours[FACE_X_POS] = blocksOf(chunk->adjXPos);
+	neighbours[FACE_Y_NEG] = blocksOf(chunk->adjYNeg);
+	neighbours[FACE_Y_POS] = blocksOf(chunk->adjYPos);
+	neighbours[FACE_Z_NEG] = blocksOf(chunk->adjZNeg);
+	neighbours[FACE_Z_POS] = blocksOf(chunk->adjZPos);
+	Capture(chunk->data, neighbours);
+}
+
+void ChunkSnapshot::Capture(const ChunkMeshSource& source) {
+	const BlockId* neighbours[FACE_COUNT];
+	for (int face = 0; face < FACE_COUNT; face++)
+		neighbours[face] = source.neighbours[face].IsValid() ? source.neighbours[face].GetBlocks() : nullptr;
+	Capture(source.blocks.GetBlocks(), neighbours);
+}
+
+void ChunkSnapshot::Capture(const BlockId* center, const BlockId* const neighbours[FACE_COUNT]) {
+	// Edges and corners of the border are never read by face culling
+	memset(blocks, EMPTY, sizeof(blocks));
+
+	for (int z = 0; z < CHUNK_SIZE; z++) {
+		for (int y = 0; y < CHUNK_SIZE; y++) {
+			memcpy(&blocks[Index(0, y, z)], &center[y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_SIZE], CHUNK_SIZE * sizeof(BlockId));
+		}
+	}
+
+	const BlockId* xNeg = neighbours[FACE_X_NEG];
+	const BlockId* xPos = neighbours[FACE_X_POS];
+	const BlockId* yNeg = neighbours[FACE_Y_NEG];
+	const BlockId* yPos = neighbours[FACE_Y_POS];
+	const BlockId* zNeg = neighbours[FACE_Z_NEG];
+	const BlockId* zPos = neighbours[FACE_Z_POS];
+
+	const int last = CHUNK_SIZE - 1;
+	for (int a = 0; a < CHUNK_SIZE; a++) {
+		for (int b = 0; b < CHUNK_SIZE; b++) {
+			if (xNeg) blocks[Index(-1, a, b)] = xNeg[last + a * CHUNK_SIZE + b * CHUNK_SIZE * CHUNK_SIZE];
+			if (xPos) blocks[Index(CHUNK_SIZE, a, b)] = xPos[a * CHUNK_SIZE + b * CHUNK_SIZE * CHUNK_SIZE];
+			if (yNeg) blocks[Index(a, -1, b)] = yNeg[a + last * CHUNK_SIZE + b * CHUNK_SIZE * CHUNK_SIZE];
+			if (yPos) blocks[Index(a, CHUNK_SIZE, b)] = yPos[a + b * CHUNK_SIZE * CHUNK_SIZE];
+			if (zNeg) blocks[Index(a, b, -1)] = zNeg[a + b * CHUNK_SIZE + last * CHUNK_SIZE * CHUNK_SIZE];
+			if (zPos) blocks[Index(a, b, CHUNK_SIZE)] = zPos[a + b * CHUNK_SIZE];
+		}
+	}
+}
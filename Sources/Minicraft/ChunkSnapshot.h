@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Minicraft/Block.h"
+#include "Minicraft/Chunk.h"
+
+#define CHUNK_PADDED (CHUNK_SIZE + 2)
+
+// Blocks of a chunk and of its loaded neighbours, by BlockFace, held without copying them. Missing neighbours are
+// left invalid. The chunks only clone their blocks when written while it is held.
+struct ChunkMeshSource {
+	ChunkBlocksSnapshot blocks;
+	ChunkBlocksSnapshot neighbours[FACE_COUNT];
+};
+
+// Copy of a chunk plus a one voxel border taken from its six neighbours.
+// Every lookup the mesher needs is a flat array read, and since the snapshot doesn't point
+// back to the world it can be handed as is to another thread while the chunk keeps changing.
+// Missing neighbours (world edges, chunks still loading) are filled with EMPTY, which culls exactly like "no neighbour".
+struct ChunkSnapshot {
+	static constexpr int STRIDE_X = 1;
+	static constexpr int STRIDE_Y = CHUNK_PADDED;
+	static constexpr int STRIDE_Z = CHUNK_PADDED * CHUNK_PADDED;
+
+	BlockId blocks[CHUNK_PADDED * CHUNK_PADDED * CHUNK_PADDED];
+
+	void Capture(const Chunk* chunk);
+	// The same copy from held blocks, on any thread
+	void Capture(const ChunkMeshSource& source);
+
+	// Local chunk coordinates, from -1 to CHUNK_SIZE included
+	static constexpr int Index(int lx, int ly, int lz) {
+		return (lx + 1) * STRIDE_X + (ly + 1) * STRIDE_Y + (lz + 1) * STRIDE_Z;
+	}
+	BlockId Get(int lx, int ly, int lz) const { return blocks[Index(lx, ly, lz)]; }
+private:
+	// Neighbours by BlockFace, null when missing
+	void Capture(const BlockId* center, const BlockId* const neighbours[FACE_COUNT]);
+};
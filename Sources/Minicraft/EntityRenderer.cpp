@@ -0,0 +1,57 @@
+#include "pch.h"
+
+#include "EntityRenderer.h"
+#include "Engine/Profiler.h"
+#include "Minicraft/BlockMeshCache.h"
+
+void EntityRenderer::BuildInstances(const EntityStore& entities) {
+	PROFILE_ZONE("EntityRenderer::BuildInstances");
+
+	const uint32_t count = entities.Count();
+	memset(counts, 0, sizeof(counts));
+	for (uint32_t i = 0; i < count; i++) {
+		BlockId block = entities.blocks[i];
+		if (block != EMPTY && block < COUNT) counts[block]++;
+	}
+
+	batches.clear();
+	uint32_t total = 0;
+	for (int block = 0; block < COUNT; block++) {
+		if (counts[block] == 0) continue;
+		batches.push_back({ (BlockId)block, total, counts[block] });
+		counts[block] = total;
+		total += batches.back().count;
+	}
+
+	// The unit cube is scaled to the entity box, rows follow SimpleMath so the shader reads them as they are
+	instances.data.resize(total);
+	for (uint32_t i = 0; i < count; i++) {
+		BlockId block = entities.blocks[i];
+		if (block == EMPTY || block >= COUNT) continue;
+		const Vector3 size = entities.halfExtents[i] * 2;
+		const Vector3& pos = entities.positions[i];
+		instances.data[counts[block]++].transform = Matrix(
+			size.x, 0, 0, 0,
+			0, size.y, 0, 0,
+			0, 0, size.z, 0,
+			pos.x, pos.y, pos.z, 1
+		);
+	}
+}
+
+void EntityRenderer::Draw(DeviceResources* deviceRes, RenderCommandList& commands, RenderState state) {
+	if (batches.empty()) return;
+	PROFILE_ZONE("EntityRenderer::Draw");
+
+	// One dynamic buffer for every frame, the list writes it when submitted
+	instances.ReserveDynamic(deviceRes);
+	commands.AddUpload(instances.Get(), instances.data.data(), sizeof(VertexLayout_BlockInstance) * instances.data.size());
+	for (auto& batch : batches) {
+		RenderGeometry geometry = BlockMeshCache::Get().GetGeometry(batch.block);
+		geometry.instanceBuffer = instances.Get();
+		geometry.instanceStride = sizeof(VertexLayout_BlockInstance);
+		geometry.firstInstance = batch.first;
+		geometry.instanceCount = batch.count;
+		commands.Add(RP_OPAQUE, state, geometry, Matrix::Identity);
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Engine/Buffers.h"
+#include "Engine/RenderCommands.h"
+#include "Engine/VertexLayout.h"
+#include "Minicraft/EntityStore.h"
+
+// Instances of one block, a range of the instance list
+struct BlockInstanceBatch {
+	BlockId block;
+	uint32_t first;
+	uint32_t count;
+};
+
+// Draws every block shaped entity of a frame with one instanced draw per block.
+// Building the instance list only touches the CPU, so it also runs headless.
+// The instances go to one dynamic buffer, grown when a frame holds more than it fits.
+class EntityRenderer {
+	VertexBuffer<VertexLayout_BlockInstance> instances;
+	std::vector<BlockInstanceBatch> batches;
+	uint32_t counts[COUNT];
+public:
+	// Gathers the transform of every entity made of a block, grouped by block in a counting sort
+	void BuildInstances(const EntityStore& entities);
+	// Adds the upload of the instances and the draws, state must use the instanced shader and input layout
+	void Draw(DeviceResources* deviceRes, RenderCommandList& commands, RenderState state);
+
+	const std::vector<VertexLayout_BlockInstance>& GetInstances() const { return instances.data; }
+	const std::vector<BlockInstanceBatch>& GetBatches() const { return batches; }
+};
@@ -0,0 +1,194 @@
+#include "pch.h"
+
+#include "Engine/Clock.h"
+#include "Engine/Profiler.h"
+#include "EntityStore.h"
+#include "VoxelCollider.h"
+#include "WorldEditBatch.h"
+
+namespace {
+	constexpr float GRAVITY = -30.0f;
+	constexpr float ITEM_LIFETIME = 300.0f;
+	constexpr float MOB_JUMP_SPEED = 8.0f;
+	constexpr float SEPARATION_STRENGTH = 20.0f;
+	constexpr int BATCH_SIZE = 256;
+}
+
+EntityId EntityStore::Spawn(EntityType type, Vector3 position, Vector3 velocity, Vector3 halfExtent, BlockId block) {
+	uint32_t index;
+	if (!freeIndices.empty()) {
+		index = freeIndices.back();
+		freeIndices.pop_back();
+	} else {
+		index = (uint32_t)slotOfIndex.size();
+		assert(index <= INDEX_MASK);
+		slotOfIndex.push_back(INVALID_ENTITY);
+		generations.push_back(0);
+	}
+
+	const EntityId id = index | ((uint32_t)generations[index] << INDEX_BITS);
+	slotOfIndex[index] = (uint32_t)ids.size();
+	ids.push_back(id);
+	positions.push_back(position);
+	velocities.push_back(velocity);
+	halfExtents.push_back(halfExtent);
+	types.push_back(type);
+	blocks.push_back(block);
+	flags.push_back(EF_NONE);
+	ages.push_back(0);
+	return id;
+}
+
+bool EntityStore::IsAlive(EntityId id) const {
+	const uint32_t index = id & INDEX_MASK;
+	if (index >= slotOfIndex.size() || slotOfIndex[index] == INVALID_ENTITY) return false;
+	return ids[slotOfIndex[index]] == id;
+}
+
+void EntityStore::Despawn(EntityId id) {
+	if (!IsAlive(id)) return;
+	const uint32_t index = id & INDEX_MASK;
+	const uint32_t slot = slotOfIndex[index];
+	const uint32_t last = (uint32_t)ids.size() - 1;
+
+	if (slot != last) {
+		ids[slot] = ids[last];
+		positions[slot] = positions[last];
+		velocities[slot] = velocities[last];
+		halfExtents[slot] = halfExtents[last];
+		types[slot] = types[last];
+		blocks[slot] = blocks[last];
+		flags[slot] = flags[last];
+		ages[slot] = ages[last];
+		slotOfIndex[ids[slot] & INDEX_MASK] = slot;
+	}
+	ids.pop_back();
+	positions.pop_back();
+	velocities.pop_back();
+	halfExtents.pop_back();
+	types.pop_back();
+	blocks.pop_back();
+	flags.pop_back();
+	ages.pop_back();
+
+	slotOfIndex[index] = INVALID_ENTITY;
+	// Wraps within the bits left by the index
+	generations[index] = (generations[index] + 1) & ((1u << (32 - INDEX_BITS)) - 1);
+	freeIndices.push_back(index);
+}
+
+void EntityStore::Clear() {
+	while (!ids.empty())
+		Despawn(ids.back());
+	stats = EntityStats();
+}
+
+void EntityStore::Integrate(World* world, float dt, uint32_t begin, uint32_t end) {
+	VoxelCollider collider(world);
+	for (uint32_t i = begin; i < end; i++) {
+		Vector3& velocity = velocities[i];
+		velocity.y += GRAVITY * dt;
+		ages[i] += dt;
+
+		CollisionBox box = { positions[i] - halfExtents[i], positions[i] + halfExtents[i] };
+		auto result = collider.Move(box, velocity * dt);
+		positions[i] = box.min + halfExtents[i];
+
+		if (result.hit[0]) velocity.x = types[i] == ET_MOB ? -velocity.x : 0;
+		if (result.hit[2]) velocity.z = types[i] == ET_MOB ? -velocity.z : 0;
+		if (result.hit[1]) velocity.y = 0;
+		if (result.onGround) flags[i] |= EF_ON_GROUND;
+		else flags[i] &= ~EF_ON_GROUND;
+
+		if (!result.onGround) continue;
+		if (types[i] == ET_ITEM) {
+			velocity.x *= 0.8f;
+			velocity.z *= 0.8f;
+		} else if (types[i] == ET_MOB && (result.hit[0] || result.hit[2])) {
+			velocity.y = MOB_JUMP_SPEED;
+		}
+	}
+}
+
+int EntityStore::Separate(uint32_t begin, uint32_t end) {
+	// In broadphase order, so consecutive lookups read the same buckets
+	const auto& order = broadphase.GetSortedItems();
+	int overlaps = 0;
+	for (uint32_t k = begin; k < end; k++) {
+		const Vector3 position = sortedPositions[k];
+		const Vector3 extent = sortedExtents[k];
+		Vector3 push;
+		broadphase.ForEachNear(position, [&](uint32_t other) {
+			if (other == k) return;
+			const Vector3 offset = position - sortedPositions[other];
+			const Vector3 reach = extent + sortedExtents[other];
+			if (fabs(offset.x) >= reach.x || fabs(offset.y) >= reach.y || fabs(offset.z) >= reach.z) return;
+
+			// Horizontal push along the axis of least penetration, entities stacked exactly are split on X
+			const float depthX = reach.x - fabs(offset.x);
+			const float depthZ = reach.z - fabs(offset.z);
+			if (depthX < depthZ) push.x += offset.x < 0 || (offset.x == 0 && k < other) ? -depthX : depthX;
+			else push.z += offset.z < 0 || (offset.z == 0 && k < other) ? -depthZ : depthZ;
+			// Both entities of a pair see each other, only the first one counts it
+			if (k < other) overlaps++;
+		});
+		pushes[order[k]] = push;
+	}
+	return overlaps;
+}
+
+void EntityStore::Update(World* world, float dt, JobSystem* jobs) {
+	PROFILE_ZONE("EntityStore::Update");
+	auto& clock = DX::SystemClock::Get();
+	const uint32_t count = Count();
+	stats.count = count;
+	stats.overlaps = 0;
+	stats.landed = 0;
+	if (count == 0) return;
+
+	// Runs fn(begin, end) over all the entities, on the job system when there is one
+	auto forEachBatch = [&](const auto& fn) {
+		if (jobs) jobs->ParallelFor((int)count, BATCH_SIZE, [&](int begin, int end) { fn((uint32_t)begin, (uint32_t)end); });
+		else fn(0u, count);
+	};
+
+	uint64_t start = clock.GetCounter();
+	forEachBatch([&](uint32_t begin, uint32_t end) { Integrate(world, dt, begin, end); });
+	stats.integrateMs = clock.MillisecondsSince(start);
+
+	start = clock.GetCounter();
+	broadphase.Build(positions.data(), count);
+
+	const auto& order = broadphase.GetSortedItems();
+	sortedPositions.resize(count);
+	sortedExtents.resize(count);
+	for (uint32_t k = 0; k < count; k++) {
+		sortedPositions[k] = positions[order[k]];
+		sortedExtents[k] = halfExtents[order[k]];
+	}
+	stats.broadphaseMs = clock.MillisecondsSince(start);
+
+	start = clock.GetCounter();
+	pushes.resize(count);
+	std::atomic<int> overlaps = 0;
+	forEachBatch([&](uint32_t begin, uint32_t end) { overlaps += Separate(begin, end); });
+	for (uint32_t i = 0; i < count; i++)
+		velocities[i] += pushes[i] * SEPARATION_STRENGTH * dt;
+	stats.overlaps = overlaps;
+	stats.separateMs = clock.MillisecondsSince(start);
+
+	// World edits and despawns change the arrays, they run alone once the parallel phases are done
+	WorldEditBatch landing(world);
+	for (uint32_t i = count; i-- > 0;) {
+		if (types[i] == ET_FALLING_BLOCK && (flags[i] & EF_ON_GROUND)) {
+			const Vector3 center = positions[i];
+			landing.Set((int)floor(center.x + 0.5f), (int)floor(center.y + 0.5f), (int)floor(center.z + 0.5f), blocks[i]);
+			Despawn(ids[i]);
+			stats.landed++;
+		} else if (types[i] == ET_ITEM && ages[i] > ITEM_LIFETIME) {
+			Despawn(ids[i]);
+		}
+	}
+	landing.Commit();
+	stats.count = Count();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Engine/JobSystem.h"
+#include "Engine/SpatialHash.h"
+#include "Minicraft/Block.h"
+
+enum EntityType : uint8_t {
+	ET_ITEM,          // dropped block, picked up nowhere yet, despawns after a while
+	ET_MOB,           // keeps walking, jumps over what blocks it
+	ET_FALLING_BLOCK, // becomes a block again where it lands
+
+	ET_COUNT
+};
+
+enum EntityFlags : uint8_t {
+	EF_NONE = 0,
+	EF_ON_GROUND = 1 << 0,
+};
+
+// Index in the low bits, generation in the high bits so handles to despawned entities stay invalid
+using EntityId = uint32_t;
+constexpr EntityId INVALID_ENTITY = ~0u;
+
+struct EntityStats {
+	int count = 0;
+	int overlaps = 0;  // entity pairs pushed apart during the last update
+	int landed = 0;    // falling blocks placed during the last update
+	double integrateMs = 0;
+	double broadphaseMs = 0;
+	double separateMs = 0;
+};
+
+class World;
+// Entities as structure of arrays: every component is a dense array indexed by slot, so the update
+// streams through the few arrays each phase needs. Despawning moves the last entity into the freed slot.
+class EntityStore {
+	std::vector<uint32_t> slotOfIndex; // INVALID_ENTITY for free indices
+	std::vector<uint16_t> generations;
+	std::vector<uint32_t> freeIndices;
+	std::vector<Vector3> pushes;       // separation of the current update
+	// Positions and sizes gathered in broadphase order
+	std::vector<Vector3> sortedPositions;
+	std::vector<Vector3> sortedExtents;
+	SpatialHash broadphase = SpatialHash(2.0f);
+
+	void Integrate(World* world, float dt, uint32_t begin, uint32_t end);
+	int Separate(uint32_t begin, uint32_t end);
+public:
+	// Components
+	std::vector<EntityId> ids;
+	std::vector<Vector3> positions;   // box centers
+	std::vector<Vector3> velocities;
+	std::vector<Vector3> halfExtents; // at most 1, the broadphase cell size is 2
+	std::vector<EntityType> types;
+	std::vector<BlockId> blocks;      // what items and falling blocks are made of
+	std::vector<uint8_t> flags;
+	std::vector<float> ages;
+
+	EntityStats stats;
+
+	EntityId Spawn(EntityType type, Vector3 position, Vector3 velocity, Vector3 halfExtent, BlockId block = EMPTY);
+	void Despawn(EntityId id);
+	bool IsAlive(EntityId id) const;
+	uint32_t GetSlot(EntityId id) const { return IsAlive(id) ? slotOfIndex[id & INDEX_MASK] : INVALID_ENTITY; }
+	uint32_t Count() const { return (uint32_t)ids.size(); }
+	void Clear();
+
+	// Moves every entity against the world, then pushes overlapping entities apart.
+	// Phases are split across the job system when given one, entities are independent within a phase.
+	void Update(World* world, float dt, JobSystem* jobs);
+
+	static constexpr uint32_t INDEX_BITS = 20;
+	static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+};
@@ -0,0 +1,169 @@
+#include "pch.h"
+
+#include "ExplosionSystem.h"
+#include "Engine/Clock.h"
+#include "Engine/Profiler.h"
+#include "Minicraft/WorldEditBatch.h"
+
+namespace {
+	constexpr int RAY_GRID = 16;         // rays through the surface of a 16x16x16 cube
+	constexpr float RAY_STEP = 0.3f;
+	constexpr float RAY_DECAY = 0.225f;  // lost every step, even through air
+	constexpr float RESISTANCE_SCALE = 0.3f;
+
+	// Packed so that sorting orders blocks by z, then y, then x
+	uint64_t Pack(int gx, int gy, int gz) {
+		return (uint64_t)gx | ((uint64_t)gy << 20) | ((uint64_t)gz << 40);
+	}
+
+	void Unpack(uint64_t packed, int& gx, int& gy, int& gz) {
+		gx = (int)(packed & 0xFFFFF);
+		gy = (int)((packed >> 20) & 0xFFFFF);
+		gz = (int)(packed >> 40);
+	}
+
+	uint32_t HashPosition(int gx, int gy, int gz, uint64_t tick) {
+		const int64_t key[4] = { gx, gy, gz, (int64_t)tick };
+		return HashBytes(FNV_OFFSET_BASIS, key, sizeof(key));
+	}
+
+	const std::vector<Vector3>& GetRayDirections() {
+		static const std::vector<Vector3> directions = [] {
+			std::vector<Vector3> result;
+			for (int k = 0; k < RAY_GRID; k++)
+				for (int j = 0; j < RAY_GRID; j++)
+					for (int i = 0; i < RAY_GRID; i++) {
+						const bool onSurface = i == 0 || j == 0 || k == 0 || i == RAY_GRID - 1 || j == RAY_GRID - 1 || k == RAY_GRID - 1;
+						if (!onSurface) continue;
+						Vector3 dir(i * 2.0f / (RAY_GRID - 1) - 1, j * 2.0f / (RAY_GRID - 1) - 1, k * 2.0f / (RAY_GRID - 1) - 1);
+						dir.Normalize();
+						result.push_back(dir * RAY_STEP);
+					}
+			return result;
+		}();
+		return directions;
+	}
+}
+
+void ExplosionSystem::Detonate(int gx, int gy, int gz, float power, uint32_t fuseTicks) {
+	primed.push_back({ tick + std::max(fuseTicks, 1u), order++, gx, gy, gz, power });
+	std::push_heap(primed.begin(), primed.end(), std::greater<Primed>());
+}
+
+void ExplosionSystem::Clear() {
+	primed.clear();
+	tick = 0;
+	order = 0;
+	accumulator = 0;
+	stats = ExplosionStats();
+}
+
+void ExplosionSystem::Update(float dt, JobSystem* jobs) {
+	accumulator += dt;
+	while (accumulator >= 1.0f / TICKS_PER_SECOND) {
+		accumulator -= 1.0f / TICKS_PER_SECOND;
+		Tick(jobs);
+	}
+}
+
+void ExplosionSystem::CastRays(Blast& blast) const {
+	const Primed& source = blast.source;
+	blast.destroyed.clear();
+	const Vector3 origin((float)source.x, (float)source.y, (float)source.z);
+	// Same rays whatever the thread casting them
+	uint32_t rng = HashPosition(source.x, source.y, source.z, tick) | 1;
+
+	for (const Vector3& step : GetRayDirections()) {
+		rng ^= rng << 13;
+		rng ^= rng >> 17;
+		rng ^= rng << 5;
+		float intensity = source.power * (0.7f + (rng & 0xFFFF) * (0.6f / 0xFFFF));
+		Vector3 p = origin;
+		int lastX = INT_MIN, lastY = INT_MIN, lastZ = INT_MIN;
+		while (intensity > 0) {
+			const int gx = (int)floorf(p.x + 0.5f), gy = (int)floorf(p.y + 0.5f), gz = (int)floorf(p.z + 0.5f);
+			p += step;
+			intensity -= RAY_DECAY;
+			// Steps are shorter than a block, each block only absorbs once per ray
+			if (gx == lastX && gy == lastY && gz == lastZ) continue;
+			lastX = gx; lastY = gy; lastZ = gz;
+			if (gx == source.x && gy == source.y && gz == source.z) continue;
+
+			// Rays stop at the world border and at chunks not loaded yet
+			const BlockId* block = world->GetCube(gx, gy, gz);
+			if (!block) break;
+			if (*block == EMPTY) continue;
+			intensity -= (BlockData::Get(*block).blastResistance + RESISTANCE_SCALE) * RESISTANCE_SCALE;
+			if (intensity > 0)
+				blast.destroyed.push_back(Pack(gx, gy, gz));
+		}
+	}
+
+	// Neighbouring rays hit the same blocks
+	std::sort(blast.destroyed.begin(), blast.destroyed.end());
+	blast.destroyed.erase(std::unique(blast.destroyed.begin(), blast.destroyed.end()), blast.destroyed.end());
+}
+
+void ExplosionSystem::Tick(JobSystem* jobs) {
+	tick++;
+	stats = ExplosionStats();
+	if (primed.empty() || primed.front().due > tick) {
+		stats.pending = (int)primed.size();
+		return;
+	}
+	PROFILE_ZONE("ExplosionSystem::Tick");
+	auto& clock = DX::SystemClock::Get();
+	const uint64_t start = clock.GetCounter();
+
+	// Everything due is one wave, what is beyond the cap goes off next tick
+	int count = 0;
+	while (!primed.empty() && primed.front().due <= tick && count < maxPerWave) {
+		std::pop_heap(primed.begin(), primed.end(), std::greater<Primed>());
+		if ((int)wave.size() <= count) wave.resize(count + 1);
+		wave[count++].source = primed.back();
+		primed.pop_back();
+	}
+
+	// Rays only read the world, explosions of a wave are independent
+	auto cast = [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			CastRays(wave[i]);
+	};
+	if (jobs)
+		jobs->ParallelFor(count, 1, cast);
+	else
+		cast(0, count);
+	stats.rayMs = clock.MillisecondsSince(start);
+
+	// Blasts overlap, each block is destroyed once. Sources go too, TNT lit directly is still there.
+	merged.clear();
+	sources.clear();
+	for (int i = 0; i < count; i++) {
+		const Primed& source = wave[i].source;
+		sources.push_back(Pack(source.x, source.y, source.z));
+		merged.insert(merged.end(), wave[i].destroyed.begin(), wave[i].destroyed.end());
+	}
+	merged.insert(merged.end(), sources.begin(), sources.end());
+	std::sort(sources.begin(), sources.end());
+	std::sort(merged.begin(), merged.end());
+	merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+
+	WorldEditBatch batch(world);
+	for (uint64_t packed : merged) {
+		int gx, gy, gz;
+		Unpack(packed, gx, gy, gz);
+		const BlockId* block = world->GetCube(gx, gy, gz);
+		if (!block || *block == EMPTY) continue;
+		if (*block == TNT && !std::binary_search(sources.begin(), sources.end(), packed)) {
+			// Chain reaction on a shorter fuse, the block is gone as soon as it is lit
+			Detonate(gx, gy, gz, TNT_POWER, 10 + HashPosition(gx, gy, gz, 0) % 20);
+			stats.chained++;
+		}
+		batch.Set(gx, gy, gz, EMPTY);
+		stats.destroyed++;
+	}
+	stats.explosions = count;
+	stats.dirtiedChunks = batch.Commit();
+	stats.pending = (int)primed.size();
+	stats.tickMs = clock.MillisecondsSince(start);
+}
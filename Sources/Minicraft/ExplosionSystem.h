@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Engine/JobSystem.h"
+#include "Minicraft/Block.h"
+#include "Minicraft/World.h"
+
+constexpr float TNT_POWER = 4.0f;
+
+// Counters of the last explosion tick
+struct ExplosionStats {
+	int explosions = 0;
+	int destroyed = 0;
+	int chained = 0;       // TNT primed by these explosions
+	int dirtiedChunks = 0;
+	int pending = 0;       // primed, waiting for their fuse or for a later wave
+	double rayMs = 0;
+	double tickMs = 0;
+};
+
+// Explosions sample rays against the blast resistance of blocks. Every explosion due in a tick is one wave:
+// rays of all of them run in parallel against the world as the previous wave left it, then everything they
+// destroy is applied as one WorldEditBatch, so each chunk is remeshed once per wave. TNT caught in a blast is
+// removed and primed on a short fuse, so chain reactions spread over later waves instead of one long frame.
+class ExplosionSystem {
+	struct Primed {
+		uint64_t due;
+		uint32_t order;
+		int x, y, z;
+		float power;
+
+		bool operator>(const Primed& other) const {
+			return due != other.due ? due > other.due : order > other.order;
+		}
+	};
+	struct Blast {
+		Primed source;
+		std::vector<uint64_t> destroyed; // packed positions
+	};
+
+	World* world;
+	std::vector<Primed> primed; // min heap on due then order
+	std::vector<Blast> wave;
+	std::vector<uint64_t> merged;
+	std::vector<uint64_t> sources;
+	uint64_t tick = 0;
+	uint32_t order = 0;
+	float accumulator = 0;
+	int maxPerWave = 256;
+
+	void CastRays(Blast& blast) const;
+public:
+	static constexpr int TICKS_PER_SECOND = 20;
+
+	ExplosionStats stats;
+
+	explicit ExplosionSystem(World* world) : world(world) {}
+
+	// Explodes on the next tick, or after the fuse
+	void Detonate(int gx, int gy, int gz, float power, uint32_t fuseTicks = 0);
+	// Caps the explosions of one tick, the others wait for the next ones
+	void SetMaxPerWave(int count) { maxPerWave = count; }
+	int CountPending() const { return (int)primed.size(); }
+	void Clear();
+
+	// Runs the fixed ticks due after dt more seconds, without jobs everything runs on the calling thread
+	void Update(float dt, JobSystem* jobs);
+	void Tick(JobSystem* jobs);
+};
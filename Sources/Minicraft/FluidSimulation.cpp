@@ -0,0 +1,208 @@
+#include "pch.h"
+
+#include "FluidSimulation.h"
+#include "Engine/Clock.h"
+#include "Engine/Profiler.h"
+#include "Minicraft/WorldEditBatch.h"
+
+namespace {
+	constexpr int CHUNK_COUNT = WORLD_SIZE * WORLD_HEIGHT * WORLD_SIZE;
+	constexpr int CHUNKS_PER_JOB = 4;
+	constexpr int NO_SPREAD = FL_MAX_DISTANCE + 1;
+
+	bool IsInWorld(int gx, int gy, int gz) {
+		return gx >= 0 && gy >= 0 && gz >= 0
+			&& gx < WORLD_SIZE * CHUNK_SIZE && gy < WORLD_HEIGHT * CHUNK_SIZE && gz < WORLD_SIZE * CHUNK_SIZE;
+	}
+
+	int ChunkIndexOf(int gx, int gy, int gz) {
+		return (gx >> CHUNK_SHIFT) + (gy >> CHUNK_SHIFT) * WORLD_SIZE + (gz >> CHUNK_SHIFT) * WORLD_SIZE * WORLD_HEIGHT;
+	}
+
+	int CellOf(int gx, int gy, int gz) {
+		return (gx & CHUNK_MASK) + ((gy & CHUNK_MASK) << CHUNK_SHIFT) + ((gz & CHUNK_MASK) << (2 * CHUNK_SHIFT));
+	}
+}
+
+FluidSimulation::FluidSimulation(World* world) : world(world), chunks(CHUNK_COUNT), isChunkActive(CHUNK_COUNT, false) {}
+
+uint8_t FluidSimulation::GetLevel(int gx, int gy, int gz) const {
+	if (!IsInWorld(gx, gy, gz)) return FL_SOURCE;
+	auto& levels = chunks[ChunkIndexOf(gx, gy, gz)].levels;
+	return levels ? levels[CellOf(gx, gy, gz)] : FL_SOURCE;
+}
+
+void FluidSimulation::SetLevel(int chunkIndex, int cell, uint8_t level) {
+	auto& levels = chunks[chunkIndex].levels;
+	if (!levels) {
+		if (level == FL_SOURCE) return;
+		levels = std::make_unique<uint8_t[]>(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
+	}
+	levels[cell] = level;
+}
+
+void FluidSimulation::ActivateCell(int chunkIndex, int cell) {
+	auto& chunk = chunks[chunkIndex];
+	if (chunk.isActive.test(cell)) return;
+	chunk.isActive.set(cell);
+	chunk.active.push_back((uint16_t)cell);
+	if (!isChunkActive[chunkIndex]) {
+		isChunkActive[chunkIndex] = true;
+		activeChunks.push_back(chunkIndex);
+	}
+}
+
+void FluidSimulation::Activate(int gx, int gy, int gz) {
+	static const int offsets[7][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	for (auto& offset : offsets) {
+		const int x = gx + offset[0], y = gy + offset[1], z = gz + offset[2];
+		// Only water and air ever change
+		const BlockId* block = world->GetCube(x, y, z);
+		if (block && (*block == WATER || *block == EMPTY))
+			ActivateCell(ChunkIndexOf(x, y, z), CellOf(x, y, z));
+	}
+}
+
+void FluidSimulation::Clear() {
+	for (auto& chunk : chunks)
+		chunk = ChunkFluid();
+	activeChunks.clear();
+	std::fill(isChunkActive.begin(), isChunkActive.end(), false);
+	accumulator = 0;
+}
+
+int FluidSimulation::CountActive() const {
+	int active = 0;
+	for (auto& chunk : chunks)
+		active += (int)chunk.active.size();
+	return active;
+}
+
+void FluidSimulation::OnBlockChanged(int gx, int gy, int gz, BlockId block) {
+	// Water placed by anything but the simulation is a source
+	if (!applying)
+		SetLevel(ChunkIndexOf(gx, gy, gz), CellOf(gx, gy, gz), FL_SOURCE);
+	Activate(gx, gy, gz);
+}
+
+int FluidSimulation::SpreadDistance(int gx, int gy, int gz) const {
+	const BlockId* block = world->GetCube(gx, gy, gz);
+	if (!block || *block != WATER) return NO_SPREAD;
+
+	// Water with air or flowing water below falls instead of spreading, the world bottom holds it
+	const BlockId* below = world->GetCube(gx, gy - 1, gz);
+	if (below && *below == EMPTY) return NO_SPREAD;
+	if (below && *below == WATER && GetLevel(gx, gy - 1, gz) != FL_SOURCE) return NO_SPREAD;
+
+	const uint8_t level = GetLevel(gx, gy, gz);
+	return level == FL_SOURCE || level == FL_FALLING ? 1 : level + 1;
+}
+
+bool FluidSimulation::Evaluate(int gx, int gy, int gz, Change& change) const {
+	const BlockId* current = world->GetCube(gx, gy, gz);
+	if (!current || (*current != WATER && *current != EMPTY)) return false;
+	const uint8_t level = GetLevel(gx, gy, gz);
+	if (*current == WATER && level == FL_SOURCE) return false;
+
+	BlockId block = WATER;
+	uint8_t target = FL_FALLING;
+	const BlockId* above = world->GetCube(gx, gy + 1, gz);
+	if (!above || *above != WATER) {
+		const int distance = std::min({
+			SpreadDistance(gx + 1, gy, gz), SpreadDistance(gx - 1, gy, gz),
+			SpreadDistance(gx, gy, gz + 1), SpreadDistance(gx, gy, gz - 1) });
+		if (distance > FL_MAX_DISTANCE) {
+			block = EMPTY;
+			target = FL_SOURCE;
+		} else {
+			target = (uint8_t)distance;
+		}
+	}
+
+	if (block == *current && (block == EMPTY || target == level)) return false;
+	change.block = block;
+	change.level = target;
+	return true;
+}
+
+void FluidSimulation::Update(float dt, JobSystem* jobs) {
+	accumulator += dt;
+	while (accumulator >= 1.0f / TICKS_PER_SECOND) {
+		accumulator -= 1.0f / TICKS_PER_SECOND;
+		Tick(jobs);
+	}
+}
+
+void FluidSimulation::Tick(JobSystem* jobs) {
+	stats = FluidStats();
+	if (activeChunks.empty()) return;
+	PROFILE_ZONE("FluidSimulation::Tick");
+	auto& clock = DX::SystemClock::Get();
+	const uint64_t start = clock.GetCounter();
+
+	// Cells activated from now on are for the next tick
+	const int count = (int)activeChunks.size();
+	if ((int)steps.size() < count) steps.resize(count);
+	for (int i = 0; i < count; i++) {
+		const int chunkIndex = activeChunks[i];
+		auto& chunk = chunks[chunkIndex];
+		steps[i].chunkIndex = chunkIndex;
+		steps[i].cells.swap(chunk.active);
+		chunk.active.clear();
+		chunk.isActive.reset();
+		isChunkActive[chunkIndex] = false;
+	}
+	activeChunks.clear();
+
+	// Nothing is written while deciding, so chunks are independent
+	auto evaluate = [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			auto& step = steps[i];
+			step.changes.clear();
+			const int cx = step.chunkIndex % WORLD_SIZE;
+			const int cy = (step.chunkIndex / WORLD_SIZE) % WORLD_HEIGHT;
+			const int cz = step.chunkIndex / (WORLD_SIZE * WORLD_HEIGHT);
+			for (uint16_t cell : step.cells) {
+				const int gx = (cx << CHUNK_SHIFT) + (cell & CHUNK_MASK);
+				const int gy = (cy << CHUNK_SHIFT) + ((cell >> CHUNK_SHIFT) & CHUNK_MASK);
+				const int gz = (cz << CHUNK_SHIFT) + (cell >> (2 * CHUNK_SHIFT));
+				Change change = { cell };
+				if (Evaluate(gx, gy, gz, change))
+					step.changes.push_back(change);
+			}
+		}
+	};
+	if (jobs)
+		jobs->ParallelFor(count, CHUNKS_PER_JOB, evaluate);
+	else
+		evaluate(0, count);
+
+	// Applied in chunk order, water appearing or draining goes through the world in one batch
+	applying = true;
+	WorldEditBatch batch(world);
+	for (int i = 0; i < count; i++) {
+		auto& step = steps[i];
+		stats.activeCells += (int)step.cells.size();
+		const int cx = step.chunkIndex % WORLD_SIZE;
+		const int cy = (step.chunkIndex / WORLD_SIZE) % WORLD_HEIGHT;
+		const int cz = step.chunkIndex / (WORLD_SIZE * WORLD_HEIGHT);
+		for (auto& change : step.changes) {
+			const int gx = (cx << CHUNK_SHIFT) + (change.cell & CHUNK_MASK);
+			const int gy = (cy << CHUNK_SHIFT) + ((change.cell >> CHUNK_SHIFT) & CHUNK_MASK);
+			const int gz = (cz << CHUNK_SHIFT) + (change.cell >> (2 * CHUNK_SHIFT));
+			SetLevel(step.chunkIndex, change.cell, change.level);
+			if (*world->GetCube(gx, gy, gz) != change.block) {
+				batch.Set(gx, gy, gz, change.block);
+				stats.blockChanges++;
+			} else {
+				Activate(gx, gy, gz);
+				stats.levelChanges++;
+			}
+		}
+	}
+	// Reported back to OnBlockChanged, which activates around the new and drained water
+	stats.dirtiedChunks = batch.Commit();
+	applying = false;
+
+	stats.tickMs = clock.MillisecondsSince(start);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Engine/JobSystem.h"
+#include "Minicraft/Block.h"
+#include "Minicraft/Chunk.h"
+#include "Minicraft/World.h"
+
+// Level of a WATER voxel. Sources are 0 so water placed by generation or edits needs no level stored.
+enum FluidLevel : uint8_t {
+	FL_SOURCE = 0,
+	// 1 to FL_MAX_DISTANCE: flowing, distance to the nearest source or fall
+	FL_MAX_DISTANCE = 7,
+	FL_FALLING = 8, // water above, spreads like a source where it lands
+};
+
+// Counters of the last fluid tick
+struct FluidStats {
+	int activeCells = 0;   // cells evaluated
+	int levelChanges = 0;  // only the level changed, nothing to remesh
+	int blockChanges = 0;  // water appeared or drained
+	int dirtiedChunks = 0;
+	double tickMs = 0;
+};
+
+// Water flow as a cellular automaton over WATER and EMPTY voxels. Only active cells, next to a change of the
+// previous tick or to an edit, are evaluated, so idle lakes cost nothing. A tick decides every active cell from
+// the state the previous tick left, chunk by chunk in parallel, then applies all changes: levels in the level
+// field, water appearing or draining as one WorldEditBatch. The mesher draws any water as a full block, so
+// level changes alone never remesh a chunk.
+class FluidSimulation : public IBlockListener {
+	struct ChunkFluid {
+		std::unique_ptr<uint8_t[]> levels; // one per voxel, allocated once water flows in the chunk
+		std::vector<uint16_t> active;
+		std::bitset<CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE> isActive;
+	};
+	struct Change {
+		uint16_t cell;
+		BlockId block;
+		uint8_t level;
+	};
+	struct ChunkStep {
+		int chunkIndex;
+		std::vector<uint16_t> cells;
+		std::vector<Change> changes;
+	};
+
+	World* world;
+	std::vector<ChunkFluid> chunks;
+	std::vector<int> activeChunks;
+	std::vector<bool> isChunkActive;
+	std::vector<ChunkStep> steps;
+	float accumulator = 0;
+	bool applying = false;
+
+	void ActivateCell(int chunkIndex, int cell);
+	void SetLevel(int chunkIndex, int cell, uint8_t level);
+	// What an active cell becomes, from the state of the previous tick only
+	bool Evaluate(int gx, int gy, int gz, Change& change) const;
+	// Distance water at this voxel gives its side neighbours, above FL_MAX_DISTANCE when it doesn't spread
+	int SpreadDistance(int gx, int gy, int gz) const;
+public:
+	static constexpr int TICKS_PER_SECOND = 4;
+
+	FluidStats stats;
+
+	explicit FluidSimulation(World* world);
+
+	uint8_t GetLevel(int gx, int gy, int gz) const;
+	// Evaluates the voxel and its 6 neighbours next tick
+	void Activate(int gx, int gy, int gz);
+	// Forgets levels and active cells, after the world was regenerated
+	void Clear();
+	int CountActive() const;
+
+	// Runs the fixed ticks due after dt more seconds, without jobs everything runs on the calling thread
+	void Update(float dt, JobSystem* jobs);
+	void Tick(JobSystem* jobs);
+
+	void OnBlockChanged(int gx, int gy, int gz, BlockId block) override;
+};
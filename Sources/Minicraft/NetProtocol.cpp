@@ -0,0 +1,90 @@
+#include "pch.h"
+
+#include "NetProtocol.h"
+#include "Minicraft/Chunk.h"
+
+namespace {
+	constexpr int CHUNK_BLOCKS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+}
+
+void NetWriter::WriteUInt16(uint16_t value) {
+	buffer.push_back((uint8_t)value);
+	buffer.push_back((uint8_t)(value >> 8));
+}
+
+void NetWriter::WriteVarint(uint32_t value) {
+	// 7 bits per byte, the high bit tells another byte follows
+	while (value >= 0x80) {
+		buffer.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back((uint8_t)value);
+}
+
+void NetWriter::WriteFloat(float value) {
+	WriteBytes(&value, sizeof(value));
+}
+
+void NetWriter::WriteBytes(const void* data, size_t size) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+uint8_t NetReader::ReadByte() {
+	if (offset >= size) {
+		failed = true;
+		return 0;
+	}
+	return data[offset++];
+}
+
+uint16_t NetReader::ReadUInt16() {
+	const uint16_t low = ReadByte();
+	return low | (uint16_t)(ReadByte() << 8);
+}
+
+uint32_t NetReader::ReadVarint() {
+	uint32_t value = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		const uint8_t byte = ReadByte();
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) return value;
+	}
+	failed = true;
+	return 0;
+}
+
+float NetReader::ReadFloat() {
+	if (offset + sizeof(float) > size) {
+		failed = true;
+		offset = size;
+		return 0;
+	}
+	float value;
+	memcpy(&value, data + offset, sizeof(value));
+	offset += sizeof(value);
+	return value;
+}
+
+void EncodeChunkBlocks(const BlockId* blocks, NetWriter& writer) {
+	int start = 0;
+	while (start < CHUNK_BLOCKS) {
+		int end = start + 1;
+		while (end < CHUNK_BLOCKS && blocks[end] == blocks[start]) end++;
+		writer.WriteVarint(end - start);
+		writer.WriteByte(blocks[start]);
+		start = end;
+	}
+}
+
+bool DecodeChunkBlocks(NetReader& reader, BlockId* blocks) {
+	int filled = 0;
+	while (filled < CHUNK_BLOCKS) {
+		const uint32_t length = reader.ReadVarint();
+		const uint8_t block = reader.ReadByte();
+		if (reader.HasFailed() || length == 0 || length > (uint32_t)(CHUNK_BLOCKS - filled) || block >= COUNT) return false;
+		std::fill(blocks + filled, blocks + filled + length, (BlockId)block);
+		filled += length;
+	}
+	return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Minicraft/Block.h"
+
+// First byte of every message between WorldServer and WorldClient
+enum NetMessageType : uint8_t {
+	NM_HELLO,         // client: view radius in chunks
+	NM_POSITION,      // client: where it stands, 3 floats
+	NM_CHUNK,         // server: chunk index then its blocks, run length encoded
+	NM_UNLOAD_CHUNKS, // server: count then chunk indices, the client forgets them
+	NM_BLOCK_DELTAS,  // server: chunk count then per chunk its index, edit count, cell (2 bytes) and block of every edit
+};
+
+class NetWriter {
+	std::vector<uint8_t>& buffer;
+public:
+	// Appends to the buffer
+	explicit NetWriter(std::vector<uint8_t>& buffer) : buffer(buffer) {}
+
+	void WriteByte(uint8_t value) { buffer.push_back(value); }
+	void WriteUInt16(uint16_t value);
+	void WriteVarint(uint32_t value);
+	void WriteFloat(float value);
+	void WriteBytes(const void* data, size_t size);
+	size_t GetSize() const { return buffer.size(); }
+};
+
+// Reads past the end return 0 and mark the reader as failed
+class NetReader {
+	const uint8_t* data;
+	size_t size;
+	size_t offset = 0;
+	bool failed = false;
+public:
+	NetReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+	explicit NetReader(const std::vector<uint8_t>& message) : data(message.data()), size(message.size()) {}
+
+	uint8_t ReadByte();
+	uint16_t ReadUInt16();
+	uint32_t ReadVarint();
+	float ReadFloat();
+	bool IsAtEnd() const { return offset >= size; }
+	bool HasFailed() const { return failed; }
+};
+
+// Runs of identical blocks in storage order, as varint length then block. Terrain is layered along Y and
+// air and stone fill whole rows, so a generated chunk takes a few hundred bytes instead of 4096.
+void EncodeChunkBlocks(const BlockId* blocks, NetWriter& writer);
+bool DecodeChunkBlocks(NetReader& reader, BlockId* blocks);
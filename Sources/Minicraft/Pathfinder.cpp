@@ -0,0 +1,435 @@
+#include "pch.h"
+
+#include "Pathfinder.h"
+#include "Engine/Clock.h"
+#include "Engine/Profiler.h"
+
+namespace {
+	constexpr int CLUSTERS_PER_JOB = 4;
+	constexpr int LAYER_CELLS = CHUNK_SIZE * CHUNK_SIZE;
+	constexpr uint16_t UNREACHED = 0xFFFF;
+	constexpr uint32_t GOAL_NODE = Pathfinder::CLUSTER_COUNT * Pathfinder::MAX_CLUSTER_PORTALS;
+	constexpr uint32_t NO_PARENT = UINT32_MAX;
+	// Climbing or dropping one block, in half blocks
+	constexpr int MAX_STEP = 2;
+
+	const int sideOffsets[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+	bool IsSolid(BlockId block) {
+		return !(BlockData::Get(block).flags & BF_NO_PHYSICS);
+	}
+
+	bool IsHalf(BlockId block) {
+		return (BlockData::Get(block).flags & BF_HALF_BLOCK) != 0;
+	}
+
+	int ClusterOf(const PathCell& cell) {
+		return (cell.x >> CHUNK_SHIFT) + (cell.z >> CHUNK_SHIFT) * WORLD_SIZE;
+	}
+
+	int LocalCell(const PathCell& cell) {
+		return (cell.x & CHUNK_MASK) + (cell.z & CHUNK_MASK) * CHUNK_SIZE + cell.y * LAYER_CELLS;
+	}
+
+	PathCell CellAt(int clusterIndex, int cell) {
+		return {
+			((clusterIndex % WORLD_SIZE) << CHUNK_SHIFT) + (cell & CHUNK_MASK),
+			cell / LAYER_CELLS,
+			((clusterIndex / WORLD_SIZE) << CHUNK_SHIFT) + ((cell / CHUNK_SIZE) & CHUNK_MASK) };
+	}
+}
+
+// Scratch buffers, one set per thread running queries or rebuilds
+struct Pathfinder::ClusterSearch {
+	uint32_t stamp = 0;
+	int visited = 0;
+	std::vector<uint32_t> seen = std::vector<uint32_t>(CLUSTER_CELLS);
+	std::vector<uint16_t> dist = std::vector<uint16_t>(CLUSTER_CELLS);
+	std::vector<uint16_t> parent = std::vector<uint16_t>(CLUSTER_CELLS);
+	std::vector<uint16_t> queue = std::vector<uint16_t>(CLUSTER_CELLS);
+	std::vector<PathCell> reversed;
+
+	bool IsSeen(int cell) const { return seen[cell] == stamp; }
+};
+
+struct Pathfinder::PortalSearch {
+	uint32_t stamp = 0;
+	std::vector<uint32_t> seen = std::vector<uint32_t>(GOAL_NODE + 1);
+	std::vector<uint32_t> closed = std::vector<uint32_t>(GOAL_NODE + 1);
+	std::vector<uint32_t> cost = std::vector<uint32_t>(GOAL_NODE + 1);
+	std::vector<uint32_t> parent = std::vector<uint32_t>(GOAL_NODE + 1);
+	std::vector<std::pair<uint32_t, uint32_t>> open; // min heap on estimate then node
+	std::vector<uint16_t> goalDist;
+	std::vector<uint32_t> chain;
+};
+
+Pathfinder::Pathfinder(World* world) : world(world), clusters(CLUSTER_COUNT), isDirty(CLUSTER_COUNT, true) {}
+
+void Pathfinder::Clear() {
+	std::fill(isDirty.begin(), isDirty.end(), true);
+	anyDirty = true;
+}
+
+void Pathfinder::OnBlockChanged(int gx, int gy, int gz, BlockId block) {
+	const int cx = gx >> CHUNK_SHIFT, cz = gz >> CHUNK_SHIFT;
+	if (cx < 0 || cz < 0 || cx >= WORLD_SIZE || cz >= WORLD_SIZE) return;
+	const int index = cx + cz * WORLD_SIZE;
+	isDirty[index] = true;
+	// Crossings of a border depend on the cells of both sides
+	const int lx = gx & CHUNK_MASK, lz = gz & CHUNK_MASK;
+	if (lx == 0 && cx > 0) isDirty[index - 1] = true;
+	if (lx == CHUNK_MASK && cx + 1 < WORLD_SIZE) isDirty[index + 1] = true;
+	if (lz == 0 && cz > 0) isDirty[index - WORLD_SIZE] = true;
+	if (lz == CHUNK_MASK && cz + 1 < WORLD_SIZE) isDirty[index + WORLD_SIZE] = true;
+	anyDirty = true;
+}
+
+void Pathfinder::OnColumnLoaded(int cx, int cz) {
+	// Refresh rebuilds the borders with the neighbours too
+	isDirty[cx + cz * WORLD_SIZE] = true;
+	anyDirty = true;
+}
+
+bool Pathfinder::IsWalkable(const PathCell& cell) const {
+	if (cell.x < 0 || cell.y < 0 || cell.z < 0) return false;
+	if (cell.x >= WORLD_SIZE * CHUNK_SIZE || cell.y >= COLUMN_HEIGHT || cell.z >= WORLD_SIZE * CHUNK_SIZE) return false;
+	return clusters[ClusterOf(cell)].walkable.test(LocalCell(cell));
+}
+
+void Pathfinder::BuildCells(int clusterIndex) {
+	Cluster& cluster = clusters[clusterIndex];
+	cluster.walkable.reset();
+	cluster.half.reset();
+	const int x0 = (clusterIndex % WORLD_SIZE) << CHUNK_SHIFT, z0 = (clusterIndex / WORLD_SIZE) << CHUNK_SHIFT;
+
+	// Two more above the world for the head room of the top cells
+	BlockId column[COLUMN_HEIGHT + 2];
+	column[COLUMN_HEIGHT] = column[COLUMN_HEIGHT + 1] = EMPTY;
+	for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+		for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+			// Chunks still loading are solid, nothing walks into them
+			for (int y = 0; y < COLUMN_HEIGHT; y++) {
+				const BlockId* block = world->GetCube(x0 + lx, y, z0 + lz);
+				column[y] = block ? *block : BEDROCK;
+			}
+			for (int y = 0; y < COLUMN_HEIGHT; y++) {
+				const int cell = lx + lz * CHUNK_SIZE + y * LAYER_CELLS;
+				const BlockId below = y > 0 ? column[y - 1] : EMPTY;
+				if (IsHalf(column[y])) {
+					if (!IsSolid(column[y + 1]) && !IsSolid(column[y + 2])) {
+						cluster.walkable.set(cell);
+						cluster.half.set(cell);
+					}
+				} else if (!IsSolid(column[y]) && !IsSolid(column[y + 1]) && IsSolid(below) && !IsHalf(below)) {
+					cluster.walkable.set(cell);
+				}
+			}
+		}
+	}
+}
+
+void Pathfinder::BuildBorder(int clusterIndex, int axis) {
+	Cluster& cluster = clusters[clusterIndex];
+	auto& border = cluster.borders[axis];
+	border.clear();
+	const int cx = clusterIndex % WORLD_SIZE, cz = clusterIndex / WORLD_SIZE;
+	if ((axis == 0 ? cx : cz) + 1 >= WORLD_SIZE) return;
+	const int nextIndex = clusterIndex + (axis == 0 ? 1 : WORLD_SIZE);
+	const Cluster& next = clusters[nextIndex];
+
+	// Height step taken to cross at each position along the border and height, NO_CROSSING when none
+	constexpr int8_t NO_CROSSING = INT8_MIN;
+	int8_t crossing[CHUNK_SIZE][COLUMN_HEIGHT];
+	auto insideCell = [&](int t, int y) { return (axis == 0 ? CHUNK_MASK + t * CHUNK_SIZE : t + CHUNK_MASK * CHUNK_SIZE) + y * LAYER_CELLS; };
+	auto outsideCell = [&](int t, int y) { return (axis == 0 ? t * CHUNK_SIZE : t) + y * LAYER_CELLS; };
+	for (int t = 0; t < CHUNK_SIZE; t++) {
+		for (int y = 0; y < COLUMN_HEIGHT; y++) {
+			crossing[t][y] = NO_CROSSING;
+			const int inside = insideCell(t, y);
+			if (!cluster.walkable.test(inside)) continue;
+			const int height = 2 * y + cluster.half.test(inside);
+			for (int dy : { 0, 1, -1 }) {
+				const int ny = y + dy;
+				if (ny < 0 || ny >= COLUMN_HEIGHT) continue;
+				const int outside = outsideCell(t, ny);
+				if (next.walkable.test(outside) && abs(2 * ny + next.half.test(outside) - height) <= MAX_STEP) {
+					crossing[t][y] = (int8_t)dy;
+					break;
+				}
+			}
+		}
+	}
+
+	// Crossings next to each other along the border make one entrance, crossed at its middle
+	bool grouped[CHUNK_SIZE][COLUMN_HEIGHT] = {};
+	std::vector<std::pair<int, int>> group, stack;
+	for (int t = 0; t < CHUNK_SIZE; t++) {
+		for (int y = 0; y < COLUMN_HEIGHT; y++) {
+			if (crossing[t][y] == NO_CROSSING || grouped[t][y]) continue;
+			group.clear();
+			stack.push_back({ t, y });
+			grouped[t][y] = true;
+			while (!stack.empty()) {
+				const auto [gt, gy] = stack.back();
+				stack.pop_back();
+				group.push_back({ gt, gy });
+				for (int nt : { gt - 1, gt + 1 }) {
+					if (nt < 0 || nt >= CHUNK_SIZE) continue;
+					for (int ny = std::max(gy - 1, 0); ny <= std::min(gy + 1, COLUMN_HEIGHT - 1); ny++) {
+						if (crossing[nt][ny] == NO_CROSSING || grouped[nt][ny]) continue;
+						grouped[nt][ny] = true;
+						stack.push_back({ nt, ny });
+					}
+				}
+			}
+			if ((int)border.size() == MAX_BORDER_PORTALS) continue;
+			std::sort(group.begin(), group.end());
+			const auto [mt, my] = group[group.size() / 2];
+			border.push_back({ CellAt(clusterIndex, insideCell(mt, my)), CellAt(nextIndex, outsideCell(mt, my + crossing[mt][my])) });
+		}
+	}
+}
+
+void Pathfinder::Flood(const Cluster& cluster, int from, int stopAt, ClusterSearch& search) const {
+	if (++search.stamp == 0) {
+		std::fill(search.seen.begin(), search.seen.end(), 0);
+		search.stamp = 1;
+	}
+	int head = 0, tail = 0;
+	search.queue[tail++] = (uint16_t)from;
+	search.seen[from] = search.stamp;
+	search.dist[from] = 0;
+	while (head < tail) {
+		const int cell = search.queue[head++];
+		if (cell == stopAt) break;
+		const int lx = cell & CHUNK_MASK, lz = (cell / CHUNK_SIZE) & CHUNK_MASK, y = cell / LAYER_CELLS;
+		const int height = 2 * y + cluster.half.test(cell);
+		for (auto& offset : sideOffsets) {
+			const int nx = lx + offset[0], nz = lz + offset[1];
+			if (nx < 0 || nz < 0 || nx >= CHUNK_SIZE || nz >= CHUNK_SIZE) continue;
+			for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, COLUMN_HEIGHT - 1); ny++) {
+				const int next = nx + nz * CHUNK_SIZE + ny * LAYER_CELLS;
+				if (!cluster.walkable.test(next) || search.seen[next] == search.stamp) continue;
+				if (abs(2 * ny + cluster.half.test(next) - height) > MAX_STEP) continue;
+				search.seen[next] = search.stamp;
+				search.dist[next] = search.dist[cell] + 1;
+				search.parent[next] = (uint16_t)cell;
+				search.queue[tail++] = (uint16_t)next;
+			}
+		}
+	}
+	search.visited += head;
+}
+
+void Pathfinder::BuildEdges(int clusterIndex) {
+	thread_local ClusterSearch search;
+	Cluster& cluster = clusters[clusterIndex];
+	const int cx = clusterIndex % WORLD_SIZE, cz = clusterIndex / WORLD_SIZE;
+
+	cluster.portals.clear();
+	cluster.sideStart[SIDE_EAST] = 0;
+	for (auto& transition : cluster.borders[0])
+		cluster.portals.push_back(transition.inside);
+	cluster.sideStart[SIDE_SOUTH] = (uint16_t)cluster.portals.size();
+	for (auto& transition : cluster.borders[1])
+		cluster.portals.push_back(transition.inside);
+	cluster.sideStart[SIDE_WEST] = (uint16_t)cluster.portals.size();
+	if (cx > 0)
+		for (auto& transition : clusters[clusterIndex - 1].borders[0])
+			cluster.portals.push_back(transition.outside);
+	cluster.sideStart[SIDE_NORTH] = (uint16_t)cluster.portals.size();
+	if (cz > 0)
+		for (auto& transition : clusters[clusterIndex - WORLD_SIZE].borders[1])
+			cluster.portals.push_back(transition.outside);
+	cluster.sideStart[SIDE_COUNT] = (uint16_t)cluster.portals.size();
+
+	const int count = (int)cluster.portals.size();
+	cluster.edges.resize(count);
+	for (int i = 0; i < count; i++) {
+		auto& edges = cluster.edges[i];
+		edges.clear();
+		Flood(cluster, LocalCell(cluster.portals[i]), -1, search);
+		for (int j = 0; j < count; j++) {
+			const int cell = LocalCell(cluster.portals[j]);
+			if (j != i && search.IsSeen(cell))
+				edges.push_back({ (uint16_t)j, search.dist[cell] });
+		}
+	}
+}
+
+int Pathfinder::GetLinkedPortal(int clusterIndex, int portal, int& linkedCluster) const {
+	const Cluster& cluster = clusters[clusterIndex];
+	int side = SIDE_EAST;
+	while (portal >= cluster.sideStart[side + 1]) side++;
+	const int index = portal - cluster.sideStart[side];
+	static const int opposite[SIDE_COUNT] = { SIDE_WEST, SIDE_NORTH, SIDE_EAST, SIDE_SOUTH };
+	static const int step[SIDE_COUNT] = { 1, WORLD_SIZE, -1, -WORLD_SIZE };
+	linkedCluster = clusterIndex + step[side];
+	return clusters[linkedCluster].sideStart[opposite[side]] + index;
+}
+
+void Pathfinder::Refresh(JobSystem* jobs) {
+	stats.rebuiltClusters = 0;
+	if (!anyDirty) return;
+	PROFILE_ZONE("Pathfinder::Refresh");
+	auto& clock = DX::SystemClock::Get();
+	const uint64_t start = clock.GetCounter();
+
+	// A border is rebuilt when either side changed, then the portals of both sides
+	std::vector<int> cells, borders, edges;
+	for (int index = 0; index < CLUSTER_COUNT; index++) {
+		const int cx = index % WORLD_SIZE, cz = index / WORLD_SIZE;
+		const bool east = cx + 1 < WORLD_SIZE && isDirty[index + 1];
+		const bool south = cz + 1 < WORLD_SIZE && isDirty[index + WORLD_SIZE];
+		const bool west = cx > 0 && isDirty[index - 1];
+		const bool north = cz > 0 && isDirty[index - WORLD_SIZE];
+		if (isDirty[index]) cells.push_back(index);
+		if (isDirty[index] || east || south) borders.push_back(index);
+		if (isDirty[index] || east || south || west || north) edges.push_back(index);
+	}
+
+	auto run = [&](const std::vector<int>& list, auto fn) {
+		auto range = [&](int begin, int end) {
+			for (int i = begin; i < end; i++)
+				fn(list[i]);
+		};
+		if (jobs)
+			jobs->ParallelFor((int)list.size(), CLUSTERS_PER_JOB, range);
+		else
+			range(0, (int)list.size());
+	};
+	run(cells, [&](int index) { BuildCells(index); });
+	run(borders, [&](int index) { BuildBorder(index, 0); BuildBorder(index, 1); });
+	run(edges, [&](int index) { BuildEdges(index); });
+
+	std::fill(isDirty.begin(), isDirty.end(), false);
+	anyDirty = false;
+	stats.rebuiltClusters = (int)cells.size();
+	stats.portals = 0;
+	stats.portalEdges = 0;
+	for (auto& cluster : clusters) {
+		stats.portals += (int)cluster.portals.size();
+		for (auto& portalEdges : cluster.edges)
+			stats.portalEdges += (int)portalEdges.size();
+	}
+	stats.refreshMs = clock.MillisecondsSince(start);
+}
+
+bool Pathfinder::Refine(int clusterIndex, const PathCell& from, const PathCell& to, std::vector<PathCell>& path, ClusterSearch& search) const {
+	if (from == to) return true;
+	const int target = LocalCell(to);
+	Flood(clusters[clusterIndex], LocalCell(from), target, search);
+	if (!search.IsSeen(target)) return false;
+	const int origin = LocalCell(from);
+	search.reversed.clear();
+	for (int cell = target; cell != origin; cell = search.parent[cell])
+		search.reversed.push_back(CellAt(clusterIndex, cell));
+	path.insert(path.end(), search.reversed.rbegin(), search.reversed.rend());
+	return true;
+}
+
+bool Pathfinder::FindPath(const PathCell& start, const PathCell& goal, std::vector<PathCell>& path, PathQueryStats* queryStats) const {
+	thread_local ClusterSearch cells;
+	thread_local PortalSearch portals;
+	path.clear();
+	cells.visited = 0;
+	int expanded = 0;
+	auto report = [&](bool found) {
+		if (queryStats) {
+			queryStats->expandedPortals = expanded;
+			queryStats->visitedCells = cells.visited;
+		}
+		if (!found) path.clear();
+		return found;
+	};
+	if (!IsWalkable(start) || !IsWalkable(goal)) return report(false);
+
+	// Inside one cluster the local search is enough, unless the way goes out and back
+	const int startCluster = ClusterOf(start), goalCluster = ClusterOf(goal);
+	path.push_back(start);
+	if (startCluster == goalCluster && Refine(startCluster, start, goal, path, cells))
+		return report(true);
+
+	// Moves are symmetric, the distances from the goal are those to the goal
+	const Cluster& goalPortals = clusters[goalCluster];
+	Flood(goalPortals, LocalCell(goal), -1, cells);
+	portals.goalDist.assign(goalPortals.portals.size(), UNREACHED);
+	for (size_t i = 0; i < goalPortals.portals.size(); i++) {
+		const int cell = LocalCell(goalPortals.portals[i]);
+		if (cells.IsSeen(cell)) portals.goalDist[i] = cells.dist[cell];
+	}
+
+	if (++portals.stamp == 0) {
+		std::fill(portals.seen.begin(), portals.seen.end(), 0);
+		std::fill(portals.closed.begin(), portals.closed.end(), 0);
+		portals.stamp = 1;
+	}
+	portals.open.clear();
+	auto estimate = [&](uint32_t node) {
+		if (node == GOAL_NODE) return 0;
+		const PathCell& cell = clusters[node / MAX_CLUSTER_PORTALS].portals[node % MAX_CLUSTER_PORTALS];
+		return abs(cell.x - goal.x) + abs(cell.z - goal.z);
+	};
+	auto relax = [&](uint32_t node, uint32_t cost, uint32_t parent) {
+		if (portals.closed[node] == portals.stamp) return;
+		if (portals.seen[node] == portals.stamp && portals.cost[node] <= cost) return;
+		portals.seen[node] = portals.stamp;
+		portals.cost[node] = cost;
+		portals.parent[node] = parent;
+		portals.open.push_back({ cost + estimate(node), node });
+		std::push_heap(portals.open.begin(), portals.open.end(), std::greater<std::pair<uint32_t, uint32_t>>());
+	};
+
+	const Cluster& startPortals = clusters[startCluster];
+	Flood(startPortals, LocalCell(start), -1, cells);
+	for (size_t i = 0; i < startPortals.portals.size(); i++) {
+		const int cell = LocalCell(startPortals.portals[i]);
+		if (cells.IsSeen(cell))
+			relax(startCluster * MAX_CLUSTER_PORTALS + (uint32_t)i, cells.dist[cell], NO_PARENT);
+	}
+
+	bool found = false;
+	while (!portals.open.empty()) {
+		std::pop_heap(portals.open.begin(), portals.open.end(), std::greater<std::pair<uint32_t, uint32_t>>());
+		const uint32_t node = portals.open.back().second;
+		portals.open.pop_back();
+		if (portals.closed[node] == portals.stamp) continue;
+		portals.closed[node] = portals.stamp;
+		if (node == GOAL_NODE) {
+			found = true;
+			break;
+		}
+		expanded++;
+
+		const int clusterIndex = node / MAX_CLUSTER_PORTALS, portal = node % MAX_CLUSTER_PORTALS;
+		const uint32_t cost = portals.cost[node];
+		if (clusterIndex == goalCluster && portals.goalDist[portal] != UNREACHED)
+			relax(GOAL_NODE, cost + portals.goalDist[portal], node);
+		for (auto& edge : clusters[clusterIndex].edges[portal])
+			relax(clusterIndex * MAX_CLUSTER_PORTALS + edge.target, cost + edge.cost, node);
+		int linkedCluster;
+		const int linked = GetLinkedPortal(clusterIndex, portal, linkedCluster);
+		relax(linkedCluster * MAX_CLUSTER_PORTALS + linked, cost + 1, node);
+	}
+	if (!found) return report(false);
+
+	portals.chain.clear();
+	for (uint32_t node = portals.parent[GOAL_NODE]; node != NO_PARENT; node = portals.parent[node])
+		portals.chain.push_back(node);
+
+	// Portals of one cluster are joined by walking its cells, linked portals are next to each other
+	PathCell previous = start;
+	int previousCluster = startCluster;
+	for (auto it = portals.chain.rbegin(); it != portals.chain.rend(); ++it) {
+		const int clusterIndex = *it / MAX_CLUSTER_PORTALS;
+		const PathCell& cell = clusters[clusterIndex].portals[*it % MAX_CLUSTER_PORTALS];
+		if (clusterIndex == previousCluster)
+			Refine(clusterIndex, previous, cell, path, cells);
+		else
+			path.push_back(cell);
+		previous = cell;
+		previousCluster = clusterIndex;
+	}
+	Refine(goalCluster, previous, goal, path, cells);
+	return report(true);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Engine/JobSystem.h"
+#include "Minicraft/Block.h"
+#include "Minicraft/Chunk.h"
+#include "Minicraft/World.h"
+
+// Feet of a walker: the voxel it stands in, on top of the block below or of a half slab in it
+struct PathCell {
+	int x, y, z;
+
+	bool operator==(const PathCell& other) const { return x == other.x && y == other.y && z == other.z; }
+	bool operator!=(const PathCell& other) const { return !(*this == other); }
+};
+
+// Counters of the last Refresh
+struct PathfinderStats {
+	int rebuiltClusters = 0;
+	int portals = 0;      // over the whole world
+	int portalEdges = 0;
+	double refreshMs = 0;
+};
+
+struct PathQueryStats {
+	int expandedPortals = 0;
+	int visitedCells = 0; // by the searches inside clusters, refinement included
+};
+
+// Hierarchical pathfinding for 2 blocks tall walkers, moving to the 4 side neighbours and climbing or dropping
+// one block at most. Each chunk column is a cluster: its walkable cells are cached in bitsets, and every stretch
+// of cells crossing to a neighbour column gets one portal, with the walking distances between the portals of a
+// cluster precomputed. A query runs A* over the portals then walks the cells between consecutive ones.
+// Edits only mark their column, and the columns across when on the border, for the next Refresh, as does a column
+// streaming in. Game::Update refreshes once per tick, after the systems editing the world.
+class Pathfinder : public IBlockListener {
+public:
+	static constexpr int CLUSTER_COUNT = WORLD_SIZE * WORLD_SIZE;
+	static constexpr int COLUMN_HEIGHT = WORLD_HEIGHT * CHUNK_SIZE;
+	static constexpr int CLUSTER_CELLS = CHUNK_SIZE * CHUNK_SIZE * COLUMN_HEIGHT;
+	static constexpr int MAX_BORDER_PORTALS = 64;
+	static constexpr int MAX_CLUSTER_PORTALS = 4 * MAX_BORDER_PORTALS;
+private:
+	enum Side { SIDE_EAST, SIDE_SOUTH, SIDE_WEST, SIDE_NORTH, SIDE_COUNT };
+
+	struct Transition {
+		PathCell inside;  // this cluster
+		PathCell outside; // the neighbour along +X or +Z
+	};
+	struct PortalEdge {
+		uint16_t target;
+		uint16_t cost;
+	};
+	struct Cluster {
+		// Cell lx + lz * CHUNK_SIZE + y * CHUNK_SIZE * CHUNK_SIZE
+		std::bitset<CLUSTER_CELLS> walkable;
+		std::bitset<CLUSTER_CELLS> half; // standing on a half slab, half a block higher
+		std::vector<Transition> borders[2]; // owned: +X and +Z
+		// Portals of the +X, +Z, -X and -Z borders in that order, those of -X and -Z mirror the neighbours' borders
+		std::vector<PathCell> portals;
+		uint16_t sideStart[SIDE_COUNT + 1] = {};
+		std::vector<std::vector<PortalEdge>> edges;
+	};
+	struct ClusterSearch;
+	struct PortalSearch;
+
+	World* world;
+	std::vector<Cluster> clusters;
+	std::vector<bool> isDirty;
+	bool anyDirty = true;
+
+	void BuildCells(int clusterIndex);
+	void BuildBorder(int clusterIndex, int axis);
+	void BuildEdges(int clusterIndex);
+	// Breadth first over the walkable cells of a cluster, stops once stopAt is reached
+	void Flood(const Cluster& cluster, int from, int stopAt, ClusterSearch& search) const;
+	// Appends the cells after from up to to, both in the given cluster
+	bool Refine(int clusterIndex, const PathCell& from, const PathCell& to, std::vector<PathCell>& path, ClusterSearch& search) const;
+	int GetLinkedPortal(int clusterIndex, int portal, int& linkedCluster) const;
+public:
+	PathfinderStats stats;
+
+	explicit Pathfinder(World* world);
+
+	// Rebuilds everything on the next Refresh
+	void Clear();
+	// Rebuilds the clusters edited since the last call. Not while queries run, without jobs everything runs on the calling thread.
+	void Refresh(JobSystem* jobs);
+
+	bool IsWalkable(const PathCell& cell) const;
+	// Thread safe against other queries. Returns false when the goal can't be reached,
+	// otherwise path holds every cell from start to goal included.
+	bool FindPath(const PathCell& start, const PathCell& goal, std::vector<PathCell>& path, PathQueryStats* queryStats = nullptr) const;
+
+	void OnBlockChanged(int gx, int gy, int gz, BlockId block) override;
+	void OnColumnLoaded(int cx, int cz) override;
+};
@@ -1,30 +1,38 @@
 #include "pch.h"
 
 #include "Engine/DefaultResources.h"
+#include "Engine/Profiler.h"
 #include "Player.h"
 #include "Utils.h"
+#include "VoxelCollider.h"
+#include "VoxelCursor.h"
 
 using ButtonState = Mouse::ButtonStateTracker::ButtonState;
 
-Vector3 collisionPoints[] = {
-	{ 0.3f,     0,     0},
-	{-0.3f,     0,     0},
-	{    0,     0,  0.3f},
-	{    0,     0, -0.3f},
-	{    0, -0.5f,     0},
-	{ 0.3f,  1.0f,     0},
-	{-0.3f,  1.0f,     0},
-	{    0,  1.0f,  0.3f},
-	{    0,  1.0f, -0.3f},
-	{    0,  1.5f,     0},
-};
-
-void Player::GenerateGPUResources(DeviceResources* deviceRes) {
-	currentCube.Generate(deviceRes);
-	highlightCube.Generate(deviceRes);
+// Body around the position, which is half a block above the feet
+const Vector3 bodyMin(-0.3f, -0.5f, -0.3f);
+const Vector3 bodyMax(0.3f, 1.4f, 0.3f);
+// Half slabs can be walked onto, full blocks need a jump
+const float stepHeight = 0.55f;
+
+Player::Player(World* w, Vector3 pos) : world(w), position(pos) {
+	camera.SetPosition(position + Vector3(0, 1.25f, 0));
+	previousEye = camera.GetPosition();
+	previousRotation = camera.GetRotation();
+}
+
+void Player::SetBlock(int gx, int gy, int gz, BlockId block) {
+	if (edits)
+		edits->Push(gx, gy, gz, block);
+	else
+		world->UpdateBlock(gx, gy, gz, block);
 }
 
 void Player::Update(float dt, DirectX::Keyboard::State kb, DirectX::Mouse::State ms) {
+	PROFILE_ZONE("Player::Update");
+
+	previousEye = camera.GetPosition();
+	previousRotation = camera.GetRotation();
 	keyboardTracker.Update(kb);
 	mouseTracker.Update(ms);
 
@@ -36,66 +44,52 @@ void Player::Update(float dt, DirectX::Keyboard::State kb, DirectX::Mouse::State
 	Vector3 move = Vector3::TransformNormal(delta, camera.GetInverseViewMatrix());
 	move.y = 0.0;
 	move.Normalize();
-	position += move * walkSpeed * dt;
 
 	Quaternion camRot = camera.GetRotation();
 	camRot *= Quaternion::CreateFromAxisAngle(camera.Right(), -ms.y * dt * 0.25f);
 	camRot *= Quaternion::CreateFromAxisAngle(Vector3::Up, -ms.x * dt * 0.25f);
-	
-	velocityY += -30 * dt;
 
-	Vector3 nextPos = position + Vector3(0, velocityY, 0) * dt;
-	auto downBlock = world->GetCube(floor(nextPos.x + 0.5f), floor(nextPos.y), floor(nextPos.z + 0.5f));
-	if (downBlock) {
-		auto& blockData = BlockData::Get(*downBlock);
-		if (!(blockData.flags & BF_NO_PHYSICS)) {
-			velocityY = -5 * dt;
-			if (kb.Space)
-				velocityY = 10.0f;
-		} else if (blockData.flags & BF_GRAVITY_WATER) {
-			velocityY *= 0.7;
-			if (kb.Space)
-				velocityY = 10.0f;
-		}
-	}
-	position += Vector3(0, velocityY, 0) * dt;
-
-	for (auto colPoint : collisionPoints) {
-		Vector3 colPos = position + colPoint + Vector3(0.5f, 0.5f, 0.5f);
-
-		auto block = world->GetCube(floor(colPos.x), floor(colPos.y), floor(colPos.z));
-		if (block) {
-			auto& blockData = BlockData::Get(*block);
-			if (blockData.flags & BF_NO_PHYSICS) continue;
-
-			if (colPoint.x != 0)
-				position.x += round(colPos.x) - colPos.x;
-			if (colPoint.z != 0)
-				position.z += round(colPos.z) - colPos.z;
-			if (colPoint.y != 0 && colPoint.x == 0 && colPoint.z == 0)
-				position.y += round(colPos.y) - colPos.y;
-		}
+	VoxelCursor cursor(world, floor(position.x + 0.5f), floor(position.y + 0.5f), floor(position.z + 0.5f));
+	auto bodyBlock = cursor.Get();
+	const bool inWater = bodyBlock && (BlockData::Get(*bodyBlock).flags & BF_GRAVITY_WATER);
+
+	velocityY += -30 * dt;
+	if (inWater) {
+		velocityY *= 0.7;
+		if (kb.Space)
+			velocityY = 10.0f;
+	} else if (onGround && kb.Space) {
+		velocityY = 10.0f;
 	}
 
+	VoxelCollider collider(world);
+	CollisionBox body = { position + bodyMin, position + bodyMax };
+	auto collision = collider.Move(body, move * walkSpeed * dt + Vector3(0, velocityY * dt, 0), onGround ? stepHeight : 0);
+	position = body.min - bodyMin;
+	onGround = collision.onGround;
+	if (collision.hit[1])
+		velocityY = 0;
+
 	camera.SetRotation(camRot);
 	camera.SetPosition(position + Vector3(0, 1.25f, 0));
 	highlightCube.model = Matrix::Identity;
 
 	auto cubes = Raycast(camera.GetPosition() + Vector3(0.5, 0.5, 0.5), camera.Forward(), 5);
 	for (int i = 0; i < cubes.size(); i++) {
-		auto block = world->GetCube(cubes[i][0], cubes[i][1], cubes[i][2]);
+		cursor.MoveTo(cubes[i][0], cubes[i][1], cubes[i][2]);
+		auto block = cursor.Get();
 		if (!block) continue;
 		auto& blockData = BlockData::Get(*block);
 		if (blockData.flags & BF_NO_RAYCAST) continue;
 
 		highlightCube.model = Matrix::CreateTranslation(cubes[i][0], cubes[i][1], cubes[i][2]);
 		if (mouseTracker.leftButton == ButtonState::PRESSED) {
-			world->UpdateBlock(cubes[i][0], cubes[i][1], cubes[i][2], EMPTY);
+			SetBlock(cubes[i][0], cubes[i][1], cubes[i][2], EMPTY);
 		} else if(mouseTracker.rightButton == ButtonState::PRESSED && i > 0) {
 			if (blockData.flags & BF_HALF_BLOCK && *block == currentCube.GetBlockId()) {
-				world->UpdateBlock(cubes[i][0], cubes[i][1], cubes[i][2], (BlockId)((int)currentCube.GetBlockId() + 1));
+				SetBlock(cubes[i][0], cubes[i][1], cubes[i][2], (BlockId)((int)currentCube.GetBlockId() + 1));
 			} else {
-				world->UpdateBlock(cubes[i - 1][0], cubes[i - 1][1], cubes[i - 1][2], currentCube.GetBlockId());
+				SetBlock(cubes[i - 1][0], cubes[i - 1][1], cubes[i - 1][2], currentCube.GetBlockId());
 			}
 		}
 		break;
@@ -109,23 +103,19 @@ void Player::Update(float dt, DirectX::Keyboard::State kb, DirectX::Mouse::State
 
 }
 
-void Player::Draw(DeviceResources* deviceRes) {
-	auto gpuRes = DefaultResources::Get();
-
-	gpuRes->noDepth.Apply(deviceRes);
-	gpuRes->cbModel.ApplyToVS(deviceRes, 0);
+void Player::Interpolate(float alpha, Camera& renderCamera) const {
+	renderCamera.SetRotation(Quaternion::Slerp(previousRotation, camera.GetRotation(), alpha));
+	renderCamera.SetPosition(Vector3::Lerp(previousEye, camera.GetPosition(), alpha));
+}
 
-	Matrix cubePos = Matrix::CreateTranslation(1.5,-1.5,-2) * camera.GetInverseViewMatrix();
-	gpuRes->cbModel.data.model = cubePos.Transpose();
-	gpuRes->cbModel.UpdateBuffer(deviceRes);
-	currentCube.Draw(deviceRes);
+void Player::Draw(DeviceResources* deviceRes, RenderCommandList& commands, RenderState state) {
+	auto gpuRes = DefaultResources::Get();
+	state.blend = &gpuRes->alphaBlend;
 
-	gpuRes->depthEqual.Apply(deviceRes);
-	gpuRes->cbModel.data.model = highlightCube.model.Transpose();
-	gpuRes->cbModel.UpdateBuffer(deviceRes);
-	highlightCube.Draw(deviceRes);
+	state.depth = &gpuRes->noDepth;
+	Matrix cubePos = Matrix::CreateTranslation(1.5,-1.5,-2) * state.camera->GetInverseViewMatrix();
+	commands.Add(RP_OVERLAY, state, currentCube.GetGeometry(), cubePos);
 
-	gpuRes->cbModel.data.model = Matrix::Identity;
-	gpuRes->cbModel.UpdateBuffer(deviceRes);
-	gpuRes->defaultDepth.Apply(deviceRes);
+	state.depth = &gpuRes->depthEqual;
+	commands.Add(RP_OVERLAY, state, highlightCube.GetGeometry(), highlightCube.model);
 }
@@ -3,31 +3,44 @@
 #include "Engine/DepthState.h"
 #include "Engine/Camera.h"
 #include "Minicraft/World.h"
+#include "Minicraft/WorldEditQueue.h"
 #include "Minicraft/Cube3D.h"
 
 using namespace DirectX::SimpleMath;
 
 class Player {
 	World* world = nullptr;
+	WorldEditQueue* edits = nullptr;
 
 	Vector3 position = Vector3();
 	float velocityY = 0;
+	bool onGround = false;
 
 	float walkSpeed = 10.0f;
 
+	// Simulation camera, moved by Update at the fixed tick rate
 	PerspectiveCamera camera = PerspectiveCamera(75, 1);
+	Vector3 previousEye;
+	Quaternion previousRotation;
 
 	Cube3D currentCube = Cube3D(HALF_SLAB);
 	Cube3D highlightCube = Cube3D(HIGHLIGHT);
 
 	DirectX::Mouse::ButtonStateTracker      mouseTracker;
 	DirectX::Keyboard::KeyboardStateTracker keyboardTracker;
+
+	void SetBlock(int gx, int gy, int gz, BlockId block);
 public:
-	Player(World* w, Vector3 pos) : world(w), position(pos) {}
+	Player(World* w, Vector3 pos);
 
-	void GenerateGPUResources(DeviceResources* deviceRes);
+	// Block edits go through the queue when set, applied at its next drain, else straight to the world
+	void SetEditQueue(WorldEditQueue* queue) { edits = queue; }
 	void Update(float dt, DirectX::Keyboard::State kb, DirectX::Mouse::State ms);
-	void Draw(DeviceResources* deviceRes);
+	// Places the render camera between the two last simulation cameras, alpha is the fraction of a tick elapsed since the last Update
+	void Interpolate(float alpha, Camera& renderCamera) const;
+	// Records the held block and the highlight on top of the world, relative to state.camera
+	void Draw(DeviceResources* deviceRes, RenderCommandList& commands, RenderState state);
 
 	PerspectiveCamera* GetCamera() { return &camera; }
+	Vector3 GetEyePosition() const { return camera.GetPosition(); }
 };
@@ -1,5 +1,6 @@
 #include "pch.h"
 
+#include "Engine/Profiler.h"
 #include "Utils.h"
 
 Vector4 ToVec4(const Vector3& v) {
@@ -21,6 +22,8 @@ int signInt(int v) {
 }
 
 std::vector<std::array<int, 3>> Raycast(Vector3 pos, Vector3 dir, float maxDist) {
+	PROFILE_ZONE("Raycast");
+
 	std::map<float, std::array<int, 3>> cubes;
 
 	if (dir.x != 0) {
@@ -1,5 +1,9 @@
 #pragma once
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 using namespace DirectX::SimpleMath;
 
 Vector4 ToVec4(const Vector3& v);
@@ -7,4 +11,24 @@ Vector4 ToVec4Normal(const Vector3& v);
 
 float sign(float v);
 int signInt(int v);
-std::vector<std::array<int, 3>> Raycast(Vector3 pos, Vector3 dir, float maxDist);
\ No newline at end of file
+std::vector<std::array<int, 3>> Raycast(Vector3 pos, Vector3 dir, float maxDist);
+
+// Index of the lowest set bit, v must not be 0
+inline int CountTrailingZeros(uint32_t v) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward(&idx, v);
+	return (int)idx;
+#else
+	return __builtin_ctz(v);
+#endif
+}
+
+// FNV-1a, used to fingerprint runs (edits, camera path) so replays can be compared
+constexpr uint32_t FNV_OFFSET_BASIS = 2166136261u;
+inline uint32_t HashBytes(uint32_t hash, const void* data, size_t size) {
+	auto bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 16777619u;
+	return hash;
+}
@@ -0,0 +1,135 @@
+#include "pch.h"
+
+#include "Engine/Profiler.h"
+#include "VoxelCollider.h"
+
+namespace {
+	// Touching boxes don't collide, and a box resting on a block stays just above it
+	constexpr float EPSILON = 1e-4f;
+
+	float Get(const Vector3& v, int axis) { return axis == 0 ? v.x : (axis == 1 ? v.y : v.z); }
+	void Add(Vector3& v, int axis, float value) { (axis == 0 ? v.x : (axis == 1 ? v.y : v.z)) += value; }
+
+	// Blocks whose span overlaps ]lo, hi[
+	int FirstBlock(float lo) { return (int)floor(lo + 0.5f + EPSILON); }
+	int LastBlock(float hi) { return (int)ceil(hi + 0.5f - EPSILON) - 1; }
+}
+
+template<typename TFn>
+void VoxelCollider::ForEachSolid(const CollisionBox& area, const TFn& fn) const {
+	const int x0 = FirstBlock(area.min.x), x1 = LastBlock(area.max.x);
+	const int y0 = FirstBlock(area.min.y), y1 = LastBlock(area.max.y);
+	const int z0 = FirstBlock(area.min.z), z1 = LastBlock(area.max.z);
+
+	auto emit = [&](int x, int y, int z, bool half) {
+		CollisionBox block = { Vector3(x - 0.5f, y - 0.5f, z - 0.5f), Vector3(x + 0.5f, half ? y : y + 0.5f, z + 0.5f) };
+		fn(block);
+	};
+
+	for (int cx = x0 >> CHUNK_SHIFT; cx <= x1 >> CHUNK_SHIFT; cx++) {
+		const int bx = cx << CHUNK_SHIFT;
+		const int lx0 = std::max(x0 - bx, 0);
+		const int lx1 = std::min(x1 - bx, CHUNK_MASK);
+		const uint32_t columns = ((2u << lx1) - 1) & ~((1u << lx0) - 1);
+
+		for (int z = z0; z <= z1; z++) {
+			for (int y = y0; y <= y1; y++) {
+				Chunk* chunk = world->GetChunk(cx, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+				if (!chunk) continue;
+				if (!chunk->IsLoaded()) {
+					for (int lx = lx0; lx <= lx1; lx++)
+						emit(bx + lx, y, z, false);
+					continue;
+				}
+
+				const int row = (y & CHUNK_MASK) + (z & CHUNK_MASK) * CHUNK_SIZE;
+				uint32_t solid = chunk->solidRows[row] & columns;
+				while (solid) {
+					const int lx = CountTrailingZeros(solid);
+					solid &= solid - 1;
+					emit(bx + lx, y, z, (chunk->halfRows[row] >> lx) & 1);
+				}
+			}
+		}
+	}
+}
+
+bool VoxelCollider::Overlaps(const CollisionBox& box) const {
+	bool overlaps = false;
+	ForEachSolid(box, [&](const CollisionBox& block) {
+		// Half blocks only fill the bottom of their cell
+		if (block.max.y > box.min.y + EPSILON) overlaps = true;
+	});
+	return overlaps;
+}
+
+float VoxelCollider::ClipAxis(const CollisionBox& box, int axis, float wanted) const {
+	if (wanted == 0) return 0;
+
+	float delta = wanted;
+	CollisionBox swept = box;
+	if (wanted > 0) Add(swept.max, axis, wanted);
+	else Add(swept.min, axis, wanted);
+
+	ForEachSolid(swept, [&](const CollisionBox& block) {
+		// The other axes must really overlap, half blocks make the swept rows too generous on Y
+		for (int other = 0; other < 3; other++) {
+			if (other == axis) continue;
+			if (Get(block.max, other) <= Get(box.min, other) + EPSILON || Get(block.min, other) >= Get(box.max, other) - EPSILON) return;
+		}
+		// Blocks already overlapping the box are ignored so it can always get out of them
+		if (wanted > 0 && Get(block.min, axis) >= Get(box.max, axis) - EPSILON)
+			delta = std::min(delta, Get(block.min, axis) - Get(box.max, axis) - EPSILON);
+		else if (wanted < 0 && Get(block.max, axis) <= Get(box.min, axis) + EPSILON)
+			delta = std::max(delta, Get(block.max, axis) - Get(box.min, axis) + EPSILON);
+	});
+	// Resting against a block leaves a gap smaller than EPSILON, which must not push the box back
+	if ((wanted > 0) != (delta > 0)) return 0;
+	return delta;
+}
+
+CollisionResult VoxelCollider::MoveAxes(CollisionBox& box, const Vector3& delta) const {
+	CollisionResult result;
+	for (int axis : { 1, 0, 2 }) {
+		const float wanted = Get(delta, axis);
+		const float allowed = ClipAxis(box, axis, wanted);
+		Vector3 step;
+		Add(step, axis, allowed);
+		box.Translate(step);
+		Add(result.moved, axis, allowed);
+		result.hit[axis] = allowed != wanted;
+	}
+	result.onGround = result.hit[1] && delta.y < 0;
+	return result;
+}
+
+CollisionResult VoxelCollider::Move(CollisionBox& box, const Vector3& delta, float stepHeight) const {
+	PROFILE_ZONE("VoxelCollider::Move");
+
+	const CollisionBox start = box;
+	CollisionResult result = MoveAxes(box, delta);
+	if (stepHeight <= 0 || !result.onGround || !(result.hit[0] || result.hit[2]))
+		return result;
+
+	// Climb, move horizontally, then fall back down on whatever is there
+	CollisionBox stepped = start;
+	const float up = ClipAxis(stepped, 1, stepHeight);
+	stepped.Translate(Vector3(0, up, 0));
+	CollisionResult horizontal = MoveAxes(stepped, Vector3(delta.x, 0, delta.z));
+	const float down = ClipAxis(stepped, 1, -up + std::min(delta.y, 0.0f));
+	stepped.Translate(Vector3(0, down, 0));
+
+	const float before = result.moved.x * result.moved.x + result.moved.z * result.moved.z;
+	const float after = horizontal.moved.x * horizontal.moved.x + horizontal.moved.z * horizontal.moved.z;
+	if (after <= before + EPSILON)
+		return result;
+
+	box = stepped;
+	result.moved = stepped.min - start.min;
+	result.hit[0] = horizontal.hit[0];
+	result.hit[2] = horizontal.hit[2];
+	result.hit[1] = true;
+	result.onGround = true;
+	result.stepped = true;
+	return result;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Minicraft/World.h"
+
+// Axis aligned box in world units, block (x, y, z) spans [x - 0.5, x + 0.5] on every axis
+struct CollisionBox {
+	Vector3 min;
+	Vector3 max;
+
+	void Translate(const Vector3& delta) { min += delta; max += delta; }
+};
+
+struct CollisionResult {
+	Vector3 moved;        // what the box actually moved
+	bool hit[3] = {};     // per axis, the move was cut short by a block
+	bool onGround = false;
+	bool stepped = false; // climbed a ledge of at most stepHeight
+};
+
+// Swept box collisions against the blocks with physics. Moves are resolved one axis after the other,
+// each against every block of the swept area so fast moves can't tunnel through thin walls.
+// Solidity is read from the chunk bitsets: a query tests one row mask per chunk, Y and Z.
+// Chunks still loading are solid, the world outside of them empty.
+class VoxelCollider {
+	World* world;
+
+	// Calls fn(blockBox) for every solid block overlapping the box
+	template<typename TFn>
+	void ForEachSolid(const CollisionBox& area, const TFn& fn) const;
+	float ClipAxis(const CollisionBox& box, int axis, float wanted) const;
+	CollisionResult MoveAxes(CollisionBox& box, const Vector3& delta) const;
+public:
+	explicit VoxelCollider(World* world) : world(world) {}
+
+	bool Overlaps(const CollisionBox& box) const;
+	// Y first, then X and Z. Horizontal moves blocked while on the ground retry stepHeight higher,
+	// which is enough to walk onto half slabs without jumping.
+	CollisionResult Move(CollisionBox& box, const Vector3& delta, float stepHeight = 0) const;
+};
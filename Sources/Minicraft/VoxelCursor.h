@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Minicraft/World.h"
+
+// Block accessor for code walking through neighbouring blocks (collisions, rays, simulations):
+// keeps the chunk holding the current block, so moving inside it costs no chunk lookup.
+// Get() is null outside of the world and in chunks still loading, like World::GetCube.
+class VoxelCursor {
+	World* world;
+	Chunk* chunk = nullptr;
+	int x = 0, y = 0, z = 0;
+	int chunkX = INT_MIN, chunkY = INT_MIN, chunkZ = INT_MIN;
+
+	void UpdateChunk() {
+		const int cx = x >> CHUNK_SHIFT;
+		const int cy = y >> CHUNK_SHIFT;
+		const int cz = z >> CHUNK_SHIFT;
+		if (cx == chunkX && cy == chunkY && cz == chunkZ) return;
+		chunkX = cx;
+		chunkY = cy;
+		chunkZ = cz;
+		chunk = world->GetChunk(cx, cy, cz);
+		if (chunk && !chunk->IsLoaded()) chunk = nullptr;
+	}
+	static int LocalIndex(int gx, int gy, int gz) {
+		return (gx & CHUNK_MASK) + ((gy & CHUNK_MASK) << CHUNK_SHIFT) + ((gz & CHUNK_MASK) << (2 * CHUNK_SHIFT));
+	}
+public:
+	VoxelCursor(World* world, int gx, int gy, int gz) : world(world) { MoveTo(gx, gy, gz); }
+
+	void MoveTo(int gx, int gy, int gz) {
+		x = gx;
+		y = gy;
+		z = gz;
+		UpdateChunk();
+	}
+	void Move(int dx, int dy, int dz) { MoveTo(x + dx, y + dy, z + dz); }
+
+	const BlockId* Get() const { return chunk ? &chunk->data[LocalIndex(x, y, z)] : nullptr; }
+	// Reads a neighbour without moving, only looks the chunk up when it is across a border
+	const BlockId* GetRelative(int dx, int dy, int dz) const {
+		const int nx = x + dx, ny = y + dy, nz = z + dz;
+		if (((nx >> CHUNK_SHIFT) == chunkX) & ((ny >> CHUNK_SHIFT) == chunkY) & ((nz >> CHUNK_SHIFT) == chunkZ))
+			return chunk ? &chunk->data[LocalIndex(nx, ny, nz)] : nullptr;
+		return world->GetCube(nx, ny, nz);
+	}
+
+	int GetX() const { return x; }
+	int GetY() const { return y; }
+	int GetZ() const { return z; }
+
+	// Calls fn(gx, gy, gz, const BlockId&) on every loaded block of the inclusive box, one chunk after the other
+	template<typename TFn>
+	static void ForEachInBox(World* world, int x0, int y0, int z0, int x1, int y1, int z1, const TFn& fn) {
+		x0 = std::max(x0, 0); y0 = std::max(y0, 0); z0 = std::max(z0, 0);
+		x1 = std::min(x1, WORLD_SIZE * CHUNK_SIZE - 1);
+		y1 = std::min(y1, WORLD_HEIGHT * CHUNK_SIZE - 1);
+		z1 = std::min(z1, WORLD_SIZE * CHUNK_SIZE - 1);
+
+		for (int cz = z0 >> CHUNK_SHIFT; cz <= z1 >> CHUNK_SHIFT; cz++) {
+			for (int cy = y0 >> CHUNK_SHIFT; cy <= y1 >> CHUNK_SHIFT; cy++) {
+				for (int cx = x0 >> CHUNK_SHIFT; cx <= x1 >> CHUNK_SHIFT; cx++) {
+					Chunk* chunk = world->GetChunk(cx, cy, cz);
+					if (!chunk->IsLoaded()) continue;
+					const int bx = cx << CHUNK_SHIFT, by = cy << CHUNK_SHIFT, bz = cz << CHUNK_SHIFT;
+					const int zEnd = std::min(z1, bz + CHUNK_MASK);
+					const int yEnd = std::min(y1, by + CHUNK_MASK);
+					const int xEnd = std::min(x1, bx + CHUNK_MASK);
+					for (int gz = std::max(z0, bz); gz <= zEnd; gz++)
+						for (int gy = std::max(y0, by); gy <= yEnd; gy++)
+							for (int gx = std::max(x0, bx); gx <= xEnd; gx++)
+								fn(gx, gy, gz, chunk->data[LocalIndex(gx, gy, gz)]);
+				}
+			}
+		}
+	}
+
+	// Same for a vertical column of blocks between y0 and y1 included
+	template<typename TFn>
+	static void ForEachInColumn(World* world, int gx, int gz, int y0, int y1, const TFn& fn) {
+		ForEachInBox(world, gx, y0, gz, gx, y1, gz, fn);
+	}
+};
@@ -1,7 +1,10 @@
 #include "pch.h"
 
 #include "Engine/DefaultResources.h"
+#include "Engine/Clock.h"
+#include "Engine/Profiler.h"
 #include "World.h"
+#include "ChunkSnapshot.h"
 #include "PerlinNoise.hpp"
 
 World::World() {
@@ -21,7 +24,7 @@ World::World() {
 				if (y > 0) chunk->adjYNeg = GetChunk(x, y - 1, z);
 				if (z > 0) chunk->adjZNeg = GetChunk(x, y, z - 1);
 				if (x < WORLD_SIZE - 1) chunk->adjXPos = GetChunk(x + 1, y, z);
-				if (y < WORLD_SIZE - 1) chunk->adjYPos = GetChunk(x, y + 1, z);
+				if (y < WORLD_HEIGHT - 1) chunk->adjYPos = GetChunk(x, y + 1, z);
 				if (z < WORLD_SIZE - 1) chunk->adjZPos = GetChunk(x, y, z + 1);
 			}
 		}
@@ -29,6 +32,7 @@ World::World() {
 }
 
 World::~World() {
+	WaitForLoadJobs();
 	for (int idx = 0; idx < WORLD_SIZE * WORLD_SIZE * WORLD_HEIGHT; idx++) {
 		delete chunks[idx];
 		chunks[idx] = nullptr;
@@ -41,111 +45,310 @@ float scaleMedium = 10;
 float intensityMedium = 5;
 int waterHeight = 12;
 
-void World::Generate(DeviceResources* deviceRes) {
+void World::GenerateColumn(int cx, int cz) {
 	siv::BasicPerlinNoise<float> perlin;
-	for (int x = 0; x < CHUNK_SIZE * WORLD_SIZE; x++) {
-		for (int z = 0; z < CHUNK_SIZE * WORLD_SIZE; z++) {
+	if (seed != 0)
+		perlin.reseed(seed);
+
+	// Regenerating must not keep what was built above the terrain before
+	for (int cy = 0; cy < WORLD_HEIGHT; cy++) {
+		Chunk* chunk = GetChunk(cx, cy, cz);
+		chunk->BeginWrite();
+		memset(chunk->data, EMPTY, sizeof(BlockId) * CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
+	}
+	auto setCube = [&](int lx, int y, int lz, BlockId id) {
+		Chunk* chunk = GetChunk(cx, y / CHUNK_SIZE, cz);
+		if (chunk) chunk->data[lx + (y % CHUNK_SIZE) * CHUNK_SIZE + lz * CHUNK_SIZE * CHUNK_SIZE] = id;
+	};
+	for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+		for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+			const int x = cx * CHUNK_SIZE + lx;
+			const int z = cz * CHUNK_SIZE + lz;
 			int stoneLayer = 2 + floor(perlin.noise2D_01(x / scaleHuge, z / scaleHuge) * intensityHuge);
-			for (int y = 0; y < stoneLayer; y++) {
-				auto block = GetCube(x, y, z);
-				*block = STONE;
-			}
+			for (int y = 0; y < stoneLayer; y++)
+				setCube(lx, y, lz, STONE);
 
 			int dirtLayer = stoneLayer + 1 + floor(perlin.noise2D_01(x / scaleMedium, z / scaleMedium) * intensityMedium);
-			for (int y = stoneLayer; y < dirtLayer; y++) {
-				auto block = GetCube(x, y, z);
-				*block = DIRT;
-			}
+			for (int y = stoneLayer; y < dirtLayer; y++)
+				setCube(lx, y, lz, DIRT);
 
-			for (int y = dirtLayer; y < waterHeight; y++) {
-				auto block = GetCube(x, y, z);
-				*block = WATER;
-			}
+			for (int y = dirtLayer; y < waterHeight; y++)
+				setCube(lx, y, lz, WATER);
 
-			if (dirtLayer > waterHeight - 1) {
-				auto block = GetCube(x, dirtLayer - 1, z);
-				*block = GRASS;
-			}
+			if (dirtLayer > waterHeight - 1)
+				setCube(lx, dirtLayer - 1, lz, GRASS);
 		}
 	}
 
+	for (int cy = 0; cy < WORLD_HEIGHT; cy++) {
+		Chunk* chunk = GetChunk(cx, cy, cz);
+		chunk->RebuildSummary();
+		chunk->loaded.store(true, std::memory_order_release);
+	}
+}
+
+void World::Generate(DeviceResources* deviceRes, uint32_t seed) {
+	PROFILE_ZONE("World::Generate");
+
+	this->seed = seed;
+	JobSystem::Get().ParallelFor(WORLD_SIZE * WORLD_SIZE, WORLD_SIZE, [this](int begin, int end) {
+		for (int column = begin; column < end; column++)
+			GenerateColumn(column % WORLD_SIZE, column / WORLD_SIZE);
+	});
+	for (int column = 0; column < WORLD_SIZE * WORLD_SIZE; column++)
+		NotifyColumnLoaded(column);
+
 	for (int idx = 0; idx < WORLD_SIZE * WORLD_SIZE * WORLD_HEIGHT; idx++)
 		chunks[idx]->Generate(deviceRes);
 
 	DefaultResources::Get()->cbModel.Create(deviceRes);
 }
 
-void World::Draw(Camera* camera, DeviceResources* deviceRes) {
+void World::StartProgressiveGeneration(DeviceResources* deviceRes, uint32_t seed, Vector3 spawn, int spawnRadius) {
+	PROFILE_ZONE("World::StartProgressiveGeneration");
+
+	this->seed = seed;
+	DefaultResources::Get()->cbModel.Create(deviceRes);
+	for (int idx = 0; idx < WORLD_SIZE * WORLD_SIZE * WORLD_HEIGHT; idx++) {
+		chunks[idx]->loaded.store(false, std::memory_order_relaxed);
+		chunks[idx]->firstMeshQueued = false;
+	}
+
+	const int spawnX = std::clamp((int)spawn.x / CHUNK_SIZE, 0, WORLD_SIZE - 1);
+	const int spawnZ = std::clamp((int)spawn.z / CHUNK_SIZE, 0, WORLD_SIZE - 1);
+	auto distance = [&](int column) {
+		const int dx = column % WORLD_SIZE - spawnX;
+		const int dz = column / WORLD_SIZE - spawnZ;
+		return dx * dx + dz * dz;
+	};
+	unmeshedColumns.resize(WORLD_SIZE * WORLD_SIZE);
+	std::iota(unmeshedColumns.begin(), unmeshedColumns.end(), 0);
+	std::stable_sort(unmeshedColumns.begin(), unmeshedColumns.end(), [&](int a, int b) { return distance(a) < distance(b); });
+
+	stats.loadingColumns = WORLD_SIZE * WORLD_SIZE;
+	stats.loadingMeshes = WORLD_SIZE * WORLD_SIZE * WORLD_HEIGHT;
+	for (int column : unmeshedColumns) {
+		const int cx = column % WORLD_SIZE;
+		const int cz = column / WORLD_SIZE;
+		if (std::abs(cx - spawnX) <= spawnRadius && std::abs(cz - spawnZ) <= spawnRadius) {
+			GenerateColumn(cx, cz);
+			columnReady[column] = true;
+			stats.loadingColumns--;
+			NotifyColumnLoaded(column);
+			continue;
+		}
+		// Submitted nearest first, the queue is FIFO
+		JobSystem::Get().Submit([this, cx, cz, column]() {
+			GenerateColumn(cx, cz);
+			std::lock_guard<std::mutex> lock(loadMutex);
+			generatedColumns.push_back(column);
+		}, &loadJobs);
+	}
+
+	// The inner spawn columns have all their neighbours, so the first frame already shows them
+	QueueFirstMeshes(deviceRes, true);
+}
+
+void World::WaitForLoadJobs() {
+	// The job system may already be gone when the global world is destroyed, only touch it when needed
+	if (!loadJobs.IsDone())
+		JobSystem::Get().Wait(loadJobs);
+}
+
+void World::UpdateLoading(DeviceResources* deviceRes) {
+	if (!IsLoading()) return;
+	PROFILE_ZONE("World::UpdateLoading");
+
+	std::vector<int> columns;
+	std::vector<BuiltMesh> meshes;
+	{
+		std::lock_guard<std::mutex> lock(loadMutex);
+		columns.swap(generatedColumns);
+		meshes.swap(builtMeshes);
+	}
+
+	for (int column : columns) {
+		columnReady[column] = true;
+		stats.loadingColumns--;
+		NotifyColumnLoaded(column);
+	}
+	if (!columns.empty())
+		QueueFirstMeshes(deviceRes, false);
+
+	for (auto& built : meshes) {
+		stats.loadingMeshes--;
+		// Edited and rebuilt since its snapshot was taken
+		if (built.chunk->meshRequest != built.request) continue;
+		built.chunk->mesh = std::move(*built.mesh);
+		built.chunk->mesh.Create(deviceRes);
+		CountMeshResult(CMR_MESHED);
+	}
+}
+
+void World::QueueFirstMeshes(DeviceResources* deviceRes, bool immediate) {
+	auto isReady = [&](int cx, int cz) {
+		if (cx < 0 || cz < 0 || cx >= WORLD_SIZE || cz >= WORLD_SIZE) return true;
+		return columnReady[cx + cz * WORLD_SIZE];
+	};
+
+	std::vector<int> remaining;
+	for (int column : unmeshedColumns) {
+		const int cx = column % WORLD_SIZE;
+		const int cz = column / WORLD_SIZE;
+		if (!isReady(cx, cz) || !isReady(cx - 1, cz) || !isReady(cx + 1, cz) || !isReady(cx, cz - 1) || !isReady(cx, cz + 1)) {
+			remaining.push_back(column);
+			continue;
+		}
+
+		for (int cy = 0; cy < WORLD_HEIGHT; cy++) {
+			Chunk* chunk = GetChunk(cx, cy, cz);
+			chunk->firstMeshQueued = true;
+			if (immediate) {
+				chunk->Generate(deviceRes);
+				stats.loadingMeshes--;
+				continue;
+			}
+
+			// Snapshots are taken here, workers never read the chunks themselves. They only hold the blocks,
+			// the worker makes the padded copy.
+			auto source = std::make_shared<ChunkMeshSource>();
+			auto result = chunk->PrepareMesh(*source);
+			if (result != CMR_MESHED) {
+				CountMeshResult(result);
+				stats.loadingMeshes--;
+				continue;
+			}
+
+			const uint32_t request = ++chunk->meshRequest;
+			JobSystem::Get().Submit([this, chunk, request, source]() {
+				auto snapshot = std::make_unique<ChunkSnapshot>();
+				snapshot->Capture(*source);
+				auto mesh = std::make_unique<ChunkMesh>();
+				mesh->Build(*snapshot);
+				std::lock_guard<std::mutex> lock(loadMutex);
+				builtMeshes.push_back({ chunk, request, std::move(mesh) });
+			}, &loadJobs);
+		}
+	}
+	unmeshedColumns.swap(remaining);
+}
+
+void World::CountMeshResult(ChunkMeshResult result) {
+	switch (result) {
+	case CMR_MESHED: stats.meshedChunks++; break;
+	case CMR_EMPTY: stats.skippedEmptyChunks++; break;
+	case CMR_BURIED: stats.skippedBuriedChunks++; break;
+	}
+}
+
+void World::Draw(DeviceResources* deviceRes, RenderCommandList& commands, RenderState state) {
+	PROFILE_ZONE("World::Draw");
+
 	auto gpuRes = DefaultResources::Get();
-	gpuRes->cbModel.ApplyToVS(deviceRes, 0);
+	Camera* camera = state.camera;
+
+	stats.chunkDraws = 0;
+	stats.skippedDraws = 0;
+	stats.culledDraws = 0;
+
+	UpdateLoading(deviceRes);
+
+	const uint64_t regenStart = DX::SystemClock::Get().GetCounter();
+	stats.rebuiltChunks = rebuilds.Run(deviceRes, camera, rebuildBudgetMs);
+	stats.regenMs = DX::SystemClock::Get().MillisecondsSince(regenStart);
+	stats.pendingRebuilds = (int)rebuilds.GetQueueLength();
+	stats.oldestRebuildMs = rebuilds.GetOldestAgeMs();
 
 	for (int pass = SP_OPAQUE; pass < SP_COUNT; pass++) {
 		switch (pass) {
 		case SP_OPAQUE:
-			gpuRes->opaque.Apply(deviceRes);
-			gpuRes->defaultDepth.Apply(deviceRes);
+			state.blend = &gpuRes->opaque;
+			state.depth = &gpuRes->defaultDepth;
 			break;
 		case SP_TRANSPARENT:
-			gpuRes->alphaBlend.Apply(deviceRes);
-			gpuRes->depthRead.Apply(deviceRes);
+			state.blend = &gpuRes->alphaBlend;
+			state.depth = &gpuRes->depthRead;
 			break;
 		}
 
 		for (int idx = 0; idx < WORLD_SIZE * WORLD_SIZE * WORLD_HEIGHT; idx++) {
-			if (chunks[idx]->needRegen) chunks[idx]->Generate(deviceRes);
+			if (!chunks[idx]->mesh.HasGeometry((ShaderPass)pass)) {
+				stats.skippedDraws++;
+				continue;
+			}
 
 			if (chunks[idx]->bounds.Intersects(camera->bounds)) {
-				gpuRes->cbModel.data.model = chunks[idx]->model.Transpose();
-				gpuRes->cbModel.UpdateBuffer(deviceRes);
-				chunks[idx]->Draw(deviceRes, (ShaderPass)pass);
+				float viewDepth = Vector3::Distance(camera->GetPosition(), Vector3(chunks[idx]->bounds.Center));
+				commands.Add(pass == SP_OPAQUE ? RP_OPAQUE : RP_TRANSPARENT, state, chunks[idx]->mesh.GetGeometry((ShaderPass)pass), chunks[idx]->model, viewDepth);
+				stats.chunkDraws++;
+			} else {
+				stats.culledDraws++;
 			}
 		}
 	}
-	gpuRes->cbModel.data.model = Matrix::Identity;
-	gpuRes->cbModel.UpdateBuffer(deviceRes);
 }
 
 Chunk* World::GetChunk(int cx, int cy, int cz) {
 	if (cx < 0 || cy < 0 || cz < 0) return nullptr;
-	if (cx > WORLD_SIZE - 1 || cy > WORLD_SIZE - 1 || cz > WORLD_SIZE - 1) return nullptr;
+	if (cx > WORLD_SIZE - 1 || cy > WORLD_HEIGHT - 1 || cz > WORLD_SIZE - 1) return nullptr;
 	return chunks[cx + cy * WORLD_SIZE + cz * WORLD_SIZE * WORLD_HEIGHT];
 }
 
-BlockId* World::GetCube(int gx, int gy, int gz) {
-	int cx = gx / CHUNK_SIZE;
-	int cy = gy / CHUNK_SIZE;
-	int cz = gz / CHUNK_SIZE;
-	int lx = gx % CHUNK_SIZE;
-	int ly = gy % CHUNK_SIZE;
-	int lz = gz % CHUNK_SIZE;
-
-	auto chunk = GetChunk(cx, cy, cz);
-	if (!chunk) return nullptr;
-	return chunk->GetCubeLocal(lx, ly, lz);
+const BlockId* World::GetCube(int gx, int gy, int gz) {
+	auto chunk = GetChunkFromCoordinates(gx, gy, gz);
+	if (!chunk || !chunk->IsLoaded()) return nullptr;
+	return &chunk->data[(gx & CHUNK_MASK) + ((gy & CHUNK_MASK) << CHUNK_SHIFT) + ((gz & CHUNK_MASK) << (2 * CHUNK_SHIFT))];
 }
 
-void World::MakeChunkDirty(int gx, int gy, int gz) {
+void World::MakeChunkDirty(int gx, int gy, int gz, bool urgent) {
 	auto chunk = GetChunkFromCoordinates(gx, gy, gz);
-	if (chunk) chunk->needRegen = true;
+	if (chunk) MarkChunkDirty(chunk, urgent);
+}
+
+void World::MarkChunkDirty(Chunk* chunk, bool urgent) {
+	// Chunks without a first mesh yet will be meshed with the edit anyway
+	if (chunk->firstMeshQueued) rebuilds.MarkDirty(chunk, urgent);
 }
 
 Chunk* World::GetChunkFromCoordinates(int gx, int gy, int gz) {
-	int cx = gx / CHUNK_SIZE;
-	int cy = gy / CHUNK_SIZE;
-	int cz = gz / CHUNK_SIZE;
-	return GetChunk(cx, cy, cz);
+	return GetChunk(gx >> CHUNK_SHIFT, gy >> CHUNK_SHIFT, gz >> CHUNK_SHIFT);
 }
 
 void World::UpdateBlock(int gx, int gy, int gz, BlockId block) {
-	auto cube = GetCube(gx, gy, gz);
-	if (!cube) return;
-	*cube = block;
-
-	MakeChunkDirty(gx, gy, gz);
-	MakeChunkDirty(gx + 1, gy, gz);
-	MakeChunkDirty(gx - 1, gy, gz);
-	MakeChunkDirty(gx, gy + 1, gz);
-	MakeChunkDirty(gx, gy - 1, gz);
-	MakeChunkDirty(gx, gy, gz + 1);
-	MakeChunkDirty(gx, gy, gz - 1);
+	auto chunk = GetChunkFromCoordinates(gx, gy, gz);
+	if (!chunk || !chunk->IsLoaded()) return;
+	// Rewriting the same block is not an edit: nothing to hash, rebuild nor report
+	if (*chunk->GetCubeLocal(gx & CHUNK_MASK, gy & CHUNK_MASK, gz & CHUNK_MASK) == block) return;
+	chunk->SetCubeLocal(gx & CHUNK_MASK, gy & CHUNK_MASK, gz & CHUNK_MASK, block);
+
+	const int edit[4] = { gx, gy, gz, (int)block };
+	stats.editHash = HashBytes(stats.editHash, edit, sizeof(edit));
+	stats.blockEdits++;
+
+	// Neighbours only see the blocks of the face they touch, and can wait behind the edited chunk
+	MarkChunkDirty(chunk, true);
+	const int lx = gx & CHUNK_MASK, ly = gy & CHUNK_MASK, lz = gz & CHUNK_MASK;
+	if (lx == 0) MakeChunkDirty(gx - 1, gy, gz, false);
+	if (lx == CHUNK_MASK) MakeChunkDirty(gx + 1, gy, gz, false);
+	if (ly == 0) MakeChunkDirty(gx, gy - 1, gz, false);
+	if (ly == CHUNK_MASK) MakeChunkDirty(gx, gy + 1, gz, false);
+	if (lz == 0) MakeChunkDirty(gx, gy, gz - 1, false);
+	if (lz == CHUNK_MASK) MakeChunkDirty(gx, gy, gz + 1, false);
+
+	NotifyBlockChanged(gx, gy, gz, block);
+}
+
+void World::AddBlockListener(IBlockListener* listener) {
+	if (std::find(blockListeners.begin(), blockListeners.end(), listener) == blockListeners.end())
+		blockListeners.push_back(listener);
+}
+
+void World::NotifyBlockChanged(int gx, int gy, int gz, BlockId block) {
+	for (auto listener : blockListeners)
+		listener->OnBlockChanged(gx, gy, gz, block);
+}
+
+void World::NotifyColumnLoaded(int column) {
+	for (auto listener : blockListeners)
+		listener->OnColumnLoaded(column % WORLD_SIZE, column / WORLD_SIZE);
 }
\ No newline at end of file
@@ -2,27 +2,107 @@
 
 #include "Engine/BlendState.h"
 #include "Engine/Camera.h"
+#include "Engine/JobSystem.h"
+#include "Engine/RenderCommands.h"
 #include "Minicraft/Block.h"
 #include "Minicraft/Chunk.h"
+#include "Minicraft/ChunkMesh.h"
+#include "Minicraft/ChunkRebuildScheduler.h"
+#include "Minicraft/Utils.h"
 
 #define WORLD_SIZE 15
 #define WORLD_HEIGHT 3
 
+// Meshing counters are cumulative, draw counters are reset at every World::Draw
+struct WorldStats {
+	int meshedChunks = 0;
+	int skippedEmptyChunks = 0;
+	int skippedBuriedChunks = 0;
+
+	int chunkDraws = 0;
+	int skippedDraws = 0; // chunk passes without geometry, skipped before the bounds test
+	int culledDraws = 0;
+	double regenMs = 0;   // time spent rebuilding dirty chunks during the last draw
+	int rebuiltChunks = 0;
+	int pendingRebuilds = 0;     // still waiting after the last draw
+	double oldestRebuildMs = 0;  // age of the oldest of them
+
+	int blockEdits = 0;
+	uint32_t editHash = FNV_OFFSET_BASIS; // every UpdateBlock since startup, in order
+
+	int loadingColumns = 0; // terrain columns still generating
+	int loadingMeshes = 0;  // chunks still waiting for their first mesh
+};
+
+// Told about every block written through UpdateBlock or a WorldEditBatch, on the thread owning the world
+class IBlockListener {
+public:
+	virtual ~IBlockListener() = default;
+	virtual void OnBlockChanged(int gx, int gy, int gz, BlockId block) = 0;
+	// The terrain of the column was just written, by Generate or once streamed in. Its blocks are not reported one by one.
+	virtual void OnColumnLoaded(int cx, int cz) {}
+};
+
 class Chunk;
 class World {
 	Chunk* chunks[WORLD_SIZE * WORLD_HEIGHT * WORLD_SIZE];
+	ChunkRebuildScheduler rebuilds;
+	double rebuildBudgetMs = 4.0;
+	uint32_t seed = 0;
+	std::vector<IBlockListener*> blockListeners;
+
+	// Progressive loading: workers generate columns and first meshes, the thread owning the world installs them
+	struct BuiltMesh {
+		Chunk* chunk;
+		uint32_t request;
+		std::unique_ptr<ChunkMesh> mesh;
+	};
+	JobCounter loadJobs;
+	std::mutex loadMutex;
+	std::vector<int> generatedColumns; // guarded by loadMutex
+	std::vector<BuiltMesh> builtMeshes; // guarded by loadMutex
+	std::vector<int> unmeshedColumns;  // nearest to spawn first
+	bool columnReady[WORLD_SIZE * WORLD_SIZE] = {};
+
+	// Writes the terrain of every chunk in the column, safe to run on a worker
+	void GenerateColumn(int cx, int cz);
+	void UpdateLoading(DeviceResources* deviceRes);
+	// Meshes the columns whose neighbours are all generated, on workers unless immediate
+	void QueueFirstMeshes(DeviceResources* deviceRes, bool immediate);
+	void CountMeshResult(ChunkMeshResult result);
+	void MarkChunkDirty(Chunk* chunk, bool urgent);
+	void NotifyBlockChanged(int gx, int gy, int gz, BlockId block);
+	void NotifyColumnLoaded(int column);
 public:
+	WorldStats stats;
+
 	World();
 	virtual ~World();
-	void Generate(DeviceResources* deviceRes);
-	void Draw(Camera* camera, DeviceResources* deviceRes);
+	// Seed 0 keeps the reference Perlin permutation
+	void Generate(DeviceResources* deviceRes, uint32_t seed = 0);
+	// Generates and meshes the columns within spawnRadius right away, the rest streams in nearest first
+	void StartProgressiveGeneration(DeviceResources* deviceRes, uint32_t seed, Vector3 spawn, int spawnRadius = 2);
+	bool IsLoading() const { return stats.loadingColumns > 0 || stats.loadingMeshes > 0; }
+	// Background loading jobs reference the world, must be done before the job system shuts down
+	void WaitForLoadJobs();
+	// Installs loaded chunks, rebuilds dirty chunks within the budget and records the visible ones, state provides camera, shader, layout and texture
+	void Draw(DeviceResources* deviceRes, RenderCommandList& commands, RenderState state);
 
 	Chunk* GetChunk(int cx, int cy, int cz);
 	Chunk* GetChunkFromCoordinates(int gx, int gy, int gz);
-	BlockId* GetCube(int gx, int gy, int gz);
-	void MakeChunkDirty(int gx, int gy, int gz);
+	const BlockId* GetCube(int gx, int gy, int gz);
+	// Queues the chunk holding this block for a rebuild, urgent ones skip ahead of the queue
+	void MakeChunkDirty(int gx, int gy, int gz, bool urgent = false);
+	// Milliseconds of chunk rebuilds allowed per draw, at least one chunk is always rebuilt
+	void SetRebuildBudget(double ms) { rebuildBudgetMs = ms; }
 
+	// Single block edit, prefer a WorldEditBatch when editing many blocks at once
 	void UpdateBlock(int gx, int gy, int gz, BlockId block);
+	// Listeners are told in the order they were added, adding one twice does nothing
+	void AddBlockListener(IBlockListener* listener);
 
 	friend class Chunk;
+	friend class WorldEditBatch;
+	friend class BlockTickScheduler;
+	friend class WorldServer;
 };
\ No newline at end of file
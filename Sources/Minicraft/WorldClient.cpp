@@ -0,0 +1,91 @@
+#include "pch.h"
+
+#include "WorldClient.h"
+#include "Minicraft/NetProtocol.h"
+
+namespace {
+	constexpr int CHUNK_COUNT = WORLD_SIZE * WORLD_HEIGHT * WORLD_SIZE;
+	constexpr int CHUNK_BLOCKS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+}
+
+WorldClient::WorldClient(std::unique_ptr<ITransport> transport) : transport(std::move(transport)), chunks(CHUNK_COUNT) {}
+
+void WorldClient::Connect(int viewRadius) {
+	message.clear();
+	NetWriter writer(message);
+	writer.WriteByte(NM_HELLO);
+	writer.WriteVarint(viewRadius);
+	transport->Send(message.data(), message.size());
+}
+
+void WorldClient::SendPosition(const Vector3& position) {
+	message.clear();
+	NetWriter writer(message);
+	writer.WriteByte(NM_POSITION);
+	writer.WriteFloat(position.x);
+	writer.WriteFloat(position.y);
+	writer.WriteFloat(position.z);
+	transport->Send(message.data(), message.size());
+}
+
+void WorldClient::Update() {
+	while (transport->Receive(message))
+		if (!ApplyMessage())
+			stats.badMessages++;
+}
+
+bool WorldClient::ApplyMessage() {
+	NetReader reader(message);
+	switch (reader.ReadByte()) {
+	case NM_CHUNK: {
+		const uint32_t chunkIndex = reader.ReadVarint();
+		if (chunkIndex >= CHUNK_COUNT) return false;
+		auto blocks = std::make_unique<BlockId[]>(CHUNK_BLOCKS);
+		if (!DecodeChunkBlocks(reader, blocks.get())) return false;
+		if (!chunks[chunkIndex]) stats.chunks++;
+		chunks[chunkIndex] = std::move(blocks);
+		stats.chunksReceived++;
+		return true;
+	}
+	case NM_UNLOAD_CHUNKS: {
+		const uint32_t count = reader.ReadVarint();
+		for (uint32_t i = 0; i < count && !reader.HasFailed(); i++) {
+			const uint32_t chunkIndex = reader.ReadVarint();
+			if (chunkIndex >= CHUNK_COUNT || !chunks[chunkIndex]) continue;
+			chunks[chunkIndex].reset();
+			stats.chunks--;
+			stats.chunksUnloaded++;
+		}
+		return !reader.HasFailed();
+	}
+	case NM_BLOCK_DELTAS: {
+		const uint32_t chunkCount = reader.ReadVarint();
+		for (uint32_t i = 0; i < chunkCount && !reader.HasFailed(); i++) {
+			const uint32_t chunkIndex = reader.ReadVarint();
+			const uint32_t editCount = reader.ReadVarint();
+			// The server only sends edits of the chunks it sent
+			if (chunkIndex >= CHUNK_COUNT || !chunks[chunkIndex]) return false;
+			BlockId* blocks = chunks[chunkIndex].get();
+			for (uint32_t j = 0; j < editCount && !reader.HasFailed(); j++) {
+				const uint16_t cell = reader.ReadUInt16();
+				const uint8_t block = reader.ReadByte();
+				if (cell >= CHUNK_BLOCKS || block >= COUNT) return false;
+				blocks[cell] = (BlockId)block;
+			}
+			stats.deltaEdits += editCount;
+		}
+		return !reader.HasFailed();
+	}
+	default:
+		return false;
+	}
+}
+
+const BlockId* WorldClient::GetCube(int gx, int gy, int gz) const {
+	if (gx < 0 || gy < 0 || gz < 0) return nullptr;
+	if (gx >= WORLD_SIZE * CHUNK_SIZE || gy >= WORLD_HEIGHT * CHUNK_SIZE || gz >= WORLD_SIZE * CHUNK_SIZE) return nullptr;
+	const int chunkIndex = (gx >> CHUNK_SHIFT) + (gy >> CHUNK_SHIFT) * WORLD_SIZE + (gz >> CHUNK_SHIFT) * WORLD_SIZE * WORLD_HEIGHT;
+	const BlockId* blocks = chunks[chunkIndex].get();
+	if (!blocks) return nullptr;
+	return &blocks[(gx & CHUNK_MASK) + ((gy & CHUNK_MASK) << CHUNK_SHIFT) + ((gz & CHUNK_MASK) << (2 * CHUNK_SHIFT))];
+}
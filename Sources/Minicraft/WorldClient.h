@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Engine/Transport.h"
+#include "Minicraft/Block.h"
+#include "Minicraft/Chunk.h"
+#include "Minicraft/World.h"
+
+// Counters since the client connected
+struct ClientStats {
+	int chunks = 0; // held right now
+	int chunksReceived = 0;
+	int chunksUnloaded = 0;
+	int deltaEdits = 0;
+	int badMessages = 0;
+};
+
+// What a client knows of the world: the chunks a WorldServer streamed to it, kept up to date by its deltas.
+class WorldClient {
+	std::unique_ptr<ITransport> transport;
+	std::vector<std::unique_ptr<BlockId[]>> chunks; // per world chunk index, null when not held
+	std::vector<uint8_t> message;
+
+	bool ApplyMessage();
+public:
+	ClientStats stats;
+
+	explicit WorldClient(std::unique_ptr<ITransport> transport);
+
+	void Connect(int viewRadius);
+	void SendPosition(const Vector3& position);
+	// Applies everything the server sent so far
+	void Update();
+
+	const BlockId* GetChunkBlocks(int chunkIndex) const { return chunks[chunkIndex].get(); }
+	// Null outside of the world and in chunks not received
+	const BlockId* GetCube(int gx, int gy, int gz) const;
+	const ITransport& GetTransport() const { return *transport; }
+};
@@ -0,0 +1,150 @@
+#include "pch.h"
+
+#include "Engine/Profiler.h"
+#include "WorldEditBatch.h"
+#include "World.h"
+
+void WorldEditBatch::Set(int gx, int gy, int gz, BlockId block) {
+	const int cx = gx >> CHUNK_SHIFT;
+	const int cy = gy >> CHUNK_SHIFT;
+	const int cz = gz >> CHUNK_SHIFT;
+	if (cx < 0 || cy < 0 || cz < 0) return;
+	if (cx >= WORLD_SIZE || cy >= WORLD_HEIGHT || cz >= WORLD_SIZE) return;
+	const int chunkIndex = cx + cy * WORLD_SIZE + cz * WORLD_SIZE * WORLD_HEIGHT;
+	if (!world->chunks[chunkIndex]->IsLoaded()) return;
+	staged.push_back({ gx, gy, gz, block, chunkIndex });
+}
+
+void WorldEditBatch::Reserve(size_t count) {
+	// At least doubles, so many small fills into one batch stay linear
+	const size_t needed = staged.size() + count;
+	if (needed > staged.capacity())
+		staged.reserve(std::max(needed, staged.capacity() * 2));
+}
+
+void WorldEditBatch::FillBox(int x0, int y0, int z0, int x1, int y1, int z1, BlockId block) {
+	x0 = std::max(x0, 0); y0 = std::max(y0, 0); z0 = std::max(z0, 0);
+	x1 = std::min(x1, WORLD_SIZE * CHUNK_SIZE - 1);
+	y1 = std::min(y1, WORLD_HEIGHT * CHUNK_SIZE - 1);
+	z1 = std::min(z1, WORLD_SIZE * CHUNK_SIZE - 1);
+	if (x0 > x1 || y0 > y1 || z0 > z1) return;
+
+	Reserve((size_t)(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1));
+	for (int z = z0; z <= z1; z++)
+		for (int y = y0; y <= y1; y++)
+			for (int x = x0; x <= x1; x++)
+				Set(x, y, z, block);
+}
+
+void WorldEditBatch::FillSphere(Vector3 center, float radius, BlockId block) {
+	const int x0 = (int)floor(center.x - radius), x1 = (int)ceil(center.x + radius);
+	const int y0 = (int)floor(center.y - radius), y1 = (int)ceil(center.y + radius);
+	const int z0 = (int)floor(center.z - radius), z1 = (int)ceil(center.z + radius);
+	const float radiusSq = radius * radius;
+	for (int z = z0; z <= z1; z++) {
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				if (Vector3::DistanceSquared(center, Vector3(x + 0.5f, y + 0.5f, z + 0.5f)) <= radiusSq)
+					Set(x, y, z, block);
+			}
+		}
+	}
+}
+
+void WorldEditBatch::FillSpan(int gx, int gy, int gz, int length, BlockId block) {
+	FillBox(gx, gy, gz, gx + length - 1, gy, gz, block);
+}
+
+void WorldEditBatch::Apply(const std::vector<BlockEdit>& edits) {
+	Reserve(edits.size());
+	for (auto& edit : edits)
+		Set(edit.x, edit.y, edit.z, edit.block);
+}
+
+int WorldEditBatch::Commit() {
+	if (staged.empty()) return 0;
+	PROFILE_ZONE("WorldEditBatch::Commit");
+
+	constexpr int chunkCount = WORLD_SIZE * WORLD_SIZE * WORLD_HEIGHT;
+	auto& stats = world->stats;
+
+	// Counting sort by chunk, stable so the last edit of a block is still applied last
+	std::vector<int> offsets(chunkCount + 1, 0);
+	for (auto& edit : staged)
+		offsets[edit.chunkIndex + 1]++;
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+	std::vector<const Staged*> sorted(staged.size());
+	for (auto& edit : staged)
+		sorted[offsets[edit.chunkIndex]++] = &edit;
+
+	std::vector<bool> dirty(chunkCount, false);
+	std::vector<bool> changed(staged.size(), false);
+	std::vector<const Staged*> applied;
+	applied.reserve(sorted.size());
+	for (auto edit : sorted) {
+		Chunk* chunk = world->chunks[edit->chunkIndex];
+		const int lx = edit->x & CHUNK_MASK;
+		const int ly = edit->y & CHUNK_MASK;
+		const int lz = edit->z & CHUNK_MASK;
+		if (chunk->data[lx + ly * CHUNK_SIZE + lz * CHUNK_SIZE * CHUNK_SIZE] == edit->block) continue;
+		chunk->SetCubeLocal(lx, ly, lz, edit->block);
+		MarkDirty(dirty, edit->chunkIndex, lx, ly, lz);
+		applied.push_back(edit);
+		changed[edit - staged.data()] = true;
+	}
+
+	// Hashed in staging order and only when the block changed, so a batch fingerprints like the same UpdateBlock calls
+	for (size_t i = 0; i < staged.size(); i++) {
+		if (!changed[i]) continue;
+		const int hashed[4] = { staged[i].x, staged[i].y, staged[i].z, (int)staged[i].block };
+		stats.editHash = HashBytes(stats.editHash, hashed, sizeof(hashed));
+	}
+	stats.blockEdits += (int)applied.size();
+
+	// Listeners see the whole batch applied
+	for (auto edit : applied)
+		world->NotifyBlockChanged(edit->x, edit->y, edit->z, edit->block);
+	staged.clear();
+	return FlushDirty(dirty);
+}
+
+int WorldEditBatch::CommitWritten(const std::vector<BlockEdit>& edits) {
+	if (edits.empty()) return 0;
+	PROFILE_ZONE("WorldEditBatch::CommitWritten");
+
+	auto& stats = world->stats;
+	std::vector<bool> dirty(WORLD_SIZE * WORLD_SIZE * WORLD_HEIGHT, false);
+	for (auto& edit : edits) {
+		const int hashed[4] = { edit.x, edit.y, edit.z, (int)edit.block };
+		stats.editHash = HashBytes(stats.editHash, hashed, sizeof(hashed));
+		const int chunkIndex = (edit.x >> CHUNK_SHIFT) + (edit.y >> CHUNK_SHIFT) * WORLD_SIZE + (edit.z >> CHUNK_SHIFT) * WORLD_SIZE * WORLD_HEIGHT;
+		MarkDirty(dirty, chunkIndex, edit.x & CHUNK_MASK, edit.y & CHUNK_MASK, edit.z & CHUNK_MASK);
+	}
+	stats.blockEdits += (int)edits.size();
+
+	for (auto& edit : edits)
+		world->NotifyBlockChanged(edit.x, edit.y, edit.z, edit.block);
+	return FlushDirty(dirty);
+}
+
+void WorldEditBatch::MarkDirty(std::vector<bool>& dirty, int chunkIndex, int lx, int ly, int lz) const {
+	// Neighbours only see the blocks of the face they touch
+	const Chunk* chunk = world->chunks[chunkIndex];
+	dirty[chunkIndex] = true;
+	if (lx == 0 && chunk->adjXNeg) dirty[chunkIndex - 1] = true;
+	if (lx == CHUNK_SIZE - 1 && chunk->adjXPos) dirty[chunkIndex + 1] = true;
+	if (ly == 0 && chunk->adjYNeg) dirty[chunkIndex - WORLD_SIZE] = true;
+	if (ly == CHUNK_SIZE - 1 && chunk->adjYPos) dirty[chunkIndex + WORLD_SIZE] = true;
+	if (lz == 0 && chunk->adjZNeg) dirty[chunkIndex - WORLD_SIZE * WORLD_HEIGHT] = true;
+	if (lz == CHUNK_SIZE - 1 && chunk->adjZPos) dirty[chunkIndex + WORLD_SIZE * WORLD_HEIGHT] = true;
+}
+
+int WorldEditBatch::FlushDirty(const std::vector<bool>& dirty) {
+	int dirtied = 0;
+	for (int idx = 0; idx < (int)dirty.size(); idx++) {
+		if (!dirty[idx]) continue;
+		world->MarkChunkDirty(world->chunks[idx], true);
+		dirtied++;
+	}
+	return dirtied;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Minicraft/Block.h"
+#include "Minicraft/Utils.h"
+
+struct BlockEdit {
+	int x, y, z;
+	BlockId block;
+};
+
+class World;
+// Block edits staged then applied together: Commit() writes them chunk by chunk straight into the chunk storage
+// and dirties every affected chunk once, where UpdateBlock() looks up and dirties 7 chunks per block.
+// Edits are applied in order, the last one staged on a block wins.
+class WorldEditBatch {
+	struct Staged {
+		int x, y, z;
+		BlockId block;
+		int chunkIndex;
+	};
+	World* world;
+	std::vector<Staged> staged;
+
+	void Reserve(size_t count);
+	void MarkDirty(std::vector<bool>& dirty, int chunkIndex, int lx, int ly, int lz) const;
+	int FlushDirty(const std::vector<bool>& dirty);
+public:
+	explicit WorldEditBatch(World* world) : world(world) {}
+
+	void Set(int gx, int gy, int gz, BlockId block);
+	// Bounds are inclusive, anything outside of the world is ignored
+	void FillBox(int x0, int y0, int z0, int x1, int y1, int z1, BlockId block);
+	// Blocks whose center is within radius
+	void FillSphere(Vector3 center, float radius, BlockId block);
+	// length blocks along +X
+	void FillSpan(int gx, int gy, int gz, int length, BlockId block);
+	void Apply(const std::vector<BlockEdit>& edits);
+
+	size_t GetStagedCount() const { return staged.size(); }
+	void Cancel() { staged.clear(); }
+	// Returns the number of chunks dirtied, the batch is empty afterwards
+	int Commit();
+	// Edits their owner already wrote into chunk storage, as block ticks do: only hashed, dirtied and reported.
+	// Unlike staged edits they must all be inside the world and actually change their block.
+	int CommitWritten(const std::vector<BlockEdit>& edits);
+};
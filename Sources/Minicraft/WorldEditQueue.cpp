@@ -0,0 +1,75 @@
+#include "pch.h"
+
+#include "WorldEditQueue.h"
+#include "Engine/Clock.h"
+#include "Engine/Profiler.h"
+
+WorldEditQueue::~WorldEditQueue() {
+	Clear();
+}
+
+void WorldEditQueue::FreeList(Node* node) {
+	while (node) {
+		Node* next = node->next;
+		::operator delete(node);
+		node = next;
+	}
+}
+
+void WorldEditQueue::Push(int gx, int gy, int gz, BlockId block) {
+	const BlockEdit edit = { gx, gy, gz, block };
+	Push(&edit, 1);
+}
+
+void WorldEditQueue::Push(const BlockEdit* edits, int count) {
+	if (count <= 0) return;
+	Node* node = static_cast<Node*>(::operator new(sizeof(Node) + count * sizeof(BlockEdit)));
+	node->count = count;
+	memcpy(node->GetEdits(), edits, count * sizeof(BlockEdit));
+
+	// Release publishes the edits to the drain, which takes the list with acquire
+	depth.fetch_add(count, std::memory_order_relaxed);
+	Node* expected = head.load(std::memory_order_relaxed);
+	do {
+		node->next = expected;
+	} while (!head.compare_exchange_weak(expected, node, std::memory_order_release, std::memory_order_relaxed));
+}
+
+int WorldEditQueue::Drain() {
+	stats = EditQueueStats();
+	Node* node = head.exchange(nullptr, std::memory_order_acquire);
+	if (!node) return 0;
+	PROFILE_ZONE("WorldEditQueue::Drain");
+	auto& clock = DX::SystemClock::Get();
+	const uint64_t start = clock.GetCounter();
+
+	// Newest first, turned back into push order
+	Node* ordered = nullptr;
+	while (node) {
+		Node* next = node->next;
+		node->next = ordered;
+		ordered = node;
+		node = next;
+	}
+	WorldEditBatch batch(world);
+	for (node = ordered; node; node = node->next) {
+		const BlockEdit* edits = node->GetEdits();
+		for (int i = 0; i < node->count; i++)
+			batch.Set(edits[i].x, edits[i].y, edits[i].z, edits[i].block);
+		stats.depth += node->count;
+	}
+	FreeList(ordered);
+	depth.fetch_sub(stats.depth, std::memory_order_relaxed);
+	stats.dirtiedChunks = batch.Commit();
+	stats.applyMs = clock.MillisecondsSince(start);
+	return stats.dirtiedChunks;
+}
+
+void WorldEditQueue::Clear() {
+	Node* node = head.exchange(nullptr, std::memory_order_acquire);
+	int count = 0;
+	for (Node* counted = node; counted; counted = counted->next)
+		count += counted->count;
+	FreeList(node);
+	depth.fetch_sub(count, std::memory_order_relaxed);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Minicraft/World.h"
+#include "Minicraft/WorldEditBatch.h"
+
+// Counters of the last drain
+struct EditQueueStats {
+	int depth = 0;         // edits waiting when it started
+	int dirtiedChunks = 0;
+	double applyMs = 0;
+};
+
+// Block edits pushed from any thread, applied together on the thread owning the world once per simulation tick.
+// Pushing is lock free: each push makes one node holding its edits, in a single allocation, and links it onto a shared
+// list with one compare and swap, so pushing a range costs the same as pushing one edit.
+// Drain() takes the whole list in one exchange and applies it as a WorldEditBatch, so edits are grouped by chunk
+// and every chunk is dirtied once. Edits of one thread keep their order, edits in chunks still loading are dropped.
+class WorldEditQueue {
+	// The count edits follow the node in the same allocation
+	struct Node {
+		Node* next;
+		int count;
+		BlockEdit* GetEdits() { return reinterpret_cast<BlockEdit*>(this + 1); }
+	};
+
+	World* world;
+	std::atomic<Node*> head = nullptr; // newest first
+	std::atomic<int> depth = 0;
+
+	static void FreeList(Node* node);
+public:
+	EditQueueStats stats;
+
+	explicit WorldEditQueue(World* world) : world(world) {}
+	~WorldEditQueue();
+	WorldEditQueue(const WorldEditQueue&) = delete;
+	WorldEditQueue& operator=(const WorldEditQueue&) = delete;
+
+	// From any thread
+	void Push(int gx, int gy, int gz, BlockId block);
+	void Push(const BlockEdit* edits, int count);
+	// Edits pushed and not drained yet, only a hint while other threads push
+	int GetDepth() const { return depth.load(std::memory_order_relaxed); }
+
+	// On the thread owning the world, applies everything pushed so far and returns the number of chunks dirtied
+	int Drain();
+	void Clear();
+};
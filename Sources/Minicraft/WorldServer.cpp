@@ -0,0 +1,219 @@
+#include "pch.h"
+
+#include "WorldServer.h"
+#include "Engine/Clock.h"
+#include "Engine/Profiler.h"
+#include "Minicraft/Chunk.h"
+#include "Minicraft/NetProtocol.h"
+
+namespace {
+	constexpr int CHUNK_COUNT = WORLD_SIZE * WORLD_HEIGHT * WORLD_SIZE;
+	constexpr int CLIENTS_PER_JOB = 4;
+
+	int ChunkIndexOf(int gx, int gy, int gz) {
+		return (gx >> CHUNK_SHIFT) + (gy >> CHUNK_SHIFT) * WORLD_SIZE + (gz >> CHUNK_SHIFT) * WORLD_SIZE * WORLD_HEIGHT;
+	}
+
+	int CellOf(int gx, int gy, int gz) {
+		return (gx & CHUNK_MASK) + ((gy & CHUNK_MASK) << CHUNK_SHIFT) + ((gz & CHUNK_MASK) << (2 * CHUNK_SHIFT));
+	}
+
+	int ColumnDistance(int chunkIndex, int cx, int cz) {
+		const int dx = chunkIndex % WORLD_SIZE - cx, dz = chunkIndex / (WORLD_SIZE * WORLD_HEIGHT) - cz;
+		return std::max(abs(dx), abs(dz));
+	}
+}
+
+WorldServer::WorldServer(World* world) : world(world), encoded(CHUNK_COUNT), encodedVersions(CHUNK_COUNT) {}
+
+int WorldServer::AddClient(std::unique_ptr<ITransport> transport) {
+	auto client = std::make_unique<RemoteClient>();
+	client->transport = std::move(transport);
+	client->hasChunk.assign(CHUNK_COUNT, false);
+	clients.push_back(std::move(client));
+	return (int)clients.size() - 1;
+}
+
+void WorldServer::DisconnectAll() {
+	clients.clear();
+	edits.clear();
+}
+
+void WorldServer::OnBlockChanged(int gx, int gy, int gz, BlockId block) {
+	if (!clients.empty())
+		edits.push_back({ gx, gy, gz, block });
+}
+
+void WorldServer::ReadMessages(RemoteClient& client) {
+	while (client.transport->Receive(client.message)) {
+		NetReader reader(client.message);
+		switch (reader.ReadByte()) {
+		case NM_HELLO:
+			client.viewRadius = std::min((int)reader.ReadVarint(), WORLD_SIZE);
+			break;
+		case NM_POSITION: {
+			const float x = reader.ReadFloat();
+			reader.ReadFloat();
+			const float z = reader.ReadFloat();
+			if (reader.HasFailed()) break;
+			client.cx = std::clamp((int)floorf(x + 0.5f) >> CHUNK_SHIFT, 0, WORLD_SIZE - 1);
+			client.cz = std::clamp((int)floorf(z + 0.5f) >> CHUNK_SHIFT, 0, WORLD_SIZE - 1);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+void WorldServer::SelectChunks(RemoteClient& client) {
+	client.sending.clear();
+	client.unloading.clear();
+	if (client.viewRadius == 0) return;
+
+	// Dropped one column beyond the radius, so walking along a chunk border doesn't resend the same columns
+	for (int chunkIndex = 0; chunkIndex < CHUNK_COUNT; chunkIndex++)
+		if (client.hasChunk[chunkIndex] && ColumnDistance(chunkIndex, client.cx, client.cz) > client.viewRadius + 1)
+			client.unloading.push_back(chunkIndex);
+
+	// Square rings around the client, nearest first
+	for (int ring = 0; ring <= client.viewRadius; ring++) {
+		for (int cz = client.cz - ring; cz <= client.cz + ring; cz++) {
+			for (int cx = client.cx - ring; cx <= client.cx + ring; cx++) {
+				if (std::max(abs(cx - client.cx), abs(cz - client.cz)) != ring) continue;
+				if (cx < 0 || cz < 0 || cx >= WORLD_SIZE || cz >= WORLD_SIZE) continue;
+				for (int cy = 0; cy < WORLD_HEIGHT; cy++) {
+					const int chunkIndex = cx + cy * WORLD_SIZE + cz * WORLD_SIZE * WORLD_HEIGHT;
+					if (client.hasChunk[chunkIndex] || !world->chunks[chunkIndex]->IsLoaded()) continue;
+					if ((int)client.sending.size() == chunksPerTick) return;
+					client.sending.push_back(chunkIndex);
+				}
+			}
+		}
+	}
+}
+
+void WorldServer::SendUpdates(RemoteClient& client) {
+	client.sent = ServerStats();
+	const uint64_t bytesBefore = client.transport->stats.bytesSent;
+	NetWriter writer(client.message);
+
+	// Edits only for the chunks held before this tick, chunks sent now already have them
+	int heldChunks = 0;
+	for (auto& chunkEdits : editedChunks)
+		heldChunks += client.hasChunk[chunkEdits.chunkIndex];
+	if (heldChunks > 0) {
+		client.message.clear();
+		writer.WriteByte(NM_BLOCK_DELTAS);
+		writer.WriteVarint(heldChunks);
+		for (auto& chunkEdits : editedChunks) {
+			if (!client.hasChunk[chunkEdits.chunkIndex]) continue;
+			writer.WriteVarint(chunkEdits.chunkIndex);
+			writer.WriteVarint(chunkEdits.end - chunkEdits.begin);
+			for (int i = chunkEdits.begin; i < chunkEdits.end; i++) {
+				writer.WriteUInt16((uint16_t)CellOf(edits[i].x, edits[i].y, edits[i].z));
+				writer.WriteByte(edits[i].block);
+			}
+			client.sent.deltaEdits += chunkEdits.end - chunkEdits.begin;
+		}
+		client.transport->Send(client.message.data(), client.message.size());
+	}
+
+	for (int chunkIndex : client.sending) {
+		const auto& payload = encoded[chunkIndex];
+		client.message.clear();
+		writer.WriteByte(NM_CHUNK);
+		writer.WriteVarint(chunkIndex);
+		writer.WriteBytes(payload.data(), payload.size());
+		client.transport->Send(client.message.data(), client.message.size());
+		client.hasChunk[chunkIndex] = true;
+		client.sent.chunksSent++;
+		client.sent.chunkBytes += payload.size();
+	}
+
+	if (!client.unloading.empty()) {
+		client.message.clear();
+		writer.WriteByte(NM_UNLOAD_CHUNKS);
+		writer.WriteVarint((uint32_t)client.unloading.size());
+		for (int chunkIndex : client.unloading) {
+			writer.WriteVarint(chunkIndex);
+			client.hasChunk[chunkIndex] = false;
+		}
+		client.transport->Send(client.message.data(), client.message.size());
+		client.sent.chunksUnloaded += (int)client.unloading.size();
+	}
+	client.sent.bytesSent = client.transport->stats.bytesSent - bytesBefore;
+}
+
+void WorldServer::Tick(JobSystem* jobs) {
+	stats = ServerStats();
+	clients.erase(std::remove_if(clients.begin(), clients.end(), [](auto& client) { return !client->transport->IsConnected(); }), clients.end());
+	stats.clients = (int)clients.size();
+	if (clients.empty()) {
+		edits.clear();
+		return;
+	}
+	PROFILE_ZONE("WorldServer::Tick");
+	auto& clock = DX::SystemClock::Get();
+	const uint64_t start = clock.GetCounter();
+
+	auto forEachClient = [&](auto fn) {
+		auto range = [&](int begin, int end) {
+			for (int i = begin; i < end; i++)
+				fn(*clients[i]);
+		};
+		if (jobs)
+			jobs->ParallelFor((int)clients.size(), CLIENTS_PER_JOB, range);
+		else
+			range(0, (int)clients.size());
+	};
+	forEachClient([&](RemoteClient& client) {
+		ReadMessages(client);
+		SelectChunks(client);
+	});
+
+	// Grouped by chunk, the order of the edits of a chunk is kept so the last one still wins
+	std::stable_sort(edits.begin(), edits.end(), [](const BlockEdit& a, const BlockEdit& b) {
+		return ChunkIndexOf(a.x, a.y, a.z) < ChunkIndexOf(b.x, b.y, b.z);
+	});
+	editedChunks.clear();
+	for (int i = 0; i < (int)edits.size(); i++) {
+		const int chunkIndex = ChunkIndexOf(edits[i].x, edits[i].y, edits[i].z);
+		if (editedChunks.empty() || editedChunks.back().chunkIndex != chunkIndex)
+			editedChunks.push_back({ chunkIndex, i, i });
+		editedChunks.back().end = i + 1;
+	}
+
+	// Each chunk is encoded once for all the clients asking for it, again only once it was written
+	toEncode.clear();
+	for (auto& client : clients)
+		for (int chunkIndex : client->sending)
+			if (encoded[chunkIndex].empty() || encodedVersions[chunkIndex] != world->chunks[chunkIndex]->GetVersion())
+				toEncode.push_back(chunkIndex);
+	std::sort(toEncode.begin(), toEncode.end());
+	toEncode.erase(std::unique(toEncode.begin(), toEncode.end()), toEncode.end());
+	auto encode = [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			const Chunk* chunk = world->chunks[toEncode[i]];
+			encoded[toEncode[i]].clear();
+			encodedVersions[toEncode[i]] = chunk->GetVersion();
+			NetWriter writer(encoded[toEncode[i]]);
+			EncodeChunkBlocks(chunk->data, writer);
+		}
+	};
+	if (jobs)
+		jobs->ParallelFor((int)toEncode.size(), CLIENTS_PER_JOB, encode);
+	else
+		encode(0, (int)toEncode.size());
+
+	forEachClient([&](RemoteClient& client) { SendUpdates(client); });
+	for (auto& client : clients) {
+		stats.chunksSent += client->sent.chunksSent;
+		stats.chunksUnloaded += client->sent.chunksUnloaded;
+		stats.deltaEdits += client->sent.deltaEdits;
+		stats.chunkBytes += client->sent.chunkBytes;
+		stats.bytesSent += client->sent.bytesSent;
+	}
+	edits.clear();
+	stats.tickMs = clock.MillisecondsSince(start);
+}
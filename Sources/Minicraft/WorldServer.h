@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Engine/JobSystem.h"
+#include "Engine/Transport.h"
+#include "Minicraft/World.h"
+#include "Minicraft/WorldEditBatch.h"
+
+// Counters of the last server tick, bytes and chunks summed over the clients
+struct ServerStats {
+	int clients = 0;
+	int chunksSent = 0;
+	int chunksUnloaded = 0;
+	int deltaEdits = 0;
+	uint64_t chunkBytes = 0; // encoded chunk payloads, out of chunksSent * 4096 raw
+	uint64_t bytesSent = 0;
+	double tickMs = 0;
+};
+
+// Streams the world to clients over any ITransport. Each client gets the chunk columns within its view radius,
+// nearest first and a few per tick, and forgets those a column beyond it. Block edits are collected between
+// ticks and sent as one delta message per client, for the chunks it holds. Chunk payloads are encoded once per
+// chunk version and shared by every client asking for them.
+class WorldServer : public IBlockListener {
+	struct RemoteClient {
+		std::unique_ptr<ITransport> transport;
+		int viewRadius = 0; // nothing is streamed before its hello
+		int cx = 0, cz = 0;
+		std::vector<bool> hasChunk;
+		std::vector<int> sending;
+		std::vector<int> unloading;
+		std::vector<uint8_t> message;
+		ServerStats sent;
+	};
+	struct ChunkEdits {
+		int chunkIndex;
+		int begin, end;
+	};
+
+	World* world;
+	std::vector<std::unique_ptr<RemoteClient>> clients;
+	std::vector<BlockEdit> edits; // since the last tick, in order
+	std::vector<ChunkEdits> editedChunks;
+	std::vector<std::vector<uint8_t>> encoded; // per chunk, empty until needed
+	std::vector<uint32_t> encodedVersions; // chunk version the payload was encoded from
+	std::vector<int> toEncode;
+	int chunksPerTick = 8;
+
+	void ReadMessages(RemoteClient& client);
+	// What enters and leaves the view of the client this tick
+	void SelectChunks(RemoteClient& client);
+	void SendUpdates(RemoteClient& client);
+public:
+	ServerStats stats;
+
+	explicit WorldServer(World* world);
+
+	// The server owns the transport, returns the client index
+	int AddClient(std::unique_ptr<ITransport> transport);
+	void DisconnectAll();
+	int GetClientCount() const { return (int)clients.size(); }
+	// Chunks sent per client and tick at most, bounds the bandwidth of a client arriving or teleporting
+	void SetChunksPerTick(int count) { chunksPerTick = count; }
+
+	// Reads the clients, then sends them chunks and the edits since the last tick, on the job system when given
+	void Tick(JobSystem* jobs);
+
+	void OnBlockChanged(int gx, int gy, int gz, BlockId block) override;
+};
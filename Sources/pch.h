@@ -41,7 +41,9 @@
 
 #include <algorithm>
 #include <atomic>
+#include <bitset>
 #include <cassert>
+#include <climits>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -55,10 +57,19 @@
 #include <string>
 #include <system_error>
 #include <tuple>
+#include <filesystem>
 #include <fstream>
 #include <vector>
 #include <map>
 #include <array>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <deque>
 
 #ifdef _DEBUG
 #include <dxgidebug.h>
@@ -4,6 +4,7 @@
 
 #include "pch.h"
 #include "Sources/Game.h"
+#include "Sources/Bench/Bench.h"
 
 #include <Dbt.h>
 
@@ -14,6 +15,27 @@ using namespace DirectX;
 namespace
 {
 	std::unique_ptr<Game> g_game;
+
+	// Finds "-name" on the command line and returns the word following it
+	bool GetArgument(LPCWSTR cmdLine, LPCWSTR name, std::wstring& value)
+	{
+		const wchar_t* found = wcsstr(cmdLine, name);
+		if (!found) return false;
+
+		const wchar_t* start = found + wcslen(name);
+		while (*start == L' ') start++;
+		const wchar_t* end = start;
+		while (*end && *end != L' ') end++;
+		value.assign(start, end);
+		return true;
+	}
+
+	void WriteReport(const char* path, const std::string& line)
+	{
+		std::string report = line + "\n";
+		OutputDebugStringA(report.c_str());
+		std::ofstream(path) << report;
+	}
 }
 
 LPCWSTR g_szAppName = L"Minicraft";
@@ -32,7 +54,6 @@ extern "C"
 int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPWSTR lpCmdLine, _In_ int nCmdShow)
 {
 	UNREFERENCED_PARAMETER(hPrevInstance);
-	UNREFERENCED_PARAMETER(lpCmdLine);
 
 	if (!XMVerifyCPUSupport())
 		return 1;
@@ -43,6 +64,61 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 
 	g_game = std::make_unique<Game>();
 
+	std::wstring argument;
+	if (GetArgument(lpCmdLine, L"-seed", argument))
+		g_game->SetWorldSeed(static_cast<uint32_t>(_wtoi(argument.c_str())));
+	if (GetArgument(lpCmdLine, L"-pipelined", argument))
+		g_game->SetPipelined(true);
+	// Streams the world in around the spawn instead of generating it all before the first frame
+	if (GetArgument(lpCmdLine, L"-progressive", argument))
+		g_game->SetProgressiveStartup(true);
+
+	// "-replay file" plays a recording back without window nor GPU, "-headless [ticks]" does the same with scripted input.
+	// Both write their frame stats next to the executable. "-headless <benchmark> [argument]", "-headless -bench-server 64"
+	// for instance, runs one of the benchmarks listed in Sources/Bench/Bench.cpp instead and writes its report.
+	const BenchEntry* bench = nullptr;
+	std::wstring benchArgument;
+	for (const BenchEntry& entry : GetBenchmarks()) {
+		if (GetArgument(lpCmdLine, entry.name, benchArgument)) {
+			bench = &entry;
+			break;
+		}
+	}
+	std::wstring replayPath;
+	const bool replay = GetArgument(lpCmdLine, L"-replay", replayPath);
+	if (replay || GetArgument(lpCmdLine, L"-headless", argument)) {
+		int exitCode = 0;
+		int w, h;
+		g_game->GetDefaultSize(w, h);
+
+		if (replay) {
+			InputRecording recording;
+			if (!recording.Load(replayPath))
+				return 1;
+			g_game->SetWorldSeed(recording.worldSeed);
+			g_game->InitializeHeadless(w, h);
+			g_game->RunReplay(recording);
+			WriteReport("minicraft_replay.txt", g_game->FormatStats());
+		} else if (bench) {
+			bool failed = false;
+			g_game->InitializeHeadless(w, h);
+			WriteReport(bench->reportPath, g_game->RunBenchmark(*bench, benchArgument, failed));
+			// Lets scripts run the benchmarks that check their results as tests
+			if (failed)
+				exitCode = 1;
+		} else {
+			int ticks = _wtoi(argument.c_str());
+			if (ticks <= 0) ticks = 1000;
+			g_game->InitializeHeadless(w, h);
+			g_game->RunHeadless(static_cast<uint32_t>(ticks));
+			WriteReport("minicraft_headless.txt", g_game->FormatStats());
+		}
+
+		g_game.reset();
+		CoUninitialize();
+		return exitCode;
+	}
+
 	// Register class and create window
 	{
 		// Register class
@@ -81,6 +157,9 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 		GetClientRect(hwnd, &rc);
 
 		g_game->Initialize(hwnd, rc.right - rc.left, rc.bottom - rc.top);
+
+		if (GetArgument(lpCmdLine, L"-record", argument))
+			g_game->StartRecording(argument);
 	}
 
 	// Main message loop